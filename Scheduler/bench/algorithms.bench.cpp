@@ -0,0 +1,275 @@
+#define EXTERN_C
+extern "C" {
+#include "../src/algorithms.h"
+}
+#undef EXTERN_C
+#include "../src/system_config.h"
+#include "../src/fit_kernels.h"
+#include "../src/stage_three.h"
+#include "../src/thread_pool.h"
+#include "../tst/random_fleet.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __GLIBC__
+// every allocation in the process goes through these, C and C++ alike, so they can be counted
+static size_t allocations = 0;
+
+extern "C" {
+	void *__libc_malloc(size_t size);
+	void *__libc_calloc(size_t count, size_t size);
+	void *__libc_realloc(void *ptr, size_t size);
+
+	void *malloc(size_t size) {
+		++allocations;
+		return __libc_malloc(size);
+	}
+
+	void *calloc(size_t count, size_t size) {
+		++allocations;
+		return __libc_calloc(count, size);
+	}
+
+	void *realloc(void *ptr, size_t size) {
+		++allocations;
+		return __libc_realloc(ptr, size);
+	}
+}
+#endif
+
+namespace {
+
+	// the types of config_simple1, which has a type for each power of two up to 8 cores
+	constexpr size_t numTypes = 4;
+	const char* typeNames[numTypes] = { "tiny", "small", "medium", "large" };
+	constexpr resource_info typeResc[numTypes] = {
+		resource_info{1, 1000, 4000},
+		resource_info{2, 4000, 16000},
+		resource_info{4, 16000, 64000},
+		resource_info{8, 32000, 256000}
+	};
+
+	constexpr intmax_t now = 1000;
+
+	/*
+	a fleet of `numServers` spread evenly over the types, in every state a real one goes through.
+	busy servers have `depth` jobs each, running until the server is full and waiting after that,
+	which is what the local model and `LSTJ` leave in the config between decisions
+	*/
+	system_config *makeFleet(size_t numServers, size_t depth) {
+		server_type types[numTypes];
+		for(size_t t = 0; t < numTypes; ++t) {
+			types[t] = server_type{ const_cast<char*>(typeNames[t]), numServers / numTypes, 60, 0.1f * (1 << t), typeResc[t] };
+		}
+		types[numTypes - 1].limit += numServers % numTypes;
+
+		system_config *config = create_config(types, numTypes);
+		Lcg lcg{ numServers * 31 + depth };
+
+		for(size_t s = 0; s < config->num_servers; ++s) {
+			server_info &server = config->servers[s];
+			uintmax_t roll = lcg.next(10);
+			const resource_info &max = server.type->max_resc;
+
+			if(roll < 3) {
+				server.avail_time = now + 60;
+				continue;
+			} else if(roll < 5 || depth == 0) {
+				server.state = SS_IDLE;
+				server.avail_time = now;
+				continue;
+			}
+
+			server.state = roll == 5 ? SS_BOOTING : SS_ACTIVE;
+			server.avail_time = server.state == SS_BOOTING ? now + 30 : -1;
+			server.jobs = static_cast<schd_info*>(malloc(sizeof(schd_info) * depth));
+			server.num_jobs = depth;
+
+			resource_info used{ 0, 0, 0 };
+			for(size_t j = 0; j < depth; ++j) {
+				resource_info req{ 1 + lcg.next(max.cores), 100 * (1 + lcg.next(max.memory / 100)), 100 * (1 + lcg.next(max.disk / 100)) };
+				bool starts = used + req <= max;
+				intmax_t start = server.state == SS_BOOTING ? server.avail_time : now - static_cast<intmax_t>(lcg.next(500));
+				server.jobs[j] = schd_info{ s * depth + j, starts ? start : -1, 1 + lcg.next(2000), req };
+				if(starts) used = used + req;
+			}
+			server.avail_resc = max - used;
+		}
+
+		// the fields were written directly, so the columns the algorithms scan need bringing up to date
+		for(size_t s = 0; s < config->num_servers; ++s) sync_server(&config->servers[s]);
+
+		return config;
+	}
+
+	// keeps the last fleet built, since a benchmark is run several times over and a big fleet takes a while
+	system_config *fleetFor(size_t numServers, size_t depth) {
+		static system_config *fleet = nullptr;
+		static size_t fleetServers = 0, fleetDepth = 0;
+
+		if(fleet == nullptr || fleetServers != numServers || fleetDepth != depth) {
+			if(fleet != nullptr) free_config(fleet);
+			fleet = makeFleet(numServers, depth);
+			fleetServers = numServers;
+			fleetDepth = depth;
+		}
+
+		return fleet;
+	}
+
+	// jobs of every size the fleet can run, all submitted now
+	constexpr size_t numJobs = 64;
+	job_info jobs[numJobs];
+
+	const bool jobsMade = [] {
+		Lcg lcg{ 7 };
+		for(size_t i = 0; i < numJobs; ++i) {
+			const resource_info &max = typeResc[lcg.next(numTypes)];
+			jobs[i] = job_info{ now, i, 1 + lcg.next(5000), resource_info{ 1 + lcg.next(max.cores), 100 * (1 + lcg.next(max.memory / 100)), 100 * (1 + lcg.next(max.disk / 100)) } };
+		}
+		return true;
+	}();
+
+	// one iteration is one decision, range(0) is the number of servers
+	template<algorithm_t Algorithm, size_t Depth>
+	void Decision(benchmark::State &state) {
+		system_config *config = fleetFor(static_cast<size_t>(state.range(0)), Depth);
+		size_t i = 0;
+
+#ifdef __GLIBC__
+		size_t allocationsBefore = allocations;
+#endif
+		for(auto _ : state) {
+			benchmark::DoNotOptimize(choose_server(config, jobs[i++ % numJobs], Algorithm));
+		}
+#ifdef __GLIBC__
+		state.counters["allocs/decision"] = benchmark::Counter(static_cast<double>(allocations - allocationsBefore), benchmark::Counter::kAvgIterations);
+#endif
+
+		state.SetItemsProcessed(state.iterations());
+		state.SetComplexityN(state.range(0));
+	}
+
+	// each family is one algorithm at one job-list depth, so its complexity is fitted against the number of servers alone
+#define DECISION_BENCHMARKS(ALGORITHM, DEPTH, MAX_SERVERS) \
+	BENCHMARK_TEMPLATE(Decision, ALGORITHM, DEPTH)->RangeMultiplier(10)->Range(10, MAX_SERVERS)->Complexity()
+
+	DECISION_BENCHMARKS(ALL_TO_LARGEST, 0, 1000000);
+	DECISION_BENCHMARKS(FIRST_FIT, 0, 1000000);
+	DECISION_BENCHMARKS(BEST_FIT, 0, 1000000);
+	DECISION_BENCHMARKS(WORST_FIT, 0, 1000000);
+	DECISION_BENCHMARKS(PREDICTIVE_FIT, 0, 1000000);
+
+	DECISION_BENCHMARKS(ALL_TO_LARGEST, 4, 1000000);
+	DECISION_BENCHMARKS(FIRST_FIT, 4, 1000000);
+	DECISION_BENCHMARKS(BEST_FIT, 4, 1000000);
+	DECISION_BENCHMARKS(WORST_FIT, 4, 1000000);
+	DECISION_BENCHMARKS(PREDICTIVE_FIT, 4, 1000000);
+
+	// one iteration checks one job against every server with fit_block, range(0) is the number of servers
+	void FitKernel(benchmark::State &state, const char *kernel) {
+		if(!fit_kernel_use(kernel)) {
+			state.SkipWithError("not supported on this CPU");
+			return;
+		}
+
+		system_config *config = fleetFor(static_cast<size_t>(state.range(0)), 4);
+		uint32_t fitness[FIT_BLOCK];
+		size_t i = 0;
+
+		for(auto _ : state) {
+			uint64_t found = 0;
+			for(size_t first = 0; first < config->num_servers; first += FIT_BLOCK) {
+				found += fit_block(&config->columns, first, std::min<size_t>(FIT_BLOCK, config->num_servers - first), &jobs[i % numJobs], fitness).mask;
+			}
+			benchmark::DoNotOptimize(found);
+			++i;
+		}
+
+		// put back the widest, which the other benchmarks use
+		fit_kernel_use("scalar");
+		fit_kernel_use("sse4.2");
+		fit_kernel_use("avx2");
+
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	BENCHMARK_CAPTURE(FitKernel, scalar, "scalar")->RangeMultiplier(10)->Range(10000, 1000000);
+	BENCHMARK_CAPTURE(FitKernel, sse42, "sse4.2")->RangeMultiplier(10)->Range(10000, 1000000);
+	BENCHMARK_CAPTURE(FitKernel, avx2, "avx2")->RangeMultiplier(10)->Range(10000, 1000000);
+
+	// deep queues on a million servers would need gigabytes just for the jobs
+	DECISION_BENCHMARKS(FIRST_FIT, 32, 100000);
+	DECISION_BENCHMARKS(BEST_FIT, 32, 100000);
+	DECISION_BENCHMARKS(WORST_FIT, 32, 100000);
+	DECISION_BENCHMARKS(PREDICTIVE_FIT, 32, 100000);
+
+	/*
+	predictive_fit searching 10000 servers 32 jobs deep on range(0) threads, the decision thread included.
+	every skyline is thrown away first, the worst case after a full refresh, so each decision simulates every busy server.
+	the time is wall clock, as the workers' time isn't the decision thread's
+	*/
+	void ParallelDecision(benchmark::State &state) {
+		system_config *config = fleetFor(10000, 32);
+		thread_pool *pool = state.range(0) > 1 ? thread_pool_create(static_cast<size_t>(state.range(0))) : nullptr;
+		config->context.workers = pool;
+		size_t i = 0;
+
+		for(auto _ : state) {
+			state.PauseTiming();
+			for(size_t s = 0; s < config->num_servers; ++s) skyline_invalidate(&config->servers[s]);
+			state.ResumeTiming();
+
+			benchmark::DoNotOptimize(predictive_fit(config, jobs[i++ % numJobs]));
+		}
+
+		config->context.workers = nullptr;
+		if(pool != nullptr) thread_pool_free(pool);
+		state.SetItemsProcessed(state.iterations());
+	}
+
+	BENCHMARK(ParallelDecision)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+	/*
+	one iteration predicts when a job needing a whole large server could start on one with range(0) jobs queued,
+	half of them running, which has the simulation finish every one of them.
+	the skyline is either kept between iterations, as it is between decisions while nothing changes, or rebuilt for each
+	*/
+	void Prediction(benchmark::State &state, const char *how) {
+		size_t depth = static_cast<size_t>(state.range(0));
+		server_type type{ const_cast<char*>(typeNames[numTypes - 1]), 1, 60, 0.8f, typeResc[numTypes - 1] };
+		server_info server{ &type, 0, SS_ACTIVE, -1, type.max_resc, static_cast<schd_info*>(malloc(sizeof(schd_info) * depth)), depth, 0, nullptr, nullptr };
+		Lcg lcg{ depth };
+
+		resource_info used{ 0, 0, 0 };
+		for(size_t j = 0; j < depth; ++j) {
+			resource_info req{ 1, 100 * (1 + lcg.next(20)), 100 * (1 + lcg.next(100)) };
+			bool starts = j < depth / 2 && used + req <= type.max_resc;
+			server.jobs[j] = schd_info{ j, starts ? now - static_cast<intmax_t>(lcg.next(500)) : -1, 1 + lcg.next(2000), req };
+			if(starts) used = used + req;
+		}
+		server.avail_resc = type.max_resc - used;
+
+		job_info job{ now, 0, 100, type.max_resc };
+		bool scan = !strcmp(how, "scan"), rebuilt = !strcmp(how, "rebuilt");
+		for(auto _ : state) {
+			if(scan) {
+				benchmark::DoNotOptimize(predict_availability_scan(&server, &job, now));
+			} else {
+				if(rebuilt) skyline_invalidate(&server);
+				benchmark::DoNotOptimize(predict_availability(&server, &job, now));
+			}
+		}
+
+		free(server.jobs);
+		skyline_release(&server);
+		state.SetItemsProcessed(state.iterations());
+		state.SetComplexityN(state.range(0));
+	}
+
+	BENCHMARK_CAPTURE(Prediction, scan, "scan")->RangeMultiplier(4)->Range(8, 2048)->Complexity();
+	BENCHMARK_CAPTURE(Prediction, rebuilt, "rebuilt")->RangeMultiplier(4)->Range(8, 2048)->Complexity();
+	BENCHMARK_CAPTURE(Prediction, kept, "kept")->RangeMultiplier(4)->Range(8, 2048)->Complexity();
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+#define EXTERN_C
+extern "C" {
+#include "../src/stringhelper.h"
+}
+#undef EXTERN_C
+#include "../src/protocol.h"
+#include <benchmark/benchmark.h>
+
+namespace {
+
+	// the first jobs sent by ds-server for config_simple1
+	constexpr const char* jobMessages[] = {
+		"JOBN 83 0 1566 1 200 300",
+		"JOBN 290 1 7 1 400 1200",
+		"JOBN 336 2 96 2 2100 2800",
+		"JOBN 443 3 282 2 500 1100",
+		"JOBN 728 4 1431 8 8000 15400",
+		"JOBN 867 5 133 1 800 1400",
+		"JOBN 870 6 65 1 900 200",
+		"JOBN 954 7 741 1 1000 900",
+		"JOBN 1042 8 477 1 800 1700",
+		"JOBN 1064 9 47267 8 6300 4100"
+	};
+	constexpr size_t numJobMessages = sizeof(jobMessages) / sizeof(*jobMessages);
+
+	constexpr const char* rescMessages[] = {
+		"tiny 0 3 -1 0 600 2800",
+		"small 1 0 396 2 4000 16000",
+		"medium 0 2 1042 4 16000 64000",
+		"large 2 1 1224 2 30900 245200"
+	};
+	constexpr size_t numRescMessages = sizeof(rescMessages) / sizeof(*rescMessages);
+
+	constexpr const char* lstjMessages[] = {
+		"2 2 396 154 2 2100 2800",
+		"5 1 -1 80 1 500 600",
+		"19 2 1164 47267 8 6300 4100",
+		"43 1 -1 1566 1 200 300"
+	};
+	constexpr size_t numLstjMessages = sizeof(lstjMessages) / sizeof(*lstjMessages);
+
+	void ParseJob(benchmark::State &state) {
+		job_info job;
+		parse_error error;
+		size_t i = 0;
+		for(auto _ : state) {
+			benchmark::DoNotOptimize(parse_job(jobMessages[i++ % numJobMessages], &job, &error));
+			benchmark::DoNotOptimize(job);
+		}
+		state.SetItemsProcessed(state.iterations());
+	}
+	BENCHMARK(ParseJob);
+
+#ifdef USE_PCRE2
+	void StrToJobRegex(benchmark::State &state) {
+		regex_info *regex = regex_init(JOB_REGEX);
+		size_t i = 0;
+		for(auto _ : state) {
+			benchmark::DoNotOptimize(strtojob(jobMessages[i++ % numJobMessages], regex));
+		}
+		state.SetItemsProcessed(state.iterations());
+		regex_free(regex);
+	}
+	BENCHMARK(StrToJobRegex);
+#endif
+
+	void ParseRescRow(benchmark::State &state) {
+		resc_row row;
+		parse_error error;
+		size_t i = 0;
+		for(auto _ : state) {
+			benchmark::DoNotOptimize(parse_resc_row(rescMessages[i++ % numRescMessages], &row, &error));
+			benchmark::DoNotOptimize(row);
+		}
+		state.SetItemsProcessed(state.iterations());
+	}
+	BENCHMARK(ParseRescRow);
+
+	void ParseLstjRow(benchmark::State &state) {
+		lstj_row row;
+		parse_error error;
+		size_t i = 0;
+		for(auto _ : state) {
+			benchmark::DoNotOptimize(parse_lstj_row(lstjMessages[i++ % numLstjMessages], &row, &error));
+			benchmark::DoNotOptimize(row);
+		}
+		state.SetItemsProcessed(state.iterations());
+	}
+	BENCHMARK(ParseLstjRow);
+}
@@ -0,0 +1,857 @@
+#include "emulator.h"
+#include "../src/resource_info.h"
+#include "../src/job_info.h"
+#include "../src/system_config.h"
+ASSERT_IS_POD(emulator_summary);
+
+#include <tinyxml.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+inline namespace {
+
+	/*
+	xorshift64*, seeded through splitmix64.
+	the standard distributions are allowed to differ between library implementations,
+	so the workload is drawn straight from this to make it the same everywhere.
+	*/
+	struct random_source {
+		uint64_t state;
+
+		explicit random_source(uint64_t seed) noexcept {
+			uint64_t z = seed + 0x9e3779b97f4a7c15ull;
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+			state = (z ^ (z >> 31)) | 1;
+		}
+
+		uint64_t next() noexcept {
+			state ^= state >> 12;
+			state ^= state << 25;
+			state ^= state >> 27;
+
+			return state * 0x2545f4914f6cdd1dull;
+		}
+
+		// uniform in [lo, hi]
+		uintmax_t between(uintmax_t lo, uintmax_t hi) noexcept {
+			return lo + next() % (hi - lo + 1);
+		}
+
+		// uniform in [0, 1)
+		double unit() noexcept {
+			return static_cast<double>(next() >> 11) / 9007199254740992.0;
+		}
+	};
+
+	struct emu_server_type {
+		std::string name;
+		uintmax_t limit;
+		uintmax_t boot_time;
+		double rate; // cost per hour
+		resource_info max_resc;
+	};
+
+	struct emu_job_type {
+		uintmax_t min_runtime;
+		uintmax_t max_runtime;
+		uintmax_t population; // relative frequency, out of the sum over every job type
+	};
+
+	// numbered as `LSTJ` reports them
+	enum emu_job_state {
+		JS_SUBMITTED, // sent to the client, but not scheduled yet
+		JS_WAITING,
+		JS_RUNNING,
+		JS_COMPLETED
+	};
+
+	struct emu_job {
+		job_info info; // exactly what the client is sent
+		uintmax_t actual_runtime; // what the job really takes, which the client never sees
+		emu_job_state state;
+		intmax_t start_time; // -1 until started, or reserved on a booting server
+		intmax_t end_time;
+		size_t server;
+	};
+
+	struct emu_server {
+		size_t type;
+		size_t id;
+		server_state state;
+		intmax_t boot_start;
+		intmax_t boot_end;
+		resource_info used; // taken by running jobs, or reserved by jobs starting once booted
+		std::vector<size_t> jobs; // unfinished jobs, in the order they were scheduled
+		size_t running;
+		intmax_t busy_since; // when `running` last went from zero to one
+		intmax_t busy_time; // total time with at least one job running
+		intmax_t last_end; // when the last job to finish did so
+	};
+
+	// a server finishing booting when `job` is npos, otherwise a job completing
+	struct emu_event {
+		intmax_t time;
+		uint64_t seq; // ties are broken in the order the events were created
+		size_t server;
+		size_t job;
+
+		bool operator>(const emu_event &other) const noexcept {
+			return time != other.time ? time > other.time : seq > other.seq;
+		}
+	};
+
+	constexpr size_t no_job = std::numeric_limits<size_t>::max();
+
+	bool elem_name_is(const TiXmlElement *elem, const char *name) noexcept {
+		return elem != nullptr && !strcmp(elem->Value(), name);
+	}
+
+	bool get_unsigned_int_attribute(const TiXmlElement *node, const char *attr_name, uintmax_t *dest_ptr) noexcept {
+
+		if(node->QueryValueAttribute(attr_name, dest_ptr) != TIXML_SUCCESS) {
+			std::cerr << "Emulator: bad '" << node->Value() << "' element: must have unsigned integer attribute '" << attr_name << "'\n";
+
+			return false;
+
+		} else return true;
+	}
+
+	// the first word of a command, and a pointer to whatever follows it
+	bool command_is(const char *msg, const char *command, const char **args) noexcept {
+		size_t len = strlen(command);
+
+		if(strncmp(msg, command, len) || (msg[len] != ' ' && msg[len] != '\0')) return false;
+
+		*args = msg[len] == ' ' ? msg + len + 1 : msg + len;
+
+		return true;
+	}
+
+	// reads an unsigned integer and the space after it, if there is one
+	bool next_unsigned(const char **args, uintmax_t *dest) noexcept {
+		char *end;
+
+		if(**args < '0' || **args > '9') return false;
+
+		*dest = strtoumax(*args, &end, 10);
+
+		if(*end != ' ' && *end != '\0') return false;
+
+		*args = *end == ' ' ? end + 1 : end;
+
+		return true;
+	}
+
+	// reads a word and the space after it, if there is one
+	bool next_word(const char **args, std::string *dest) noexcept {
+		const char *end = strchrnul(*args, ' ');
+
+		if(end == *args) return false;
+
+		dest->assign(*args, end);
+		*args = *end == ' ' ? end + 1 : end;
+
+		return true;
+	}
+}
+
+struct emulator {
+	std::vector<emu_server_type> types;
+	std::vector<size_t> type_offsets; // index of each type's first server
+	std::vector<emu_job> jobs; // in submission order, ids are indices
+	bool newline;
+	FILE *log; // the client's messages are written here when it isn't null
+
+	// everything below is reset at the start of every session
+	std::vector<emu_server> servers;
+	std::priority_queue<emu_event, std::vector<emu_event>, std::greater<emu_event>> events;
+	uint64_t next_seq;
+	intmax_t now;
+	size_t next_job; // the next job REDY will send
+	emulator_summary summary;
+
+	std::thread session; // started by emulator_connect
+	bool session_quit;
+
+	bool parse(const char *path);
+	void generate(uint64_t seed, uintmax_t min_load, uintmax_t max_load, uintmax_t end_time, uintmax_t job_count, const std::vector<emu_job_type> &job_types);
+	void reset();
+	bool serve(socket_client *conn);
+
+	// the simulation itself
+	void push_event(intmax_t time, size_t server, size_t job);
+	void advance(intmax_t time);
+	void start_job(emu_server &server, size_t job, intmax_t time);
+	void start_waiting_jobs(emu_server &server, intmax_t time);
+	void finish();
+
+	// handlers for each command, each sending the whole response
+	void redy(socket_client *conn);
+	void resc(socket_client *conn, const char *args);
+	void lstj(socket_client *conn, const char *args);
+	void schd(socket_client *conn, const char *args);
+	bool write_system_xml() const;
+
+	// formatting for the rows of `RESC` and `LSTJ`
+	void format_server(const emu_server &server, std::string &row) const;
+	void format_job(const emu_job &job, std::string &row) const;
+	template<typename F> bool send_listing(socket_client *conn, size_t count, F format) const;
+};
+
+bool emulator::parse(const char *path) {
+	TiXmlDocument doc;
+	if(!doc.LoadFile(path)) {
+		std::cerr << "Emulator: unable to load '" << path << "'\n";
+
+		return false;
+	}
+
+	TiXmlElement *root = doc.RootElement();
+	if(!elem_name_is(root, "config")) {
+		std::cerr << "Emulator: '" << path << "' is not a ds-sim config\n";
+
+		return false;
+	}
+
+	uintmax_t seed = 0, min_load = 0, max_load = 100, end_time = std::numeric_limits<uintmax_t>::max(), job_count = std::numeric_limits<uintmax_t>::max();
+	std::vector<emu_job_type> job_types;
+
+	root->QueryValueAttribute("randomSeed", &seed);
+	const char *newline_attr = root->Attribute("newline");
+	newline = newline_attr != nullptr && !strcmp(newline_attr, "true");
+
+	for(TiXmlElement *section = root->FirstChildElement(); section != nullptr; section = section->NextSiblingElement()) {
+
+		if(elem_name_is(section, "servers")) {
+			for(TiXmlElement *node = section->FirstChildElement(); node != nullptr; node = node->NextSiblingElement()) {
+				emu_server_type type;
+				const char *name = node->Attribute("type");
+
+				if(!elem_name_is(node, "server") || name == nullptr) continue;
+
+				type.name = name;
+				if(!get_unsigned_int_attribute(node, "limit", &type.limit)) return false;
+				if(!get_unsigned_int_attribute(node, "bootupTime", &type.boot_time)) return false;
+				if(!get_unsigned_int_attribute(node, "coreCount", &type.max_resc.cores)) return false;
+				if(!get_unsigned_int_attribute(node, "memory", &type.max_resc.memory)) return false;
+				if(!get_unsigned_int_attribute(node, "disk", &type.max_resc.disk)) return false;
+				if(node->QueryDoubleAttribute("hourlyRate", &type.rate) != TIXML_SUCCESS) type.rate = 0;
+
+				types.push_back(type);
+			}
+
+		} else if(elem_name_is(section, "jobs")) {
+			for(TiXmlElement *node = section->FirstChildElement(); node != nullptr; node = node->NextSiblingElement()) {
+				emu_job_type type;
+
+				if(!elem_name_is(node, "job")) continue;
+
+				if(!get_unsigned_int_attribute(node, "minRunTime", &type.min_runtime)) return false;
+				if(!get_unsigned_int_attribute(node, "maxRunTime", &type.max_runtime)) return false;
+				if(!get_unsigned_int_attribute(node, "populationRate", &type.population)) return false;
+
+				if(type.min_runtime == 0 || type.max_runtime < type.min_runtime) {
+					std::cerr << "Emulator: bad 'job' element: need 1 <= minRunTime <= maxRunTime\n";
+
+					return false;
+				}
+
+				job_types.push_back(type);
+			}
+
+		} else if(elem_name_is(section, "workload")) {
+			section->QueryValueAttribute("minLoad", &min_load);
+			section->QueryValueAttribute("maxLoad", &max_load);
+
+		} else if(elem_name_is(section, "termination")) {
+			for(TiXmlElement *node = section->FirstChildElement(); node != nullptr; node = node->NextSiblingElement()) {
+				const char *type = node->Attribute("type");
+
+				if(!elem_name_is(node, "condition") || type == nullptr) continue;
+
+				if(!strcmp(type, "endtime") && !get_unsigned_int_attribute(node, "value", &end_time)) return false;
+				if(!strcmp(type, "jobcount") && !get_unsigned_int_attribute(node, "value", &job_count)) return false;
+			}
+		}
+	}
+
+	uintmax_t total_population = 0;
+	for(const auto &type : job_types) total_population += type.population;
+
+	if(types.empty() || total_population == 0) {
+		std::cerr << "Emulator: a config needs at least one server type and one job type\n";
+
+		return false;
+	}
+
+	if(min_load == 0 || max_load < min_load) {
+		std::cerr << "Emulator: bad 'workload' element: need 1 <= minLoad <= maxLoad\n";
+
+		return false;
+	}
+
+	if(end_time == std::numeric_limits<uintmax_t>::max() && job_count == std::numeric_limits<uintmax_t>::max()) {
+		std::cerr << "Emulator: a config needs an endtime or jobcount termination condition\n";
+
+		return false;
+	}
+
+	type_offsets.push_back(0);
+	for(const auto &type : types) type_offsets.push_back(type_offsets.back() + type.limit);
+
+	generate(seed, min_load, max_load, end_time, job_count, job_types);
+
+	return true;
+}
+
+void emulator::generate(uint64_t seed, uintmax_t min_load, uintmax_t max_load, uintmax_t end_time, uintmax_t job_count, const std::vector<emu_job_type> &job_types) {
+	random_source random(seed);
+
+	uintmax_t total_population = 0, total_cores = 0;
+	for(const auto &type : job_types) total_population += type.population;
+	for(const auto &type : types) total_cores += type.limit * type.max_resc.cores;
+
+	uintmax_t time = 0;
+
+	for(uintmax_t id = 0; id < job_count; ++id) {
+		// runtimes come from a job type chosen by population rate
+		uintmax_t pick = random.between(1, total_population);
+		auto job_type = job_types.begin();
+		while(pick > job_type->population) pick -= (job_type++)->population;
+
+		uintmax_t est_runtime = random.between(job_type->min_runtime, job_type->max_runtime);
+		uintmax_t actual_runtime = std::max<uintmax_t>(1, est_runtime / 2 + random.between(0, est_runtime));
+
+		// resources are sized against a server type chosen uniformly, so every job fits somewhere
+		const auto &server_type = types[random.between(0, types.size() - 1)];
+		resource_info req;
+		req.cores = random.between(1, std::max<uintmax_t>(1, server_type.max_resc.cores));
+		req.memory = std::min(server_type.max_resc.memory, req.cores * 100 * random.between(1, 10));
+		req.disk = std::min(server_type.max_resc.disk, req.cores * 100 * random.between(1, 10));
+
+		// arrivals are exponential, with a mean gap that keeps the load on every core in the system near the target
+		double load = static_cast<double>(random.between(min_load, max_load)) / 100.0;
+		double mean_gap = static_cast<double>(req.cores * actual_runtime) / (load * static_cast<double>(std::max<uintmax_t>(1, total_cores)));
+		time += static_cast<uintmax_t>(std::llround(-std::log(1.0 - random.unit()) * mean_gap));
+
+		if(time > end_time) break;
+
+		jobs.push_back(emu_job{ job_info{ time, id, est_runtime, req }, actual_runtime, JS_SUBMITTED, -1, -1, 0 });
+	}
+}
+
+void emulator::reset() {
+	servers.clear();
+	servers.reserve(type_offsets.back());
+
+	for(size_t t = 0; t < types.size(); ++t) {
+		for(size_t id = 0; id < types[t].limit; ++id) {
+			servers.push_back(emu_server{ t, id, SS_INACTIVE, -1, -1, resource_info{ 0, 0, 0 }, std::vector<size_t>(), 0, 0, 0, -1 });
+		}
+	}
+
+	for(auto &job : jobs) {
+		job.state = JS_SUBMITTED;
+		job.start_time = job.end_time = -1;
+	}
+
+	events = decltype(events)();
+	next_seq = 0;
+	now = 0;
+	next_job = 0;
+	summary = emulator_summary{ 0, 0, 0, 0, 0, 0, 0 };
+}
+
+void emulator::push_event(intmax_t time, size_t server, size_t job) {
+	events.push(emu_event{ time, next_seq++, server, job });
+}
+
+void emulator::start_job(emu_server &server, size_t j, intmax_t time) {
+	auto &job = jobs[j];
+
+	job.state = JS_RUNNING;
+	job.start_time = time;
+	server.used = server.used + job.info.req_resc;
+
+	if(server.running++ == 0) server.busy_since = time;
+	server.state = SS_ACTIVE;
+
+	push_event(time + static_cast<intmax_t>(job.actual_runtime), static_cast<size_t>(&server - servers.data()), j);
+}
+
+// the same rule the client models: every waiting job that fits, in the order they were scheduled
+void emulator::start_waiting_jobs(emu_server &server, intmax_t time) {
+
+	for(auto j : server.jobs) {
+		if(jobs[j].state == JS_WAITING && server.used + jobs[j].info.req_resc <= types[server.type].max_resc) start_job(server, j, time);
+	}
+}
+
+void emulator::advance(intmax_t time) {
+
+	while(!events.empty() && events.top().time <= time) {
+		emu_event event = events.top();
+		events.pop();
+
+		now = event.time;
+		auto &server = servers[event.server];
+
+		if(event.job == no_job) {
+			// reservations made while booting are recalculated from scratch, which gives the same jobs
+			server.state = SS_IDLE;
+			server.used = resource_info{ 0, 0, 0 };
+			for(auto j : server.jobs) jobs[j].start_time = -1;
+
+		} else {
+			auto &job = jobs[event.job];
+
+			job.state = JS_COMPLETED;
+			job.end_time = now;
+			server.used = server.used - job.info.req_resc;
+			server.jobs.erase(std::find(server.jobs.begin(), server.jobs.end(), event.job));
+			server.last_end = now;
+
+			if(--server.running == 0) {
+				server.busy_time += now - server.busy_since;
+				server.state = SS_IDLE;
+			}
+		}
+
+		start_waiting_jobs(server, now);
+	}
+
+	now = std::max(now, time);
+}
+
+void emulator::finish() {
+	advance(std::numeric_limits<intmax_t>::max());
+
+	double waiting = 0, exec = 0, turnaround = 0, utilisation = 0;
+
+	for(const auto &job : jobs) {
+		if(job.state != JS_COMPLETED) continue;
+
+		summary.jobs_scheduled++;
+		waiting += job.start_time - static_cast<intmax_t>(job.info.submit_time);
+		exec += job.end_time - job.start_time;
+		turnaround += job.end_time - static_cast<intmax_t>(job.info.submit_time);
+	}
+
+	for(const auto &server : servers) {
+		if(server.state == SS_INACTIVE) continue;
+
+		intmax_t uptime = std::max<intmax_t>(1, server.last_end - server.boot_start);
+
+		summary.servers_used++;
+		summary.total_cost += types[server.type].rate * static_cast<double>(uptime) / 3600.0;
+		utilisation += 100.0 * static_cast<double>(server.busy_time) / static_cast<double>(uptime);
+	}
+
+	if(summary.jobs_scheduled > 0) {
+		summary.avg_waiting_time = waiting / summary.jobs_scheduled;
+		summary.avg_exec_time = exec / summary.jobs_scheduled;
+		summary.avg_turnaround_time = turnaround / summary.jobs_scheduled;
+	}
+
+	if(summary.servers_used > 0) summary.avg_utilisation = utilisation / summary.servers_used;
+}
+
+void emulator::format_server(const emu_server &server, std::string &row) const {
+	const auto &type = types[server.type];
+	intmax_t avail_time;
+	char buffer[128];
+
+	// as ds-server reports it: when an inactive server would be up if booted now, or now for an idle one
+	switch(server.state) {
+		case SS_INACTIVE: avail_time = now + static_cast<intmax_t>(type.boot_time); break;
+		case SS_IDLE: avail_time = now; break;
+		default: avail_time = -1;
+	}
+
+	resource_info avail = type.max_resc - server.used;
+
+	snprintf(buffer, sizeof buffer, " %zu %d %jd %ju %ju %ju", server.id, static_cast<int>(server.state), avail_time, avail.cores, avail.memory, avail.disk);
+	row.assign(type.name).append(buffer);
+}
+
+void emulator::format_job(const emu_job &job, std::string &row) const {
+	char buffer[160];
+
+	snprintf(buffer, sizeof buffer, "%ju %d %jd %ju %ju %ju %ju", job.info.id, static_cast<int>(job.state), job.start_time, job.info.est_runtime, job.info.req_resc.cores, job.info.req_resc.memory, job.info.req_resc.disk);
+	row.assign(buffer);
+}
+
+/*
+sends "DATA", then one row per "OK", then "." for the final "OK".
+anything other than "OK" abandons the listing with an error, as the rest of it can't be sent
+*/
+template<typename F>
+bool emulator::send_listing(socket_client *conn, size_t count, F format) const {
+	std::string row;
+
+	client_send(conn, "DATA");
+
+	for(size_t i = 0; i <= count; ++i) {
+		const char *msg = client_try_receive(conn);
+
+		if(msg == nullptr) return false;
+
+		if(strcmp(msg, "OK")) {
+			client_send(conn, "ERR: expected OK during a listing");
+
+			return true;
+		}
+
+		if(i == count) break;
+
+		format(i, row);
+		client_send(conn, row.c_str());
+	}
+
+	client_send(conn, ".");
+
+	return true;
+}
+
+void emulator::redy(socket_client *conn) {
+
+	if(next_job == jobs.size()) {
+		client_send(conn, "NONE");
+
+		return;
+	}
+
+	const auto &job = jobs[next_job++].info;
+	char buffer[160];
+
+	advance(static_cast<intmax_t>(job.submit_time));
+
+	snprintf(buffer, sizeof buffer, "JOBN %ju %ju %ju %ju %ju %ju", job.submit_time, job.id, job.est_runtime, job.req_resc.cores, job.req_resc.memory, job.req_resc.disk);
+	client_send(conn, buffer);
+}
+
+void emulator::resc(socket_client *conn, const char *args) {
+	std::vector<size_t> selected;
+	const char *rest;
+	std::string name;
+	resource_info req;
+
+	if(command_is(args, "All", &rest) && *rest == '\0') {
+		send_listing(conn, servers.size(), [this](size_t i, std::string &row) { format_server(servers[i], row); });
+
+		return;
+
+	} else if(command_is(args, "Type", &rest) && next_word(&rest, &name) && *rest == '\0') {
+		for(size_t t = 0; t < types.size(); ++t) {
+			if(types[t].name != name) continue;
+
+			send_listing(conn, types[t].limit, [this, t](size_t i, std::string &row) { format_server(servers[type_offsets[t] + i], row); });
+
+			return;
+		}
+
+		send_listing(conn, 0, [](size_t, std::string&) {});
+
+		return;
+
+	} else if(command_is(args, "Avail", &rest) && next_unsigned(&rest, &req.cores) && next_unsigned(&rest, &req.memory) && next_unsigned(&rest, &req.disk) && *rest == '\0') {
+		for(size_t s = 0; s < servers.size(); ++s) {
+			if(servers[s].state != SS_UNAVAILABLE && types[servers[s].type].max_resc - servers[s].used >= req) selected.push_back(s);
+		}
+
+		send_listing(conn, selected.size(), [this, &selected](size_t i, std::string &row) { format_server(servers[selected[i]], row); });
+
+		return;
+	}
+
+	client_send(conn, "ERR: invalid resource query");
+}
+
+void emulator::lstj(socket_client *conn, const char *args) {
+	std::string name;
+	uintmax_t id;
+
+	if(next_word(&args, &name) && next_unsigned(&args, &id) && *args == '\0') {
+		for(size_t t = 0; t < types.size(); ++t) {
+			if(types[t].name != name || id >= types[t].limit) continue;
+
+			const auto &listed = servers[type_offsets[t] + id].jobs;
+
+			send_listing(conn, listed.size(), [this, &listed](size_t i, std::string &row) { format_job(jobs[listed[i]], row); });
+
+			return;
+		}
+	}
+
+	client_send(conn, "ERR: invalid job listing query");
+}
+
+void emulator::schd(socket_client *conn, const char *args) {
+	std::string name;
+	uintmax_t job_id, server_id;
+
+	if(!next_unsigned(&args, &job_id) || !next_word(&args, &name) || !next_unsigned(&args, &server_id) || *args != '\0') {
+		client_send(conn, "ERR: invalid scheduling request");
+
+		return;
+	}
+
+	if(job_id >= next_job || jobs[job_id].state != JS_SUBMITTED) {
+		client_send(conn, "ERR: No such waiting job exists");
+
+		return;
+	}
+
+	size_t t = 0;
+	while(t < types.size() && types[t].name != name) ++t;
+
+	if(t == types.size() || server_id >= types[t].limit) {
+		client_send(conn, "ERR: No such server exists");
+
+		return;
+	}
+
+	auto &job = jobs[job_id];
+	auto &server = servers[type_offsets[t] + server_id];
+	const auto &max_resc = types[t].max_resc;
+
+	if(!job.info.can_run(max_resc)) {
+		client_send(conn, "ERR: Server incapable of running such a job");
+
+		return;
+	}
+
+	if(server.state == SS_INACTIVE) {
+		server.state = SS_BOOTING;
+		server.boot_start = now;
+		server.boot_end = now + static_cast<intmax_t>(types[t].boot_time);
+		push_event(server.boot_end, type_offsets[t] + server_id, no_job);
+	}
+
+	job.state = JS_WAITING;
+	job.server = type_offsets[t] + server_id;
+	server.jobs.push_back(job_id);
+
+	// a booting server reserves resources for the jobs it will start as soon as it's up
+	if(server.state == SS_BOOTING && server.used + job.info.req_resc <= max_resc) {
+		job.start_time = server.boot_end;
+		server.used = server.used + job.info.req_resc;
+
+	} else if(server.state != SS_BOOTING && server.used + job.info.req_resc <= max_resc) {
+		start_job(server, job_id, now);
+	}
+
+	client_send(conn, "OK");
+}
+
+bool emulator::write_system_xml() const {
+	FILE *file = fopen("system.xml", "w");
+	if(file == nullptr) return false;
+
+	fprintf(file, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<system>\n\t<servers>\n");
+
+	for(const auto &type : types) {
+		fprintf(file, "\t\t<server type=\"%s\" limit=\"%ju\" bootupTime=\"%ju\" rate=\"%.2f\" coreCount=\"%ju\" memory=\"%ju\" disk=\"%ju\" />\n",
+			type.name.c_str(), type.limit, type.boot_time, type.rate, type.max_resc.cores, type.max_resc.memory, type.max_resc.disk);
+	}
+
+	fprintf(file, "\t</servers>\n</system>\n");
+
+	return fclose(file) == 0;
+}
+
+bool emulator::serve(socket_client *conn) {
+	const char *msg, *args;
+
+	reset();
+
+	while((msg = client_try_receive(conn)) != nullptr) {
+
+		if(log != nullptr) fprintf(log, "%s\n", msg);
+
+		if(command_is(msg, "HELO", &args)) client_send(conn, "OK");
+
+		else if(command_is(msg, "AUTH", &args)) {
+			// the client reads the servers from here, just as it would from ds-server
+			if(!write_system_xml()) std::cerr << "Emulator: unable to write system.xml\n";
+			client_send(conn, "OK");
+
+		} else if(command_is(msg, "REDY", &args)) redy(conn);
+
+		else if(command_is(msg, "RESC", &args)) resc(conn, args);
+
+		else if(command_is(msg, "LSTJ", &args)) lstj(conn, args);
+
+		else if(command_is(msg, "SCHD", &args)) schd(conn, args);
+
+		else if(command_is(msg, "QUIT", &args)) {
+			finish();
+			client_send(conn, "QUIT");
+
+			return true;
+
+		} else {
+			std::string error("ERR: invalid command (");
+			client_send(conn, error.append(msg).append(")").c_str());
+		}
+	}
+
+	return false;
+}
+
+emulator *emulator_create(const char *config_path) noexcept {
+	try {
+		emulator *emu = new emulator();
+
+		if(emu->parse(config_path)) {
+			emu->reset();
+
+			return emu;
+		}
+
+		delete emu;
+
+	} catch(...) {}
+
+	return nullptr;
+}
+
+size_t emulator_num_jobs(const emulator *emu) noexcept {
+	return emu->jobs.size();
+}
+
+bool emulator_newline(const emulator *emu) noexcept {
+	return emu->newline;
+}
+
+void emulator_log(emulator *emu, FILE *log) noexcept {
+	emu->log = log;
+}
+
+bool emulator_serve(emulator *emu, int fd) noexcept {
+	socket_client *conn = client_from_fd(fd, emu->newline);
+	bool quit;
+
+	try {
+		quit = emu->serve(conn);
+
+	} catch(...) {
+		quit = false;
+	}
+
+	client_free(conn);
+
+	return quit;
+}
+
+bool emulator_listen(emulator *emu, int port) noexcept {
+	sockaddr_in address;
+	int enable = 1;
+	int listener = socket(AF_INET, SOCK_STREAM, 0);
+
+	memset(&address, 0, sizeof address);
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	inet_pton(AF_INET, LOCALHOST, &address.sin_addr);
+
+	setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof enable);
+
+	if(bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof address) < 0 || listen(listener, 1) < 0) {
+		std::cerr << "Emulator: unable to listen on port " << port << "\n";
+		close(listener);
+
+		return false;
+	}
+
+	int fd = accept(listener, nullptr, nullptr);
+	close(listener);
+
+	return fd >= 0 && emulator_serve(emu, fd);
+}
+
+socket_client *emulator_connect(emulator *emu) noexcept {
+	int fds[2];
+
+	if(emu->session.joinable() || socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) return nullptr;
+
+	try {
+		int fd = fds[1];
+		emu->session = std::thread([emu, fd]() { emu->session_quit = emulator_serve(emu, fd); });
+
+	} catch(...) {
+		close(fds[0]);
+		close(fds[1]);
+
+		return nullptr;
+	}
+
+	socket_client *client = client_from_fd(fds[0], emu->newline);
+
+	if(!client_msg_resp(client, "HELO", "OK") || !client_msg_resp(client, "AUTH comp335", "OK")) {
+		client_free(client);
+		emulator_wait(emu);
+
+		return nullptr;
+	}
+
+	return client;
+}
+
+bool emulator_wait(emulator *emu) noexcept {
+
+	if(!emu->session.joinable()) return false;
+
+	emu->session.join();
+
+	return emu->session_quit;
+}
+
+emulator_summary emulator_get_summary(const emulator *emu) noexcept {
+	return emu->summary;
+}
+
+void emulator_print_summary(const emulator *emu, FILE *out) noexcept {
+	const auto &summary = emu->summary;
+
+	fprintf(out, "# ---------------------------------------------------------------------------\n");
+
+	for(size_t t = 0; t < emu->types.size(); ++t) {
+		size_t used = 0;
+		double utilisation = 0, cost = 0;
+
+		for(size_t s = emu->type_offsets[t]; s < emu->type_offsets[t + 1]; ++s) {
+			const auto &server = emu->servers[s];
+			if(server.state == SS_INACTIVE) continue;
+
+			intmax_t uptime = std::max<intmax_t>(1, server.last_end - server.boot_start);
+			used++;
+			utilisation += 100.0 * static_cast<double>(server.busy_time) / static_cast<double>(uptime);
+			cost += emu->types[t].rate * static_cast<double>(uptime) / 3600.0;
+		}
+
+		fprintf(out, "# %zu %s servers used with a utilisation of %.2f at the cost of $%.2f\n", used, emu->types[t].name.c_str(), used > 0 ? utilisation / used : 0.0, cost);
+	}
+
+	fprintf(out, "# =============================== [ Overall ] ===============================\n");
+	fprintf(out, "# total #servers used: %zu, avg utilisation: %.2f and total cost: $%.2f\n", summary.servers_used, summary.avg_utilisation, summary.total_cost);
+	fprintf(out, "# avg waiting time: %.0f, avg exec time: %.0f and avg turnaround time: %.0f\n", summary.avg_waiting_time, summary.avg_exec_time, summary.avg_turnaround_time);
+}
+
+void emulator_free(emulator *emu) noexcept {
+	emulator_wait(emu);
+
+	delete emu;
+}
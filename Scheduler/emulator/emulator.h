@@ -0,0 +1,89 @@
+#pragma once
+#ifndef emulator_h_
+#define emulator_h_
+
+#ifdef __cplusplus
+#ifndef EXTERN_C
+#define EXTERN_C
+#define EXTERN_C_emulator_h_
+extern "C" {
+#endif
+#else
+#define noexcept
+#include <stdbool.h>
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "../src/socket_client.h"
+
+/*
+an in-process stand-in for ds-server, built from the same ds-sim config files.
+the workload is generated up front from the config's random seed, so every session
+on the same emulator sees exactly the same jobs, and a session replays the server's
+side of the protocol: HELO, AUTH (which writes system.xml), REDY, RESC, LSTJ, SCHD and QUIT.
+servers boot, jobs wait, run for their actual runtime (which differs from the estimate
+the client is given) and complete, all in simulated time, so nothing ever sleeps.
+*/
+typedef struct emulator emulator;
+
+// totals for the last finished session, in the same terms as ds-server's closing report
+typedef struct emulator_summary {
+	size_t jobs_scheduled; // number of jobs the client scheduled
+	size_t servers_used; // number of servers that were booted
+	double total_cost; // sum over used servers of hourly rate by time from boot to last completion
+	double avg_utilisation; // mean over used servers of the percentage of that time spent running jobs
+	double avg_waiting_time; // mean of start time minus submit time
+	double avg_exec_time; // mean of actual runtime
+	double avg_turnaround_time; // mean of completion time minus submit time
+} emulator_summary;
+
+// parses a ds-sim config and generates its workload, returning nullptr and logging to stderr on failure
+emulator *emulator_create(const char *config_path) noexcept;
+
+// the number of jobs in the generated workload
+size_t emulator_num_jobs(const emulator *emu) noexcept;
+
+// whether the config asks for newline-terminated messages
+bool emulator_newline(const emulator *emu) noexcept;
+
+// writes every message the client sends from the next session on to `log`, one per line, or stops if it's null
+void emulator_log(emulator *emu, FILE *log) noexcept;
+
+// serves one session on a connected socket until the client quits or disconnects, returning true if it quit
+bool emulator_serve(emulator *emu, int fd) noexcept;
+
+// accepts one connection on localhost:port and serves it, returning true if the client quit
+bool emulator_listen(emulator *emu, int port) noexcept;
+
+/*
+starts a session on a background thread over a socketpair, and returns a client
+already past HELO and AUTH, exactly as client_init would leave it.
+the caller must call emulator_wait after sending QUIT, then client_free
+*/
+socket_client *emulator_connect(emulator *emu) noexcept;
+
+// waits for the session started by emulator_connect to finish, returning true if the client quit
+bool emulator_wait(emulator *emu) noexcept;
+
+// the totals for the last finished session
+emulator_summary emulator_get_summary(const emulator *emu) noexcept;
+
+// writes the totals for the last finished session in the same format as ds-server
+void emulator_print_summary(const emulator *emu, FILE *out) noexcept;
+
+// waits for any session still running, then frees everything
+void emulator_free(emulator *emu) noexcept;
+
+#ifdef __cplusplus
+#ifdef EXTERN_C_emulator_h_
+}
+#undef EXTERN_C_emulator_h_
+#undef EXTERN_C
+#endif
+#else
+#undef noexcept
+#endif
+
+#endif
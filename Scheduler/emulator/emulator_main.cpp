@@ -0,0 +1,42 @@
+#include "emulator.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+inline namespace {
+
+	void usage(const char *name) {
+		printf("%s%s\n", name, " -c CONFIG [-p PORT] [-v]");
+		exit(1);
+	}
+}
+
+// serves one client on localhost like `ds-server -c CONFIG`, then prints the same closing report
+int main(int argc, char **argv) {
+	const char *config_path = nullptr;
+	int port = DEFAULT_PORT;
+	bool verbose = false;
+
+	for(int i = 1; i < argc; ++i) {
+		if(!strcmp(argv[i], "-c") && i + 1 < argc) config_path = argv[++i];
+		else if(!strcmp(argv[i], "-p") && i + 1 < argc) port = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "-v")) verbose = true;
+		else usage(argv[0]);
+	}
+
+	if(config_path == nullptr) usage(argv[0]);
+
+	emulator *emu = emulator_create(config_path);
+	if(emu == nullptr) return 1;
+	if(verbose) emulator_log(emu, stderr);
+
+	bool quit = emulator_listen(emu, port);
+
+	if(quit) emulator_print_summary(emu, stdout);
+	else fprintf(stderr, "Client disconnected without sending QUIT\n");
+
+	emulator_free(emu);
+
+	return quit ? 0 : 1;
+}
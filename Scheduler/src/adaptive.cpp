@@ -0,0 +1,140 @@
+#include "adaptive.h"
+#include "arrivals.h"
+#include "cpp_util.h"
+
+#include <algorithm>
+#include <cstdint>
+
+inline namespace {
+
+	// the algorithms there are to pick from, and the names -a knows them by
+	constexpr algorithm_t CHOICES[]{ BEST_FIT, WORST_FIT, PREDICTIVE_FIT };
+	constexpr const char *NAMES[]{ "bf", "wf", "pf" };
+	constexpr size_t NUM_CHOICES = sizeof(CHOICES) / sizeof(CHOICES[0]);
+
+	size_t choice_of(algorithm_t algorithm) noexcept {
+		return static_cast<size_t>(std::find(CHOICES, CHOICES + NUM_CHOICES, algorithm) - CHOICES);
+	}
+}
+
+struct adaptive_selector {
+	adaptive_thresholds thresholds;
+	FILE *log;
+
+	arrival_rate arrivals; // the jobs the metrics have been updated with, sized by the core-seconds each is estimated to take
+	load_metrics metrics;
+
+	algorithm_t current;
+	size_t held; // jobs placed with it since it was picked
+	size_t jobs[NUM_CHOICES]; // jobs each algorithm was picked for, in the order of CHOICES
+	size_t switches;
+
+	// takes in the state of the servers and the job, unless it's been taken in already
+	bool update(const system_config *config, const job_info &job) noexcept {
+		if(!arrival_observe(&arrivals, job, static_cast<double>(job.est_runtime) * static_cast<double>(job.req_resc.cores))) return false;
+
+		size_t waiting = 0;
+		for(size_t s = 0; s < config->num_servers; ++s) waiting += config->servers[s].num_waiting;
+
+		// the states are counted as the servers change, so only the types are walked
+		size_t busy = 0, spare = 0, available = 0;
+		uintmax_t cores = 0;
+		for(size_t t = 0; t < config->num_types; ++t) {
+			const server_type *type = &config->types[t];
+			size_t idle = servers_in_state(config, type, SS_IDLE) + servers_in_state(config, type, SS_INACTIVE);
+			size_t running = servers_in_state(config, type, SS_BOOTING) + servers_in_state(config, type, SS_ACTIVE);
+
+			spare += idle;
+			busy += running;
+			available += idle + running;
+			cores += (idle + running) * type->max_resc.cores;
+		}
+
+		load_metrics sample{ static_cast<double>(waiting) / std::max<size_t>(busy, 1), static_cast<double>(spare) / std::max<size_t>(available, 1), 0 };
+
+		if(arrivals.seen == 1) {
+			metrics = sample;
+
+		} else {
+			sample.load = arrivals.size / arrival_gap(&arrivals, static_cast<intmax_t>(job.submit_time)) / static_cast<double>(std::max<uintmax_t>(cores, 1));
+
+			metrics.queue = smooth_sample(metrics.queue, sample.queue);
+			metrics.free = smooth_sample(metrics.free, sample.free);
+			metrics.load = arrivals.seen == 2 ? sample.load : smooth_sample(metrics.load, sample.load);
+		}
+
+		return true;
+	}
+
+	// the algorithm in use keeps its place until the measure that brought it in is ADAPTIVE_BAND past its threshold.
+	//.. the first job has no algorithm in use
+	algorithm_t pick() const noexcept {
+		double band = arrivals.seen > 1 ? ADAPTIVE_BAND : 0;
+		double stay = current == PREDICTIVE_FIT ? 1 - band : 1;
+		if(metrics.queue >= thresholds.queue * stay || metrics.load >= thresholds.load * stay) return PREDICTIVE_FIT;
+
+		double free = thresholds.free * (current == BEST_FIT ? 1 - band : current == WORST_FIT ? 1 + band : 1);
+		if(metrics.free >= free) return BEST_FIT;
+		return WORST_FIT;
+	}
+};
+
+adaptive_selector *adaptive_create(adaptive_thresholds thresholds, FILE *log) noexcept {
+	try {
+		adaptive_selector *selector = new adaptive_selector();
+		selector->thresholds = thresholds;
+		selector->log = log;
+		selector->current = BEST_FIT;
+		return selector;
+
+	} catch(...) {
+
+		return nullptr;
+	}
+}
+
+algorithm_t adaptive_select(adaptive_selector *selector, const system_config *config, job_info job) noexcept {
+	if(!selector->update(config, job)) return selector->current;
+	// placements from different algorithms interleaved on the same servers undo each other, so one is kept for a while once picked
+	algorithm_t picked = selector->arrivals.seen > 1 && selector->held < ADAPTIVE_DWELL ? selector->current : selector->pick();
+	const load_metrics &m = selector->metrics;
+
+	if(selector->arrivals.seen == 1) {
+		if(selector->log != nullptr) {
+			fprintf(selector->log, "adaptive: job %ju at %ju starts with %s (queue %.2f, free %.2f, load %.2f)\n",
+				job.id, job.submit_time, NAMES[choice_of(picked)], m.queue, m.free, m.load);
+		}
+
+	} else if(picked != selector->current) {
+		++selector->switches;
+		if(selector->log != nullptr) {
+			fprintf(selector->log, "adaptive: job %ju at %ju switches %s -> %s (queue %.2f, free %.2f, load %.2f)\n",
+				job.id, job.submit_time, NAMES[choice_of(selector->current)], NAMES[choice_of(picked)], m.queue, m.free, m.load);
+		}
+	}
+
+	selector->held = picked == selector->current ? selector->held + 1 : 1;
+	selector->current = picked;
+	++selector->jobs[choice_of(picked)];
+	return picked;
+}
+
+load_metrics adaptive_metrics(const adaptive_selector *selector) noexcept {
+	return selector->metrics;
+}
+
+void adaptive_print(const adaptive_selector *selector, FILE *out) noexcept {
+	fprintf(out, "# adaptive:");
+	for(size_t c = 0; c < NUM_CHOICES; ++c) fprintf(out, " %zu jobs with %s,", selector->jobs[c], NAMES[c]);
+	fprintf(out, " %zu switches\n", selector->switches);
+	fflush(out);
+}
+
+void adaptive_free(adaptive_selector *selector) noexcept {
+	delete selector;
+}
+
+server_info *adaptive_fit(system_config* config, job_info job) {
+	algorithm_t algorithm = config->context.selector != nullptr ? adaptive_select(config->context.selector, config, job) : BEST_FIT;
+	return choose_server(config, job, algorithm);
+}
@@ -0,0 +1,70 @@
+#pragma once
+#ifndef adaptive_h_
+#define adaptive_h_
+
+#ifdef __cplusplus
+#include "cpp_util.h"
+#ifndef EXTERN_C
+#define EXTERN_C
+#define EXTERN_C_adaptive_h_
+extern "C" {
+#endif
+#else
+#define noexcept
+#include <stdbool.h>
+#endif
+
+#include <stdio.h>
+#include "algorithms.h"
+
+// the defaults of adaptive_thresholds, see algorithms.h
+#define ADAPTIVE_QUEUE 0.5
+#define ADAPTIVE_FREE 0.95
+#define ADAPTIVE_LOAD 32
+
+// jobs an algorithm is kept for once it's been picked, whatever the load does in the meantime
+#define ADAPTIVE_DWELL 20
+// how far past its threshold, as a share of it, a measure has to fall back before the algorithm it brought in is dropped
+#define ADAPTIVE_BAND 0.25
+
+// the load as the adaptive algorithm sees it, each smoothed over recent jobs
+typedef struct load_metrics {
+	double queue; // jobs waiting per booting or active server, from the jobs LSTJ lists
+	double free; // share of the available servers that are idle or inactive
+	double load; // estimated core-seconds of work arriving per second, over the cores of the available servers
+} load_metrics;
+
+/*
+picks an algorithm for each job from the load: Predictive-Fit when jobs are queueing or arriving faster than the servers
+could keep up, Best-Fit when plenty of servers are free, and Worst-Fit in between, so every server keeps room for the next burst.
+hung off system_config.context.selector
+*/
+typedef struct adaptive_selector adaptive_selector;
+
+// each switch is written to `log`, which may be null; null if it can't be allocated
+adaptive_selector *adaptive_create(adaptive_thresholds thresholds, FILE *log) noexcept;
+
+// updates the metrics with the servers' state and the job, once a job however often it's asked, and picks an algorithm for it
+algorithm_t adaptive_select(adaptive_selector *selector, const system_config *config, job_info job) noexcept;
+
+load_metrics adaptive_metrics(const adaptive_selector *selector) noexcept;
+
+// writes how many jobs each algorithm was picked for, and how many times it switched
+void adaptive_print(const adaptive_selector *selector, FILE *out) noexcept;
+
+void adaptive_free(adaptive_selector *selector) noexcept;
+
+// the server the algorithm system_config.context.selector picks would choose, Best-Fit's without one
+server_info *adaptive_fit(system_config* config, job_info job);
+
+#ifdef __cplusplus
+#ifdef EXTERN_C_adaptive_h_
+}
+#undef EXTERN_C_adaptive_h_
+#undef EXTERN_C
+#endif
+#else
+#undef noexcept
+#endif
+
+#endif
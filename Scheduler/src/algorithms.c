@@ -2,74 +2,324 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <string.h>
+#include <limits.h>
 
 #include "algorithms.h"
 #include "stringhelper.h"
+#include "protocol.h"
 #include "socket_client.h"
 #include "system_config.h"
 #include "job_info.h"
+#include "latency.h"
+#include "fit_kernels.h"
+#include "capacity_index.h"
+#include "capacity_tree.h"
+#include "thread_pool.h"
+#include "cost_fit.h"
+#include "adaptive.h"
+#include "runtime_model.h"
+#include "preboot.h"
+
+static void run_jobs(socket_client *client, system_config *config, run_options options);
+static void run_batches(socket_client *client, system_config *config, run_options options);
+static bool schedule_job(socket_client *client, system_config *config, server_info *server, job_info job);
+static void refresh(system_config *config, socket_client *client, uintmax_t job_id, uintmax_t now);
 
 /* This function does everything each algorithm needs except for choosing the server to
  * run a given job. That task is given to the funtion pointer called 'algorithm' in this
  * function. In addition to not duplicating code, this allows us to test a scheduling 
  * algorithm without needing a network socket client */
 //void run_algorithm(socket_client *client, server_info *(*algorithm)(system_config*, server_group*, job_info)) {
-void run_algorithm(socket_client *client, algorithm_t algorithm) {
-	// use regexes instead of sscanf
-	regex_info *job_regex = regex_init(JOB_REGEX); // free this once finished
-
+void run_algorithm(socket_client *client, run_options options) {
 	system_config *config = parse_config("system.xml"); // need to free
+	open_context(config, options);
+
+	if (options.batch_size > 1)
+		run_batches(client, config, options);
+	else
+		run_jobs(client, config, options);
+
+	client_send(client, "QUIT");
+	close_context(config, options);
+	free_config(config);
+}
+
+/* Sets up what the options ask the algorithms to keep between jobs on config->context */
+void open_context(system_config *config, run_options options) {
+	/* The workers are started once and kept for the whole session, a job only wakes them */
+	if (options.threads > 1) {
+		config->context.workers = thread_pool_create(options.threads);
+		if (!config->context.workers)
+			fprintf(stderr, "unable to start %lu threads, searching on one\n", options.threads);
+	}
+
+	/* cost_fit's estimates are tallied as jobs are placed, and summed up at QUIT */
+	if (options.algorithm == COST_FIT) {
+		config->context.costs = cost_model_create(config, options.cost_weight);
+		if (!config->context.costs)
+			fprintf(stderr, "unable to keep cost estimates, using the default weight\n");
+	}
+
+	/* The adaptive algorithm's view of the load is built up over the session, and every switch is logged */
+	if (options.algorithm == ADAPTIVE_FIT) {
+		config->context.selector = adaptive_create(options.thresholds, stderr);
+		if (!config->context.selector)
+			fprintf(stderr, "unable to track the load, using Best-Fit\n");
+	}
+
+	/* Runtime corrections carry over between sessions through options.runtime_path */
+	if (options.runtime_path) {
+		config->context.runtimes = runtime_model_load(options.runtime_path);
+		if (!config->context.runtimes)
+			fprintf(stderr, "unable to load runtime corrections, trusting the estimates\n");
+	}
+
+	/* The arrival forecast is built up over the session, and every server it starts early is logged */
+	if (options.preboot > 0) {
+		config->context.forecast = boot_forecast_create(config, options.preboot, stderr);
+		if (!config->context.forecast)
+			fprintf(stderr, "unable to forecast arrivals, starting servers only when a job needs one\n");
+	}
+}
+
+/* Reports what the algorithms kept over the session, saves the runtime corrections, and frees it all */
+void close_context(system_config *config, run_options options) {
+	algorithm_context *context = &config->context;
+	if (context->costs) {
+		cost_model_print(context->costs, stderr);
+		cost_model_free(context->costs);
+	}
+	if (context->selector) {
+		adaptive_print(context->selector, stderr);
+		adaptive_free(context->selector);
+	}
+	if (context->runtimes) {
+		fprintf(stderr, "# learned from %lu finished jobs\n", runtime_model_observed(context->runtimes));
+		runtime_model_save(context->runtimes, options.runtime_path);
+		runtime_model_free(context->runtimes);
+	}
+	if (context->forecast) {
+		boot_forecast_print(context->forecast, stderr);
+		boot_forecast_free(context->forecast);
+	}
+	if (context->workers)
+		thread_pool_free(context->workers);
+	*context = (algorithm_context){ 0 };
+}
 
+/* Schedules each job as it arrives, refreshing the servers every options.sync_interval jobs */
+static void run_jobs(socket_client *client, system_config *config, run_options options) {
+	size_t since_sync = options.sync_interval; // makes sure the first job gets a full refresh
 	while (true) {
+		latency_poll(stderr); // a report asked for by signal is written between jobs
+
+		uint64_t start = latency_now();
 		client_send(client, "REDY");
-		char *resp = client_receive(client); // need to free
-		if (strncmp(resp, "NONE", 4) == 0)
+		const char *resp = client_receive(client); // do not free, only valid until the next receive
+		start = latency_record(LAT_WAIT, start);
+		if (message_type_of(resp) == MSG_NONE)
+			break;
+		job_info job;
+		parse_error error;
+		if (!parse_job(resp, &job, &error)) {
+			report_parse_error(resp, &error);
 			break;
-		job_info job = strtojob(resp, job_regex); // do not free
-		free(resp);
+		}
+		latency_record(LAT_PARSE, start);
 
-		if (!update_config(config, client)) {
-			fprintf(stderr, "unable to updated server information for job %lu\n", job.id);
+		/* Between full refreshes the servers are simulated locally from our own decisions
+		 * and the estimated runtimes, so those jobs cost no RESC or LSTJ traffic at all */
+		if (since_sync >= options.sync_interval) {
+			refresh(config, client, job.id, job.submit_time);
+			since_sync = 0;
+		} else {
+			advance_config(config, job.submit_time);
 		}
 
-		// needs to be freed
-		//server_group *avail_servers = updated_servers_by_avail(config, client, job.req_resc);
-		server_group *avail_servers;
-		server_info *choice;
-		switch(algorithm) {
-			case ALL_TO_LARGEST:
-				choice = all_to_largest(config, job);
-				break;
-			case FIRST_FIT:
-				choice = first_fit(config, job);
+		start = latency_now();
+		server_info *choice = decide_server(config, job, options.algorithm); // do not free
+		latency_record(LAT_DECISION, start);
+
+		/* The model only goes wrong when a job doesn't take as long as estimated, so check
+		 * the server we're about to use against the real one, and refresh everything if it's off */
+		if (choice && since_sync > 0) {
+			start = latency_now();
+			bool accurate = check_server(config, client, choice);
+			latency_record(LAT_LSTJ, start);
+
+			if (!accurate) {
+				refresh(config, client, job.id, job.submit_time);
+				since_sync = 0;
+				start = latency_now();
+				choice = decide_server(config, job, options.algorithm);
+				latency_record(LAT_DECISION, start);
+			}
+		}
+
+		if (!choice) {
+			fprintf(stderr, "unable to find server for job %lu\n", job.id);
+			break;
+		}
+
+		/* The session ends if the job wasn't taken */
+		if (!schedule_job(client, config, choice, job))
+			break;
+
+		since_sync++;
+	}
+}
+
+/* Orders jobs biggest first, by cores, then memory, then disk, and in the order they were submitted when they're the same size */
+static int larger_job_first(const void *lhs, const void *rhs) {
+	const job_info *a = lhs, *b = rhs;
+	if (a->req_resc.cores != b->req_resc.cores)
+		return a->req_resc.cores > b->req_resc.cores ? -1 : 1;
+	if (a->req_resc.memory != b->req_resc.memory)
+		return a->req_resc.memory > b->req_resc.memory ? -1 : 1;
+	if (a->req_resc.disk != b->req_resc.disk)
+		return a->req_resc.disk > b->req_resc.disk ? -1 : 1;
+	return a->id < b->id ? -1 : a->id > b->id;
+}
+
+/* Takes jobs until options.batch_size have arrived, or one is submitted more than options.batch_window
+ * after the first, then refreshes the servers once and places the whole batch, biggest job first, so the
+ * jobs hardest to fit get the most room. ds-server sends the same job again until it's scheduled, so
+ * against it every batch is a single job, which is found out from the second REDY */
+static void run_batches(socket_client *client, system_config *config, run_options options) {
+	job_info *batch = malloc(sizeof(job_info) * options.batch_size); // need to free
+	size_t batch_size = options.batch_size;
+	job_info next;
+	bool held = false; // the last job received didn't fit in its batch, so it starts the next one
+	bool last = false; // the server has no more jobs
+	bool failed = false; // a job couldn't be scheduled, which ends the session
+
+	while (!last && !failed) {
+		size_t num_jobs = 0;
+		if (held)
+			batch[num_jobs++] = next;
+		held = false;
+
+		while (num_jobs < batch_size) {
+			latency_poll(stderr); // a report asked for by signal is written between jobs
+
+			uint64_t start = latency_now();
+			client_send(client, "REDY");
+			const char *resp = client_receive(client); // do not free, only valid until the next receive
+			start = latency_record(LAT_WAIT, start);
+			parse_error error;
+			if (message_type_of(resp) == MSG_NONE) {
+				last = true;
 				break;
-			case BEST_FIT:
-				choice = best_fit(config, job);
+			} else if (!parse_job(resp, &next, &error)) {
+				report_parse_error(resp, &error);
+				failed = true;
 				break;
-			case WORST_FIT:
-				choice = worst_fit(config, job);
+			}
+			latency_record(LAT_PARSE, start);
+
+			if (num_jobs > 0 && next.id == batch[num_jobs - 1].id) {
+				fprintf(stderr, "the server sends one job at a time, so jobs won't be batched\n");
+				batch_size = 1;
 				break;
-			case PREDICTIVE_FIT:
-				choice = predictive_fit(config, job);
+			}
+			if (num_jobs > 0 && options.batch_window > 0 && next.submit_time > batch[0].submit_time + options.batch_window) {
+				held = true;
 				break;
+			}
+			batch[num_jobs++] = next;
 		}
-		//server_info *choice = algorithm(config, avail_servers, job); // do not free
 
-		if (!choice) {
-			fprintf(stderr, "unable to find server for job %lu\n", job.id);
+		if (num_jobs == 0)
 			break;
+
+		/* The server's clock has moved on to the last job it sent, so that's when every job in the batch starts */
+		uintmax_t now = held ? next.submit_time : batch[num_jobs - 1].submit_time;
+		refresh(config, client, batch[0].id, now);
+		qsort(batch, num_jobs, sizeof(job_info), larger_job_first);
+
+		size_t i;
+		for (i = 0; i < num_jobs && !failed; i++) {
+			job_info job = batch[i];
+			job.submit_time = now;
+
+			uint64_t start = latency_now();
+			server_info *choice = decide_server(config, job, options.algorithm); // do not free
+			latency_record(LAT_DECISION, start);
+
+			if (!choice) {
+				fprintf(stderr, "unable to find server for job %lu\n", job.id);
+				failed = true;
+				break;
+			}
+
+			/* Each job is in the model before the next is placed, and they're sent in the same order,
+			 * so jobs sharing a server queue there just as the model has them */
+			failed = !schedule_job(client, config, choice, job);
 		}
+	}
 
-		char *schd = create_schd_str(job.id, choice->type->name, choice->id); // need to free
-		bool success = client_msg_resp(client, schd, "OK");
-		free(schd);
-		if (!success)
-			break;
+	free(batch);
+}
+
+/* Fetches the full server state at `now`, and lets the runtime model learn from the jobs that have finished since the last time */
+static void refresh(system_config *config, socket_client *client, uintmax_t job_id, uintmax_t now) {
+	if (!update_config(config, client)) {
+		fprintf(stderr, "unable to updated server information for job %lu\n", job_id);
+		return;
 	}
+	if (config->context.runtimes)
+		runtime_model_refresh(config->context.runtimes, config, (intmax_t)now);
+}
 
-	client_send(client, "QUIT");
-	free_config(config);
-	regex_free(job_regex);
+/* Sends SCHD for a job and places it in the local model while the server answers, returning whether the server took it.
+ * cost_fit's estimate is made before the job is on the server, and only tallied once it's been taken */
+static bool schedule_job(socket_client *client, system_config *config, server_info *server, job_info job) {
+	char *schd = create_schd_str(job.id, server->type->name, server->id); // need to free
+	uint64_t start = latency_now();
+	client_send(client, schd);
+
+	cost_estimate estimate = { 0, 0 };
+	if (config->context.costs)
+		estimate = estimate_cost(server, job);
+	assign_job(server, job);
+
+	bool success = client_expect(client, schd, "OK");
+	if (success && config->context.costs)
+		cost_model_record(config->context.costs, server, estimate);
+	latency_record(LAT_SCHD, start);
+	free(schd);
+	return success;
+}
+
+/* The server the algorithm chooses for a job, or one the arrival forecast would rather start early for it */
+server_info *decide_server(system_config *config, job_info job, algorithm_t algorithm) {
+	server_info *choice = choose_server(config, job, algorithm);
+	if (config->context.forecast)
+		choice = preboot(config->context.forecast, config, job, choice);
+	return choice;
+}
+
+/* Hands a job to the chosen algorithm, returning NULL if no server was found */
+server_info *choose_server(system_config *config, job_info job, algorithm_t algorithm) {
+	switch(algorithm) {
+		case ALL_TO_LARGEST:
+			return all_to_largest(config, job);
+		case FIRST_FIT:
+			return first_fit(config, job);
+		case BEST_FIT:
+			return best_fit(config, job);
+		case WORST_FIT:
+			return worst_fit(config, job);
+		case PREDICTIVE_FIT:
+			return predictive_fit(config, job);
+		case EASY_BACKFILL:
+			return easy_backfill(config, job);
+		case COST_FIT:
+			return cost_fit(config, job);
+		case ADAPTIVE_FIT:
+			return adaptive_fit(config, job);
+	}
+	return NULL;
 }
 
 //server_info *all_to_largest(system_config *config, server_group *group, job_info job) {
@@ -86,51 +336,90 @@ server_info *all_to_largest(system_config *config, job_info job) {
 	return largest;
 }
 
+/* send the job to the first server, in the order of the
+ * config (type, then id), with the resources to run it now,
+ * or if there isn't one the first that could once it's free.
+ * The capacity tree finds it without checking every server */
 server_info *first_fit(system_config *config, job_info job) {
-	if (!config)
-		fprintf(stderr, "config not defined for job %lu\n", job.id);
-	puts("not yet implemented");
-	return NULL;
+	return capacity_first_fit(config, &job);
+}
+
+/* The same choice as first_fit, made by checking every server in turn */
+server_info *first_fit_scan(system_config *config, job_info job) {
+	const server_columns *columns = &config->columns;
+	server_info *fallback = NULL; // the first server whose type could run the job
+	size_t i;
+	for (i = 0; i < config->num_servers; i++) {
+		if (columns->state[i] == SS_UNAVAILABLE)
+			continue;
+		if (columns_can_run(columns, i, &job))
+			return &config->servers[i];
+		if (!fallback && job_can_run(&job, config->types[columns->type_index[i]].max_resc))
+			fallback = &config->servers[i];
+	}
+	return fallback;
 }
 
 /* send to job with the server with the minimum number of
  * available resources, or minimum number of max resources
- * if there is not available one */
+ * if there is not available one. The capacity index keeps
+ * servers in the order this prefers them, so it's a lookup */
 server_info *best_fit(system_config *config, job_info job) {
+	return capacity_best_fit(config, &job);
+}
+
+/* The same choice as best_fit, made by checking every server.
+ * Servers are checked a block at a time by fit_block, and only
+ * the ones holding the block's best fitness are looked at individually */
+server_info *best_fit_scan(system_config *config, job_info job) {
+	const server_columns *columns = &config->columns;
+	uint32_t fitness[FIT_BLOCK];
 	long best_fit, type_fit;
-	server_info *best_server, *best_type; // use these for the return value
+	size_t best_server = 0, best_type = 0; // indices of the servers to return
 	best_fit = type_fit = LONG_MAX;
 
-	size_t i;
-	for (i = 0; i < config->num_servers; i++) {
-		server_info *server = &config->servers[i];
+	size_t first;
+	for (first = 0; first < config->num_servers; first += FIT_BLOCK) {
+		size_t count = config->num_servers - first < FIT_BLOCK ? config->num_servers - first : FIT_BLOCK;
+		fit_result fit = fit_block(columns, first, count, &job, fitness);
 
-		// make sure server is available
-		if (server->state == SS_UNAVAILABLE)
-			continue;
-
-		if (job_can_run(&job, server->avail_resc)) {
-			// check with available resources
-			long fitness = job_fitness(&job, server->avail_resc);
-			if (fitness < best_fit || (fitness == best_fit && server->avail_time < best_server->avail_time)) {
-				best_server = server;
-				best_fit = fitness;
+		// a block can only change the choice if its best is at least as good as the one so far
+		if (fit.mask && (long)fit.min_fitness <= best_fit) {
+			uint64_t bits;
+			for (bits = fit.min_mask; bits; bits &= bits - 1) {
+				size_t i = first + (size_t)__builtin_ctzll(bits);
+				if ((long)fit.min_fitness < best_fit || columns->avail_time[i] < columns->avail_time[best_server]) {
+					best_server = i;
+					best_fit = (long)fit.min_fitness;
+				}
 			}
-		} else if (job_can_run(&job, server->type->max_resc)) {
-			// check with max resources
-			long fitness = job_fitness(&job, server->type->max_resc);
-			if (fitness < type_fit) {
-				best_type = server;
-				type_fit = fitness;
+		}
+
+		// check with max resources, which only matters until an available server is found
+		if (best_fit == LONG_MAX) {
+			size_t i;
+			for (i = first; i < first + count; i++) {
+				if (fit.mask & ((uint64_t)1 << (i - first)) || columns->state[i] == SS_UNAVAILABLE)
+					continue;
+				const resource_info max_resc = config->types[columns->type_index[i]].max_resc;
+				if (job_can_run(&job, max_resc)) {
+					long fitness = job_fitness(&job, max_resc);
+					if (fitness < type_fit) {
+						best_type = i;
+						type_fit = fitness;
+					}
+				}
 			}
 		}
 	}
 
 	// check best_fit has changed
 	if (best_fit < LONG_MAX)
-		return best_server;
+		return &config->servers[best_server];
+	else if (type_fit < LONG_MAX)
+		return &config->servers[best_type];
 	else
-		return best_type;
+		return NULL;
 }
 
 server_info *best_fit_old(system_config *config, job_info job) {
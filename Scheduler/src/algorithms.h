@@ -5,14 +5,50 @@
 #include "system_config.h"
 #include "job_info.h"
 
-typedef enum { ALL_TO_LARGEST, FIRST_FIT, BEST_FIT, WORST_FIT, PREDICTIVE_FIT } algorithm_t;
+typedef enum { ALL_TO_LARGEST, FIRST_FIT, BEST_FIT, WORST_FIT, PREDICTIVE_FIT, EASY_BACKFILL, COST_FIT, ADAPTIVE_FIT } algorithm_t;
+
+// when the adaptive algorithm moves from one algorithm to another, compared against the load as it's smoothed over recent jobs, see adaptive.h
+typedef struct adaptive_thresholds {
+	double queue; // jobs waiting per busy server at and above which the load is heavy
+	double free; // share of the servers idle or inactive at and above which the load is light, if it isn't heavy
+	double load; // work arriving per second over the cores there are at and above which the load is heavy
+} adaptive_thresholds;
+
+typedef struct run_options {
+	algorithm_t algorithm; // the algorithm choosing a server for each job
+	size_t sync_interval; // jobs per full `RESC All` refresh, the local model is used in between (1 refreshes for every job)
+	size_t threads; // threads predictive_fit searches the servers on, the decision thread included (1 searches on it alone)
+	size_t batch_size; // jobs taken before any is placed, then placed together after one refresh (1 places each as it arrives)
+	uintmax_t batch_window; // how long after a batch's first job others can join it, 0 for no limit
+	double cost_weight; // how much cost_fit weighs cost against turnaround, from 0 (turnaround alone) to 1 (cost alone)
+	adaptive_thresholds thresholds; // when adaptive_fit switches algorithm
+	const char *runtime_path; // the file runtime corrections are loaded from and saved to, see runtime_model.h, null to trust the estimates
+	double preboot; // how many boot times ahead the arrival forecast looks for servers to start early, see preboot.h, 0 to start them only when a job needs one
+} run_options;
 
 //void run_algorithm(socket_client*, server_info*(*alg)(system_config*,server_group*,job_info));
-void run_algorithm(socket_client*, algorithm_t algorithm);
+void run_algorithm(socket_client*, run_options options);
+// sets up on config->context what the options ask the algorithms to keep between jobs, run_algorithm does this itself
+void open_context(system_config*, run_options options);
+// reports and frees what open_context set up, after QUIT
+void close_context(system_config*, run_options options);
+// the server the algorithm chooses for a job, or one the arrival forecast would rather start early for it
+server_info *decide_server(system_config*, job_info, algorithm_t algorithm);
+#ifdef USE_ASYNC
+// run_algorithm on the coroutine client, see async_client.h. jobs are placed as they arrive, options.batch_size is ignored
+void run_algorithm_async(socket_client*, run_options options);
+#endif
+server_info *choose_server(system_config*, job_info, algorithm_t algorithm);
 server_info *all_to_largest(system_config*, job_info);
 server_info *first_fit(system_config*, job_info);
+server_info *first_fit_scan(system_config*, job_info);
 server_info *best_fit(system_config*, job_info);
+server_info *best_fit_scan(system_config*, job_info);
 extern server_info *worst_fit(system_config*, job_info);
+extern server_info *worst_fit_scan(system_config*, job_info);
 extern server_info *predictive_fit(system_config*, job_info);
+extern server_info *easy_backfill(system_config*, job_info);
+extern server_info *cost_fit(system_config*, job_info);
+extern server_info *adaptive_fit(system_config*, job_info);
 
 #endif
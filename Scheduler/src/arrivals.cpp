@@ -0,0 +1,34 @@
+#include "arrivals.h"
+
+#include <algorithm>
+
+double smooth_sample(double smoothed, double sample) noexcept {
+	return smoothed + ARRIVAL_SMOOTHING * (sample - smoothed);
+}
+
+bool arrival_observe(arrival_rate *rate, job_info job, double size) noexcept {
+	// a job is asked about again after a refresh, but it's still the one arrival
+	if(rate->seen > 0 && job.id == rate->last_id) return false;
+
+	if(rate->seen == 0) {
+		rate->size = size;
+
+	} else {
+		double gap = job.submit_time > rate->last_submit ? static_cast<double>(job.submit_time - rate->last_submit) : 0;
+		rate->gap = rate->seen == 1 ? gap : smooth_sample(rate->gap, gap);
+		rate->size = smooth_sample(rate->size, size);
+	}
+
+	++rate->seen;
+	rate->last_id = job.id;
+	rate->last_submit = job.submit_time;
+	return true;
+}
+
+double arrival_gap(const arrival_rate *rate, intmax_t now) noexcept {
+	// a stream that's gone quiet for longer than it usually leaves between jobs is slowing down, whatever the smoothed gap says.
+	// jobs submitted together are as good as a second apart, which is the clock's resolution
+	intmax_t last = static_cast<intmax_t>(rate->last_submit);
+	double since = now > last ? static_cast<double>(now - last) : 0;
+	return std::max(std::max(rate->gap, since), 1.0);
+}
@@ -0,0 +1,56 @@
+#pragma once
+#ifndef arrivals_h_
+#define arrivals_h_
+
+#include "job_info.h"
+
+#ifdef __cplusplus
+#include "cpp_util.h"
+#ifndef EXTERN_C
+#define EXTERN_C
+#define EXTERN_C_arrivals_h_
+extern "C" {
+#endif
+#else
+#define noexcept
+#include <stdbool.h>
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+// how much of each new sample goes into a smoothed value, so a change shows after a run of jobs rather than one odd one
+#define ARRIVAL_SMOOTHING 0.2
+
+/*
+how jobs have been arriving, smoothed over recent ones: the time between them, and their size in whatever terms the caller measures it.
+a zeroed one has seen no jobs
+*/
+typedef struct arrival_rate {
+	size_t seen; // jobs taken in
+	uintmax_t last_id; // the last of them
+	uintmax_t last_submit;
+	double gap; // smoothed seconds between them, 0 until two have arrived
+	double size; // smoothed size of each
+} arrival_rate;
+
+// moves a smoothed value towards a new sample
+double smooth_sample(double smoothed, double sample) noexcept;
+
+// takes in a job of `size`, returning false and leaving the rate alone if it's the job taken in last, asked about again after a refresh
+bool arrival_observe(arrival_rate *rate, job_info job, double size) noexcept;
+
+// the seconds between arrivals as of `now`, at least the time since the last one and never less than 1
+double arrival_gap(const arrival_rate *rate, intmax_t now) noexcept;
+
+#ifdef __cplusplus
+#ifdef EXTERN_C_arrivals_h_
+}
+#undef EXTERN_C_arrivals_h_
+#undef EXTERN_C
+#endif
+#else
+#undef noexcept
+#endif
+
+#endif
@@ -0,0 +1,364 @@
+#include "async_client.h"
+#include "cost_fit.h"
+#include "latency.h"
+#include "protocol.h"
+#include "runtime_model.h"
+#include "skyline.h"
+
+extern "C" {
+#include "algorithms.h"
+#include "stringhelper.h"
+}
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <system_error>
+
+inline namespace {
+
+	// at most this many sockets are resumed per wait, there's only ever the one to the server
+	constexpr int MAX_EVENTS = 8;
+
+	[[noreturn]] void throw_errno(const char *what) {
+		throw std::system_error(errno, std::generic_category(), what);
+	}
+
+	// whether the algorithm looks at the servers' skylines, so building one ahead of the next decision isn't wasted
+	bool uses_skylines(algorithm_t algorithm) noexcept {
+		return algorithm == PREDICTIVE_FIT || algorithm == EASY_BACKFILL || algorithm == COST_FIT || algorithm == ADAPTIVE_FIT;
+	}
+
+	// one `LSTJ` exchange, returning the server's unfinished jobs. a booting server's avail_time is moved as the rows arrive, as receive_lstj_data does
+	task<std::vector<schd_info>> list_jobs(async_connection &connection, server_info *server) {
+		std::string request = std::string("LSTJ ").append(server->type->name).append(" ").append(std::to_string(server->id));
+		if(!co_await connection.request(request.c_str(), "DATA")) throw std::runtime_error("Server did not respond as expected!");
+
+		std::vector<schd_info> jobs;
+		co_await connection.send("OK");
+		const char *response = co_await connection.receive_line();
+
+		while(strcmp(response, ".")) {
+			lstj_row row;
+			server->check_job_row(response, row);
+			co_await connection.send("OK");
+			server->take_job_row(row, jobs);
+			response = co_await connection.receive_line();
+		}
+
+		co_return jobs;
+	}
+
+	// a full refresh, then what the runtime model learns from it, as refresh in algorithms.c does it
+	task<void> refresh(async_connection &connection, system_config *config, const job_info &job) {
+		try {
+			co_await resc_all(connection, config);
+
+		} catch(const std::exception &e) {
+			fprintf(stderr, "unable to updated server information for job %ju: %s\n", job.id, e.what());
+			co_return;
+		}
+
+		if(config->context.runtimes) runtime_model_refresh(config->context.runtimes, config, static_cast<intmax_t>(job.submit_time));
+	}
+
+	// check_server on the event loop, false if the model has drifted or the check failed
+	task<bool> check(async_connection &connection, server_info *server) {
+		try {
+			co_return co_await lstj(connection, server);
+
+		} catch(const std::exception&) {
+			co_return false;
+		}
+	}
+
+	// SCHD for a job, returning whether the server took it. the job goes into the model while the server answers, and cost_fit's
+	//.. estimate is made before it does and only tallied once it's been taken, as schedule_job in algorithms.c does it
+	task<bool> schedule(async_connection &connection, system_config *config, server_info *server, job_info job) {
+		std::unique_ptr<char, decltype(&free)> schd(create_schd_str(job.id, server->type->name, server->id), &free);
+		uint64_t start = latency_now();
+		co_await connection.send(schd.get());
+
+		cost_estimate estimate{ 0, 0 };
+		connection.loop.defer([config, server, job, &estimate] {
+			if(config->context.costs) estimate = estimate_cost(server, job);
+			assign_job(server, job);
+		});
+
+		// the deferred work writes to this frame, so it's run before the frame can go
+		const char *response;
+		try {
+			response = co_await connection.receive_line();
+		} catch(...) {
+			connection.loop.settle();
+			throw;
+		}
+
+		bool success = client_check(schd.get(), response, "OK");
+		connection.loop.settle();
+		if(success && config->context.costs) cost_model_record(config->context.costs, server, estimate);
+		latency_record(LAT_SCHD, start);
+		co_return success;
+	}
+
+	// run_jobs in algorithms.c on the event loop. deferred work is settled before anything that reads the servers
+	task<void> run_jobs(async_connection &connection, system_config *config, run_options options) {
+		event_loop &loop = connection.loop;
+		size_t since_sync = options.sync_interval; // makes sure the first job gets a full refresh
+
+		while(true) {
+			latency_poll(stderr); // a report asked for by signal is written between jobs
+
+			uint64_t start = latency_now();
+			co_await connection.send("REDY");
+			const char *resp = co_await connection.receive_line(); // only valid until the next receive
+			start = latency_record(LAT_WAIT, start);
+			if(message_type_of(resp) == MSG_NONE) break;
+
+			job_info job;
+			parse_error error;
+			if(!parse_job(resp, &job, &error)) {
+				report_parse_error(resp, &error);
+				break;
+			}
+			latency_record(LAT_PARSE, start);
+			loop.settle();
+
+			if(since_sync >= options.sync_interval) {
+				co_await refresh(connection, config, job);
+				since_sync = 0;
+			} else {
+				advance_config(config, job.submit_time);
+			}
+
+			start = latency_now();
+			server_info *choice = decide_server(config, job, options.algorithm);
+			latency_record(LAT_DECISION, start);
+
+			if(choice && since_sync > 0) {
+				start = latency_now();
+				bool accurate = co_await check(connection, choice);
+				latency_record(LAT_LSTJ, start);
+
+				if(!accurate) {
+					co_await refresh(connection, config, job);
+					since_sync = 0;
+					start = latency_now();
+					choice = decide_server(config, job, options.algorithm);
+					latency_record(LAT_DECISION, start);
+				}
+			}
+
+			if(!choice) {
+				fprintf(stderr, "unable to find server for job %ju\n", job.id);
+				break;
+			}
+
+			if(!co_await schedule(connection, config, choice, job)) break;
+			since_sync++;
+
+			// the chosen server's skyline is the one the job put out of date, so it's rebuilt while the next job is on its way
+			if(uses_skylines(options.algorithm) && choice->num_jobs > 0) {
+				loop.defer([choice, job] { skyline_finish(choice, static_cast<intmax_t>(job.submit_time)); });
+			}
+		}
+	}
+}
+
+event_loop::event_loop() : epoll_fd(epoll_create1(EPOLL_CLOEXEC)) {
+	if(epoll_fd < 0) throw_errno("epoll_create1");
+}
+
+event_loop::~event_loop() {
+	close(epoll_fd);
+}
+
+void event_loop::defer(std::function<void()> work) {
+	deferred.push_back(std::move(work));
+}
+
+void event_loop::settle() {
+	while(!deferred.empty()) {
+		auto work = std::move(deferred.front());
+		deferred.pop_front();
+		work();
+		++ran_settling;
+	}
+}
+
+void event_loop::forget(int fd) noexcept {
+	auto it = std::find(registered.begin(), registered.end(), fd);
+	if(it == registered.end()) return;
+
+	epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+	registered.erase(it);
+	waiters.erase(std::remove_if(waiters.begin(), waiters.end(), [fd](const waiter &w) { return w.fd == fd; }), waiters.end());
+}
+
+void event_loop::wait(int fd, bool write, std::coroutine_handle<> handle) {
+	epoll_event event{};
+	event.events = (write ? EPOLLOUT : EPOLLIN) | EPOLLONESHOT;
+	event.data.fd = fd;
+
+	// one-shot leaves the fd registered but disarmed once it's fired, so it's rearmed rather than added again
+	bool known = std::find(registered.begin(), registered.end(), fd) != registered.end();
+	if(epoll_ctl(epoll_fd, known ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &event) < 0) throw_errno("epoll_ctl");
+	if(!known) registered.push_back(fd);
+
+	waiters.push_back(waiter{ fd, handle });
+}
+
+void event_loop::poll() {
+	if(waiters.empty()) throw std::logic_error("A task is waiting on something the event loop doesn't know about!");
+
+	// deferred work is run a piece at a time with the sockets checked in between, so it never holds up a coroutine that could go on
+	epoll_event events[MAX_EVENTS];
+	int ready;
+	while((ready = epoll_wait(epoll_fd, events, MAX_EVENTS, deferred.empty() ? -1 : 0)) == 0) {
+		auto work = std::move(deferred.front());
+		deferred.pop_front();
+		work();
+		++ran_waiting;
+	}
+
+	if(ready < 0) {
+		if(errno == EINTR) return;
+		throw_errno("epoll_wait");
+	}
+
+	for(int e = 0; e < ready; ++e) {
+		auto it = std::find_if(waiters.begin(), waiters.end(), [&](const waiter &w) { return w.fd == events[e].data.fd; });
+		if(it == waiters.end()) continue;
+
+		std::coroutine_handle<> handle = it->handle;
+		waiters.erase(it);
+		handle.resume();
+	}
+}
+
+async_connection::async_connection(event_loop &loop, socket_client *client) : loop(loop), client(client), flags(-1) {
+	if(client->trace != nullptr) throw std::invalid_argument("Traces can't be recorded or replayed on the event loop!");
+
+	flags = fcntl(client->fd, F_GETFL);
+	if(flags < 0 || fcntl(client->fd, F_SETFL, flags | O_NONBLOCK) < 0) throw_errno("fcntl");
+}
+
+async_connection::~async_connection() {
+	loop.forget(client->fd);
+	fcntl(client->fd, F_SETFL, flags);
+}
+
+task<void> async_connection::send(const char *msg) {
+	size_t length = strlen(msg), total = length + (client->newline ? 1 : 0), sent = 0;
+
+	// in newline mode the terminator goes out in the same syscall as the message, as client_send sends it
+	while(sent < total) {
+		iovec iov[2];
+		size_t parts = 0;
+		if(sent < length) iov[parts++] = iovec{ const_cast<char*>(msg) + sent, length - sent };
+		if(client->newline) iov[parts++] = iovec{ const_cast<char*>("\n"), 1 };
+
+		msghdr header{};
+		header.msg_iov = iov;
+		header.msg_iovlen = parts;
+
+		ssize_t written = sendmsg(client->fd, &header, MSG_NOSIGNAL);
+		if(written >= 0) sent += static_cast<size_t>(written);
+		else if(errno == EAGAIN || errno == EWOULDBLOCK) co_await loop.ready(client->fd, true);
+		else if(errno != EINTR) co_return;
+	}
+}
+
+task<const char*> async_connection::receive_line() {
+	while(true) {
+		if(const char *msg = client_buffered(client)) co_return msg;
+
+		int filled = client_fill(client);
+		if(filled > 0) continue;
+		if(filled < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) co_await loop.ready(client->fd, false);
+		else throw std::runtime_error("Connection closed by server");
+	}
+}
+
+task<bool> async_connection::request(const char *msg, const char *expected) {
+	co_await send(msg);
+	co_return client_check(msg, co_await receive_line(), expected);
+}
+
+task<void> resc_all(async_connection &connection, system_config *config) {
+	uint64_t start = latency_now();
+	if(!co_await connection.request("RESC All", "DATA")) throw std::runtime_error("Server did not respond as expected!");
+
+	// each row is checked before it's acknowledged, as process_resc_data does it, but taken in whenever the loop is waiting
+	std::vector<server_info*> listed;
+	co_await connection.send("OK");
+	const char *response = co_await connection.receive_line();
+
+	while(strcmp(response, ".")) {
+		resc_row row;
+		server_info *server = config->check_resc_row(response, row);
+		co_await connection.send("OK");
+
+		server_state state = static_cast<server_state>(row.state);
+		intmax_t avail_time = row.avail_time;
+		resource_info avail_resc = row.avail_resc;
+		connection.loop.defer([server, state, avail_time, avail_resc] { server->update(state, avail_time, avail_resc); });
+
+		listed.push_back(server);
+		response = co_await connection.receive_line();
+	}
+
+	// which servers have jobs to list depends on the states just taken in
+	connection.loop.settle();
+	start = latency_record(LAT_RESC, start);
+
+	for(server_info *server : listed) {
+		if(server->state == SS_INACTIVE || server->state == SS_UNAVAILABLE) continue;
+
+		std::vector<schd_info> jobs;
+		if(server->state != SS_IDLE) jobs = co_await list_jobs(connection, server);
+		connection.loop.defer([server, jobs = std::move(jobs)] { server->replace_jobs(jobs); });
+	}
+
+	connection.loop.settle();
+	latency_record(LAT_LSTJ, start);
+}
+
+task<bool> lstj(async_connection &connection, server_info *server) {
+
+	// only our own decisions can change a server that isn't running, and the model already has those
+	if(server->state == SS_INACTIVE || server->state == SS_UNAVAILABLE) co_return true;
+
+	std::vector<schd_info> jobs = co_await list_jobs(connection, server);
+	bool accurate = server->matches_jobs(jobs);
+	server->replace_jobs(jobs);
+	co_return accurate;
+}
+
+void run_algorithm_async(socket_client *client, run_options options) {
+	system_config *config = parse_config("system.xml"); // need to free
+	open_context(config, options);
+
+	try {
+		event_loop loop;
+		async_connection connection(loop, client);
+		loop.run(run_jobs(connection, config, options));
+		fprintf(stderr, "deferred work: %zu pieces run while waiting, %zu settled\n", loop.deferred_while_waiting(), loop.deferred_settled());
+	} catch(const std::exception &e) {
+		fprintf(stderr, "%s\n", e.what());
+	}
+
+	client_send(client, "QUIT");
+	close_context(config, options);
+	free_config(config);
+}
@@ -0,0 +1,213 @@
+#pragma once
+#ifndef async_client_h_
+#define async_client_h_
+
+#if __cplusplus < 202002L
+#error "async_client.h needs C++20 coroutines, build with `make ASYNC=1`"
+#endif
+
+#include "system_config.h"
+
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+the client's side of the protocol as coroutines over a non-blocking socket, driven by an epoll loop on one thread.
+ds-server reads one message at a time and drops anything sent ahead of its answer, so nothing is pipelined: what the
+coroutines buy is that the client's own work no longer has to be placed by hand between a send and the receive after it.
+work handed to event_loop::defer runs whenever the loop would otherwise wait on the socket, and whatever of it is left
+when its results are needed is run by event_loop::settle
+*/
+
+// a coroutine that starts once it's awaited, or run by event_loop::run, and hands its awaiter its result or exception
+template<typename T>
+class task;
+
+// what every task's promise keeps: who to resume when it's done, and the exception it ended with, if any
+struct task_promise_base {
+	std::coroutine_handle<> continuation;
+	std::exception_ptr error;
+
+	std::suspend_always initial_suspend() const noexcept { return {}; }
+
+	// the awaiter is resumed straight from here, so a chain of tasks doesn't grow the stack
+	auto final_suspend() const noexcept {
+		struct final_awaiter {
+			const task_promise_base *promise;
+			bool await_ready() const noexcept { return false; }
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<>) const noexcept {
+				return promise->continuation ? promise->continuation : std::noop_coroutine();
+			}
+			void await_resume() const noexcept {}
+		};
+		return final_awaiter{ this };
+	}
+
+	void unhandled_exception() noexcept { error = std::current_exception(); }
+};
+
+template<typename T>
+struct task_promise : task_promise_base {
+	std::optional<T> value;
+
+	task<T> get_return_object() noexcept;
+	void return_value(T result) { value.emplace(std::move(result)); }
+
+	T result() {
+		if(error) std::rethrow_exception(error);
+		return std::move(*value);
+	}
+};
+
+template<>
+struct task_promise<void> : task_promise_base {
+	task<void> get_return_object() noexcept;
+	void return_void() const noexcept {}
+
+	void result() const {
+		if(error) std::rethrow_exception(error);
+	}
+};
+
+template<typename T>
+class task {
+public:
+	using promise_type = task_promise<T>;
+	using handle_type = std::coroutine_handle<promise_type>;
+
+	explicit task(handle_type handle) noexcept : handle(handle) {}
+	task(task &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+	task(const task&) = delete;
+	task &operator=(const task&) = delete;
+	~task() { if(handle) handle.destroy(); }
+
+	bool await_ready() const noexcept { return false; }
+
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+		handle.promise().continuation = awaiter;
+		return handle;
+	}
+
+	T await_resume() { return handle.promise().result(); }
+
+private:
+	friend class event_loop;
+	handle_type handle;
+};
+
+template<typename T>
+task<T> task_promise<T>::get_return_object() noexcept {
+	return task<T>(std::coroutine_handle<task_promise<T>>::from_promise(*this));
+}
+
+inline task<void> task_promise<void>::get_return_object() noexcept {
+	return task<void>(std::coroutine_handle<task_promise<void>>::from_promise(*this));
+}
+
+// resumes the coroutines waiting on sockets as the sockets become ready, and runs deferred work while none are
+class event_loop {
+public:
+	// throws std::system_error if epoll isn't available
+	event_loop();
+	~event_loop();
+	event_loop(const event_loop&) = delete;
+	event_loop &operator=(const event_loop&) = delete;
+
+	// runs the task until it's done, returning its result or throwing what it threw
+	template<typename T>
+	T run(task<T> work) {
+		work.handle.resume();
+		while(!work.handle.done()) poll();
+		return work.handle.promise().result();
+	}
+
+	// suspends the awaiting coroutine until `fd` can be read from (or written to, if `write`)
+	auto ready(int fd, bool write) noexcept {
+		struct readiness {
+			event_loop *loop;
+			int fd;
+			bool write;
+			bool await_ready() const noexcept { return false; }
+			void await_suspend(std::coroutine_handle<> handle) { loop->wait(fd, write, handle); }
+			void await_resume() const noexcept {}
+		};
+		return readiness{ this, fd, write };
+	}
+
+	// queues work to be run the next time the loop would wait on a socket, in the order it was queued
+	void defer(std::function<void()> work);
+
+	// runs every piece of deferred work still queued, for when its results are about to be used
+	void settle();
+
+	// stops watching `fd`, for before it's closed or goes back to blocking use
+	void forget(int fd) noexcept;
+
+	// pieces of deferred work run while waiting on a socket, and by settle
+	size_t deferred_while_waiting() const noexcept { return ran_waiting; }
+	size_t deferred_settled() const noexcept { return ran_settling; }
+
+private:
+	struct waiter {
+		int fd;
+		std::coroutine_handle<> handle;
+	};
+
+	// registers a coroutine to be resumed once `fd` is ready, only one can wait on an fd at a time. throws std::system_error if epoll won't take it
+	void wait(int fd, bool write, std::coroutine_handle<> handle);
+
+	// resumes whatever's ready, running deferred work instead of blocking while there is any, throws std::logic_error if nothing could ever be ready
+	void poll();
+
+	int epoll_fd;
+	std::vector<int> registered; // fds epoll already knows about, each only ever waited on one-shot
+	std::vector<waiter> waiters;
+	std::deque<std::function<void()>> deferred;
+	size_t ran_waiting = 0, ran_settling = 0;
+};
+
+/*
+a socket_client's connection as awaitable operations. the client's socket is made non-blocking for as long as this lasts,
+and its receive buffer and framing are shared, so the client can go back to blocking use afterwards, for QUIT.
+traces aren't supported, neither recording nor replaying them
+*/
+class async_connection {
+public:
+	async_connection(event_loop &loop, socket_client *client);
+	~async_connection();
+	async_connection(const async_connection&) = delete;
+	async_connection &operator=(const async_connection&) = delete;
+
+	// sends a message, waiting for room in the socket if there isn't any. `msg` has to last until it's been sent.
+	//.. as with client_send, a connection the other end has closed is only noticed by the next receive
+	task<void> send(const char *msg);
+
+	// the next message, as a view into the receive buffer that's only valid until the next receive. throws std::runtime_error if the connection closes first
+	task<const char*> receive_line();
+
+	// sends a message and checks the response is the one expected, logging it to stderr if it isn't
+	task<bool> request(const char *msg, const char *expected);
+
+	event_loop &loop;
+
+private:
+	socket_client *client;
+	int flags; // the socket's file status flags before it was made non-blocking
+};
+
+// `RESC All` and an `LSTJ` for every server it shows with jobs, as system_config.update does it. rows are taken in as deferred work,
+//.. settled before the job lists are asked for and once they've all arrived. throws if the server does something unexpected
+task<void> resc_all(async_connection &connection, system_config *config);
+
+// `LSTJ` for one server, replacing its modelled jobs with the server's, and whether they matched, as system_config.check does it.
+//.. throws if the server does something unexpected
+task<bool> lstj(async_connection &connection, server_info *server);
+
+#endif
@@ -0,0 +1,215 @@
+#include "capacity_index.h"
+
+#include <initializer_list>
+#include <limits>
+#include <set>
+#include <vector>
+
+inline namespace {
+
+	// best-fit order: fewest cores, then soonest available, then lowest index
+	struct best_key {
+		uint32_t cores;
+		intmax_t avail_time;
+		size_t server;
+
+		bool operator<(const best_key &rhs) const noexcept {
+			if(cores != rhs.cores) return cores < rhs.cores;
+			if(avail_time != rhs.avail_time) return avail_time < rhs.avail_time;
+			return server < rhs.server;
+		}
+	};
+
+	// worst-fit order: most cores, then lowest index
+	struct worst_key {
+		uint32_t cores;
+		size_t server;
+
+		bool operator<(const worst_key &rhs) const noexcept {
+			if(cores != rhs.cores) return cores > rhs.cores;
+			return server < rhs.server;
+		}
+	};
+
+	bool is_running(uint8_t state) noexcept {
+		return state == SS_IDLE || state == SS_ACTIVE;
+	}
+
+	// whether a job's memory and disk fit the server, its cores being known to
+	bool fits_rest(const server_columns &columns, size_t s, const job_info &job) noexcept {
+		return job.req_resc.memory <= columns.memory[s] && job.req_resc.disk <= columns.disk[s];
+	}
+
+	/*
+	the first server, by type then index, of the type with the most (or fewest) cores that could run the job
+	once it's free, skipping servers that are unavailable or could run it now.
+	this is what the scans fall back to, and as types are laid out in order the first such type wins ties
+	*/
+	server_info *type_fallback(const system_config *config, const job_info &job, bool most) noexcept {
+		const server_columns &columns = config->columns;
+		server_info *chosen = nullptr;
+		intmax_t chosen_fitness = 0;
+
+		for(size_t t = 0; t < config->num_types; ++t) {
+			const resource_info &max_resc = config->types[t].max_resc;
+			if(!job.can_run(max_resc)) continue;
+
+			intmax_t fitness = job.fitness(max_resc);
+			if(chosen != nullptr && (most ? fitness <= chosen_fitness : fitness >= chosen_fitness)) continue;
+
+			for(size_t s = config->type_offsets[t]; s < config->type_offsets[t + 1]; ++s) {
+				if(columns.state[s] == SS_UNAVAILABLE || columns_can_run(&columns, s, &job)) continue;
+
+				chosen = &config->servers[s];
+				chosen_fitness = fitness;
+				break;
+			}
+		}
+
+		return chosen;
+	}
+}
+
+struct capacity_index {
+	// one of each per type, as a type too small for the job can be skipped whole
+	std::vector<std::set<best_key>> best; // every server that isn't unavailable
+	std::vector<std::set<worst_key>> running; // idle and active servers
+	std::vector<std::set<worst_key>> starting; // inactive and booting servers
+
+	explicit capacity_index(size_t num_types) : best(num_types), running(num_types), starting(num_types) {}
+
+	void insert(uint32_t type, uint8_t state, uint32_t cores, intmax_t avail_time, size_t s) {
+		if(state == SS_UNAVAILABLE) return;
+
+		best[type].insert(best_key{ cores, avail_time, s });
+		(is_running(state) ? running : starting)[type].insert(worst_key{ cores, s });
+	}
+
+	void erase(uint32_t type, uint8_t state, uint32_t cores, intmax_t avail_time, size_t s) {
+		if(state == SS_UNAVAILABLE) return;
+
+		best[type].erase(best_key{ cores, avail_time, s });
+		(is_running(state) ? running : starting)[type].erase(worst_key{ cores, s });
+	}
+
+	// the first server in `set` with enough cores that `accept` takes before `bound`, `set` being in worst-fit order
+	template<typename Accept>
+	static const worst_key *first_of(const std::set<worst_key> &set, uint32_t cores, const worst_key *bound, Accept accept) {
+		for(auto &key : set) {
+			if(key.cores < cores || (bound != nullptr && *bound < key)) return nullptr;
+			if(accept(key.server)) return &key;
+		}
+
+		return nullptr;
+	}
+
+	// the first server in worst-fit order, over the given sets of every type that could run the job, that `accept` takes
+	template<typename Accept>
+	static const worst_key *first_of(const system_config *config, const job_info &job, std::initializer_list<const std::vector<std::set<worst_key>>*> sets, Accept accept) {
+		const worst_key *first = nullptr;
+
+		for(size_t t = 0; t < config->num_types; ++t) {
+			if(!job.can_run(config->types[t].max_resc)) continue;
+
+			for(auto *set : sets) {
+				auto *key = first_of((*set)[t], static_cast<uint32_t>(job.req_resc.cores), first, accept);
+				if(key != nullptr) first = key;
+			}
+		}
+
+		return first;
+	}
+};
+
+capacity_index *capacity_index_create(const system_config *config) noexcept {
+	try {
+		auto *index = new capacity_index(config->num_types);
+		const server_columns &columns = config->columns;
+
+		for(size_t s = 0; s < config->num_servers; ++s) index->insert(columns.type_index[s], columns.state[s], columns.cores[s], columns.avail_time[s], s);
+
+		return index;
+
+	} catch(...) {
+
+		return nullptr;
+	}
+}
+
+void capacity_index_update(capacity_index *index, const server_columns *columns, size_t s, uint8_t old_state, uint32_t old_cores, intmax_t old_avail_time) noexcept {
+	uint32_t type = columns->type_index[s];
+	uint8_t state = columns->state[s];
+	uint32_t cores = columns->cores[s];
+	intmax_t avail_time = columns->avail_time[s];
+
+	if(state == old_state && cores == old_cores && avail_time == old_avail_time) return;
+
+	try {
+		index->erase(type, old_state, old_cores, old_avail_time, s);
+		index->insert(type, state, cores, avail_time, s);
+
+	} catch(...) {
+
+		// out of memory, leave the server out rather than the index half-updated
+		index->erase(type, state, cores, avail_time, s);
+	}
+}
+
+void capacity_index_free(capacity_index *index) noexcept {
+	delete index;
+}
+
+server_info *capacity_best_fit(const system_config *config, const job_info *job) noexcept {
+	const server_columns &columns = config->columns;
+	constexpr uintmax_t widest = std::numeric_limits<uint32_t>::max();
+
+	if(job->req_resc.cores <= widest) {
+		const best_key from{ static_cast<uint32_t>(job->req_resc.cores), std::numeric_limits<intmax_t>::min(), 0 };
+		const best_key *best = nullptr;
+
+		for(size_t t = 0; t < config->num_types; ++t) {
+			if(!job->can_run(config->types[t].max_resc)) continue;
+
+			auto &set = config->capacity->best[t];
+			for(auto it = set.lower_bound(from); it != set.end(); ++it) {
+				// nothing further on in this type can beat the best of the types before it
+				if(best != nullptr && *best < *it) break;
+
+				if(fits_rest(columns, it->server, *job)) {
+					best = &*it;
+					break;
+				}
+			}
+		}
+
+		if(best != nullptr) return &config->servers[best->server];
+	}
+
+	return type_fallback(config, *job, false);
+}
+
+server_info *capacity_worst_fit(const system_config *config, const job_info *job) noexcept {
+	const server_columns &columns = config->columns;
+	const capacity_index &index = *config->capacity;
+	constexpr uintmax_t widest = std::numeric_limits<uint32_t>::max();
+
+	if(job->req_resc.cores <= widest) {
+		intmax_t now = static_cast<intmax_t>(job->submit_time);
+
+		// a running server that's free now
+		auto *worst = capacity_index::first_of(config, *job, { &index.running }, [&](size_t s) {
+			return fits_rest(columns, s, *job) && columns.avail_time[s] <= now;
+		});
+
+		if(worst != nullptr) return &config->servers[worst->server];
+
+		// otherwise any server that will be free within its type's boot time
+		auto *other = capacity_index::first_of(config, *job, { &index.running, &index.starting }, [&](size_t s) {
+			return fits_rest(columns, s, *job) && columns.avail_time[s] <= static_cast<intmax_t>(job->submit_time + config->types[columns.type_index[s]].bootTime);
+		});
+
+		if(other != nullptr) return &config->servers[other->server];
+	}
+
+	return type_fallback(config, *job, true);
+}
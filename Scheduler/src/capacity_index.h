@@ -0,0 +1,61 @@
+#pragma once
+#ifndef capacity_index_h_
+#define capacity_index_h_
+
+#include "system_config.h"
+#include "job_info.h"
+
+#ifdef __cplusplus
+#include "cpp_util.h"
+#ifndef EXTERN_C
+#define EXTERN_C
+#define EXTERN_C_capacity_index_h_
+extern "C" {
+#endif
+#else
+#define noexcept
+#include <stdbool.h>
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+the servers of a system_config ordered by available cores, so best-fit and worst-fit find their
+server by walking from one end instead of scanning every server.
+for best-fit every server that isn't unavailable is ordered by cores, then avail_time, then index,
+exactly the order the scan prefers them in. for worst-fit running (idle or active) servers and
+starting (inactive or booting) servers are kept apart, each ordered by most cores first, then index,
+so servers that are only worth using later don't have to be walked past.
+each of these is kept per type, so types too small for a job are never walked, and the first server
+of each type that has the memory and disk is compared with the others.
+a query costs O(types * log n), plus the servers of a big enough type that are skipped for lack of memory or disk.
+kept up to date by server_info.sync, which every change to a server goes through
+*/
+typedef struct capacity_index capacity_index;
+
+// indexes every server of a config as its columns stand
+capacity_index *capacity_index_create(const system_config *config) noexcept;
+
+// moves server `s` to where its columns now put it, given what they held before
+void capacity_index_update(capacity_index *index, const server_columns *columns, size_t s, uint8_t old_state, uint32_t old_cores, intmax_t old_avail_time) noexcept;
+
+void capacity_index_free(capacity_index *index) noexcept;
+
+// the same server best_fit_scan would choose, or null if there's none
+server_info *capacity_best_fit(const system_config *config, const job_info *job) noexcept;
+
+// the same server worst_fit_scan would choose, or null if there's none
+server_info *capacity_worst_fit(const system_config *config, const job_info *job) noexcept;
+
+#ifdef __cplusplus
+#ifdef EXTERN_C_capacity_index_h_
+}
+#undef EXTERN_C_capacity_index_h_
+#undef EXTERN_C
+#endif
+#else
+#undef noexcept
+#endif
+
+#endif
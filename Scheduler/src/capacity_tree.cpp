@@ -0,0 +1,124 @@
+#include "capacity_tree.h"
+#include "fit_kernels.h"
+
+#include <algorithm>
+#include <vector>
+
+inline namespace {
+
+	// the most of each resource available on a server below a node, live if any server below isn't unavailable
+	struct node {
+		uint32_t cores;
+		uint32_t memory;
+		uint32_t disk;
+		uint32_t live;
+
+		bool operator==(const node &rhs) const noexcept {
+			return cores == rhs.cores && memory == rhs.memory && disk == rhs.disk && live == rhs.live;
+		}
+
+		bool operator!=(const node &rhs) const noexcept {
+			return !(*this == rhs);
+		}
+
+		// whether some server below might have room for the job
+		bool may_fit(const job_info &job) const noexcept {
+			return live && job.req_resc.cores <= cores && job.req_resc.memory <= memory && job.req_resc.disk <= disk;
+		}
+	};
+
+	node merge(const node &a, const node &b) noexcept {
+		return node{ std::max(a.cores, b.cores), std::max(a.memory, b.memory), std::max(a.disk, b.disk), a.live | b.live };
+	}
+}
+
+struct capacity_tree {
+	size_t num_servers;
+	size_t leaves; // a power of two, the root is node 1 and leaf b is node leaves + b
+	std::vector<node> nodes;
+
+	capacity_tree(size_t num_servers) : num_servers(num_servers), leaves(1) {
+		while(leaves * FIT_BLOCK < num_servers) leaves *= 2;
+		nodes.resize(2 * leaves, node{ 0, 0, 0, 0 });
+	}
+
+	// the node for a block of servers, from their columns
+	node of_block(const server_columns &columns, size_t block) const noexcept {
+		node n{ 0, 0, 0, 0 };
+		size_t end = std::min(num_servers, (block + 1) * FIT_BLOCK);
+
+		for(size_t s = block * FIT_BLOCK; s < end; ++s) {
+			if(columns.state[s] == SS_UNAVAILABLE) continue;
+
+			n = merge(n, node{ columns.cores[s], columns.memory[s], columns.disk[s], 1 });
+		}
+
+		return n;
+	}
+
+	// the first server below node `at` that can run the job, or num_servers if there's none
+	size_t first(const server_columns &columns, size_t at, const job_info &job) const noexcept {
+		if(!nodes[at].may_fit(job)) return num_servers;
+
+		if(at >= leaves) {
+			uint32_t fitness[FIT_BLOCK];
+			size_t from = (at - leaves) * FIT_BLOCK;
+			fit_result fit = fit_block(&columns, from, std::min<size_t>(FIT_BLOCK, num_servers - from), &job, fitness);
+
+			return fit.mask != 0 ? from + static_cast<size_t>(__builtin_ctzll(fit.mask)) : num_servers;
+		}
+
+		size_t left = first(columns, 2 * at, job);
+
+		return left != num_servers ? left : first(columns, 2 * at + 1, job);
+	}
+};
+
+capacity_tree *capacity_tree_create(const server_columns *columns, size_t num_servers) noexcept {
+	try {
+		auto *tree = new capacity_tree(num_servers);
+
+		for(size_t b = 0; b * FIT_BLOCK < num_servers; ++b) tree->nodes[tree->leaves + b] = tree->of_block(*columns, b);
+		for(size_t at = tree->leaves - 1; at > 0; --at) tree->nodes[at] = merge(tree->nodes[2 * at], tree->nodes[2 * at + 1]);
+
+		return tree;
+
+	} catch(...) {
+
+		return nullptr;
+	}
+}
+
+void capacity_tree_update(capacity_tree *tree, const server_columns *columns, size_t s) noexcept {
+	size_t at = tree->leaves + s / FIT_BLOCK;
+	node n = tree->of_block(*columns, s / FIT_BLOCK);
+
+	// stops as soon as a node comes out the same, as nothing above it can change either
+	while(at > 0 && tree->nodes[at] != n) {
+		tree->nodes[at] = n;
+		at /= 2;
+		if(at > 0) n = merge(tree->nodes[2 * at], tree->nodes[2 * at + 1]);
+	}
+}
+
+void capacity_tree_free(capacity_tree *tree) noexcept {
+	delete tree;
+}
+
+server_info *capacity_first_fit(const system_config *config, const job_info *job) noexcept {
+	const server_columns &columns = config->columns;
+
+	size_t s = config->first_fit->first(columns, 1, *job);
+	if(s != config->num_servers) return &config->servers[s];
+
+	// no server can run it now, so the first that could once it's free, which is the first of a big enough type
+	for(size_t t = 0; t < config->num_types; ++t) {
+		if(!job->can_run(config->types[t].max_resc)) continue;
+
+		for(s = config->type_offsets[t]; s < config->type_offsets[t + 1]; ++s) {
+			if(columns.state[s] != SS_UNAVAILABLE) return &config->servers[s];
+		}
+	}
+
+	return nullptr;
+}
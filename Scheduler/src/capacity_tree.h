@@ -0,0 +1,58 @@
+#pragma once
+#ifndef capacity_tree_h_
+#define capacity_tree_h_
+
+#include "system_config.h"
+#include "job_info.h"
+
+#ifdef __cplusplus
+#include "cpp_util.h"
+#ifndef EXTERN_C
+#define EXTERN_C
+#define EXTERN_C_capacity_tree_h_
+extern "C" {
+#endif
+#else
+#define noexcept
+#include <stdbool.h>
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+a segment tree over the servers of a system_config in their own order (type, then id), each node
+holding the most cores, memory and disk available on any server below it that isn't unavailable,
+so first-fit finds the first server with room for a job by walking down from the root, left first.
+a leaf covers a block of FIT_BLOCK servers, which fit_block checks in one go, so the tree stays small.
+a node only bounds each resource on its own, so a walk can go down a subtree with no server that has
+all three and have to come back up; with servers that are alike that's rare, and a query costs O(log n).
+kept up to date by server_info.sync, which every change to a server goes through
+*/
+typedef struct capacity_tree capacity_tree;
+
+// builds the tree over the first `num_servers` servers in `columns` as they stand
+capacity_tree *capacity_tree_create(const server_columns *columns, size_t num_servers) noexcept;
+
+// brings the tree up to date after the columns of server `s` have changed
+void capacity_tree_update(capacity_tree *tree, const server_columns *columns, size_t s) noexcept;
+
+void capacity_tree_free(capacity_tree *tree) noexcept;
+
+/*
+the first server, in config order, that isn't unavailable and has the resources to run the job now,
+or failing that the first one whose type could run it once it's free; null if there's none
+*/
+server_info *capacity_first_fit(const system_config *config, const job_info *job) noexcept;
+
+#ifdef __cplusplus
+#ifdef EXTERN_C_capacity_tree_h_
+}
+#undef EXTERN_C_capacity_tree_h_
+#undef EXTERN_C
+#endif
+#else
+#undef noexcept
+#endif
+
+#endif
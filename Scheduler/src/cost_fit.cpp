@@ -0,0 +1,134 @@
+#include "cost_fit.h"
+#include "cpp_util.h"
+#include "stage_three.h"
+
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+#include <vector>
+
+struct cost_model {
+	const system_config *config;
+	double weight;
+	std::vector<bool> used; // parallel to system_config.servers, whether each has been given a job
+	std::vector<cost_summary> types; // parallel to system_config.types
+};
+
+inline namespace {
+
+	constexpr size_t NO_SERVER = std::numeric_limits<size_t>::max();
+	constexpr double SECONDS_PER_HOUR = 3600;
+}
+
+cost_model *cost_model_create(const system_config *config, double weight) noexcept {
+	try {
+		return new cost_model{ config, weight, std::vector<bool>(config->num_servers), std::vector<cost_summary>(config->num_types, cost_summary{ 0, 0, 0, 0 }) };
+
+	} catch(...) {
+
+		return nullptr;
+	}
+}
+
+cost_estimate estimate_cost(server_info *server, job_info job) {
+	intmax_t now = static_cast<intmax_t>(job.submit_time);
+
+	// the server starts jobs once it's up, so an inactive one has to boot first, and is billed for that
+	intmax_t ready = now;
+	if(server->state == SS_INACTIVE) ready = now + static_cast<intmax_t>(server->type->bootTime);
+	else if(server->state == SS_BOOTING) ready = std::max(server->avail_time, now);
+
+	intmax_t start = server->num_jobs == 0 ? ready : predict_availability(server, &job, ready).avail;
+	intmax_t finish = start + static_cast<intmax_t>(job.est_runtime);
+
+	// what the server's billed until without the job
+	intmax_t billed = server->state == SS_INACTIVE ? now : skyline_finish(server, ready);
+
+	return cost_estimate{ server->type->rate * static_cast<double>(std::max<intmax_t>(finish - billed, 0)) / SECONDS_PER_HOUR, finish - now };
+}
+
+void cost_model_record(cost_model *model, const server_info *server, cost_estimate estimate) noexcept {
+	size_t s = static_cast<size_t>(server - model->config->servers);
+	cost_summary &type = model->types[model->config->columns.type_index[s]];
+
+	type.cost += estimate.cost;
+	type.turnaround += estimate.turnaround;
+	++type.jobs;
+
+	if(!model->used[s]) {
+		model->used[s] = true;
+		++type.servers;
+	}
+}
+
+cost_summary cost_model_summary(const cost_model *model, const server_type *type) noexcept {
+	if(type != nullptr) return model->types[static_cast<size_t>(type - model->config->types)];
+
+	cost_summary total{ 0, 0, 0, 0 };
+	for(auto &t : model->types) {
+		total.cost += t.cost;
+		total.turnaround += t.turnaround;
+		total.jobs += t.jobs;
+		total.servers += t.servers;
+	}
+	return total;
+}
+
+void cost_model_print(const cost_model *model, FILE *out) noexcept {
+	for(size_t t = 0; t < model->config->num_types; ++t) {
+		const cost_summary &type = model->types[t];
+		if(type.jobs == 0) continue;
+
+		fprintf(out, "# %zu %s servers given %zu jobs at an estimated cost of $%.2f\n", type.servers, model->config->types[t].name, type.jobs, type.cost);
+	}
+
+	cost_summary total = cost_model_summary(model, nullptr);
+	fprintf(out, "# estimated total cost: $%.2f and avg turnaround time: %jd\n", total.cost, total.jobs == 0 ? 0 : total.turnaround / static_cast<intmax_t>(total.jobs));
+	fflush(out);
+}
+
+void cost_model_free(cost_model *model) noexcept {
+	delete model;
+}
+
+server_info *cost_fit(system_config* config, job_info job) {
+	const server_columns &columns = config->columns;
+	double weight = config->context.costs != nullptr ? config->context.costs->weight : COST_WEIGHT;
+
+	// the least the job could cost and take, so the two can be blended without one's units swamping the other's
+	double cheapest = std::numeric_limits<double>::infinity();
+	for(size_t t = 0; t < config->num_types; ++t) {
+		if(job.can_run(config->types[t].max_resc)) cheapest = std::min(cheapest, static_cast<double>(config->types[t].rate));
+	}
+	if(cheapest == std::numeric_limits<double>::infinity()) return nullptr;
+
+	double least_turnaround = static_cast<double>(std::max<uintmax_t>(job.est_runtime, 1));
+	double least_cost = std::max(cheapest * least_turnaround / SECONDS_PER_HOUR, std::numeric_limits<double>::min());
+
+	size_t best = NO_SERVER, inactive_type = NO_SERVER;
+	double best_score = 0;
+	intmax_t best_fitness = 0;
+
+	for(size_t s = 0; s < config->num_servers; ++s) {
+		const resource_info &max_resc = config->types[columns.type_index[s]].max_resc;
+		if(columns.state[s] == SS_UNAVAILABLE || !job.can_run(max_resc)) continue;
+
+		// a type's inactive servers all score the same as its first, which wins the tie, so only that one is estimated
+		if(columns.state[s] == SS_INACTIVE) {
+			if(columns.type_index[s] == inactive_type) continue;
+			inactive_type = columns.type_index[s];
+		}
+
+		cost_estimate estimate = estimate_cost(&config->servers[s], job);
+		double score = weight * estimate.cost / least_cost + (1 - weight) * static_cast<double>(estimate.turnaround) / least_turnaround;
+		intmax_t fitness = job_fitness(&job, columns_can_run(&columns, s, &job) ? columns_avail_resc(&columns, s) : max_resc);
+
+		if(best == NO_SERVER || score < best_score || (score == best_score && fitness < best_fitness)) {
+			best = s;
+			best_score = score;
+			best_fitness = fitness;
+		}
+	}
+
+	return best != NO_SERVER ? &config->servers[best] : nullptr;
+}
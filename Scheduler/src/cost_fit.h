@@ -0,0 +1,79 @@
+#pragma once
+#ifndef cost_fit_h_
+#define cost_fit_h_
+
+#ifdef __cplusplus
+#include "cpp_util.h"
+#ifndef EXTERN_C
+#define EXTERN_C
+#define EXTERN_C_cost_fit_h_
+extern "C" {
+#endif
+#else
+#define noexcept
+#include <stdbool.h>
+#endif
+
+#include <stdio.h>
+#include "algorithms.h"
+
+// how much a placement is estimated to add to the bill, and how long the job is estimated to take from submission to finishing
+typedef struct cost_estimate {
+	double cost; // in the types' hourly rates
+	intmax_t turnaround; // in seconds
+} cost_estimate;
+
+// the estimates of every job placed, and the servers they went to
+typedef struct cost_summary {
+	double cost;
+	intmax_t turnaround; // total over every job
+	size_t jobs;
+	size_t servers; // servers that were given a job
+} cost_summary;
+
+/*
+the weight cost_fit blends cost and turnaround with, and a tally of the estimates of every job it placed.
+hung off system_config.context.costs, cost_fit uses COST_WEIGHT and tallies nothing without one
+*/
+typedef struct cost_model cost_model;
+
+// half cost, half turnaround
+#define COST_WEIGHT 0.5
+
+// for weights from 0, turnaround alone, to 1, cost alone; null if it can't be allocated
+cost_model *cost_model_create(const system_config *config, double weight) noexcept;
+
+/*
+the estimate for placing a job on a server now, from its skyline, see skyline.h.
+the server is billed for every second it's busy, all of it whatever the job leaves idle, and for booting if it's inactive,
+so the cost is what the job adds to that: nothing if it finishes before the server's other jobs, the whole server for as long as it's running otherwise
+*/
+cost_estimate estimate_cost(server_info *server, job_info job);
+
+// adds a placement to the tally once the server has taken the job, with the estimate made before it was assigned to the server
+void cost_model_record(cost_model *model, const server_info *server, cost_estimate estimate) noexcept;
+
+cost_summary cost_model_summary(const cost_model *model, const server_type *type) noexcept;
+
+// writes the summary of each type given a job, then of every server
+void cost_model_print(const cost_model *model, FILE *out) noexcept;
+
+void cost_model_free(cost_model *model) noexcept;
+
+/*
+the server with the lowest blend of estimated cost and turnaround, each relative to the least it could be:
+the job alone on the cheapest type that can run it, and its estimated runtime. ties go to the snuggest fit, then the first
+*/
+server_info *cost_fit(system_config* config, job_info job);
+
+#ifdef __cplusplus
+#ifdef EXTERN_C_cost_fit_h_
+}
+#undef EXTERN_C_cost_fit_h_
+#undef EXTERN_C
+#endif
+#else
+#undef noexcept
+#endif
+
+#endif
@@ -0,0 +1,76 @@
+#include "easy_backfill.h"
+#include "cpp_util.h"
+#include "stage_three.h"
+
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+
+inline namespace {
+
+	// a server the job could go to, and what it's chosen by
+	struct placement {
+		size_t server; // index in system_config.servers
+		intmax_t start; // when the job would start there
+		intmax_t fitness; // cores left over once it has, fewer is better
+		intmax_t avail_time; // the server's own, as best-fit breaks ties on it
+
+		// best-fit's order, so it picks what best-fit would wherever nothing's waiting: the snuggest fit, then the lowest avail_time, then the first
+		bool fits_better(const placement &rhs) const noexcept {
+			if(fitness != rhs.fitness) return fitness < rhs.fitness;
+			if(avail_time != rhs.avail_time) return avail_time < rhs.avail_time;
+			return server < rhs.server;
+		}
+
+		// for jobs that have to wait: the soonest start, then the snuggest fit, then the first
+		bool starts_sooner(const placement &rhs) const noexcept {
+			if(start != rhs.start) return start < rhs.start;
+			if(fitness != rhs.fitness) return fitness < rhs.fitness;
+			return server < rhs.server;
+		}
+	};
+
+	constexpr size_t NO_SERVER = std::numeric_limits<size_t>::max();
+
+	/*
+	whether a job starting on server `s` at `start` leaves the oldest job waiting there to start when it's predicted to:
+	it's finished by then, or there's room for both. nothing waiting means there's nothing to hold up
+	*/
+	bool keeps_reservation(system_config *config, size_t s, const job_info &job, intmax_t start) {
+		server_info &server = config->servers[s];
+		if(server.num_waiting == 0) return true;
+
+		job_reservation reservation = skyline_reservation(&server, start);
+		return start + static_cast<intmax_t>(job.est_runtime) <= reservation.start || reservation.util + job.req_resc <= server.type->max_resc;
+	}
+}
+
+server_info *easy_backfill(system_config* config, job_info job) {
+	const server_columns &columns = config->columns;
+	intmax_t now = static_cast<intmax_t>(job.submit_time);
+
+	placement backfill{ NO_SERVER, 0, 0, 0 }; // fits now, leaving every reservation alone
+	placement waits{ NO_SERVER, 0, 0, 0 }; // can't start yet, so waits its turn
+	placement jumps{ NO_SERVER, 0, 0, 0 }; // fits now, but would hold up a job waiting longer
+
+	for(size_t s = 0; s < config->num_servers; ++s) {
+		const resource_info &max_resc = config->types[columns.type_index[s]].max_resc;
+		if(columns.state[s] == SS_UNAVAILABLE || !job.can_run(max_resc)) continue;
+
+		// a server that's booting, or would have to, starts jobs once it's up, any other starts them now
+		intmax_t from = columns.state[s] == SS_BOOTING || columns.state[s] == SS_INACTIVE ? std::max(columns.avail_time[s], now) : now;
+
+		if(columns_can_run(&columns, s, &job)) {
+			placement here{ s, from, job_fitness(&job, columns_avail_resc(&columns, s)), columns.avail_time[s] };
+			placement &best = keeps_reservation(config, s, job, from) ? backfill : jumps;
+			if(best.server == NO_SERVER || here.fits_better(best)) best = here;
+
+		} else {
+			placement here{ s, predict_availability(&config->servers[s], &job, from).avail, job_fitness(&job, max_resc), columns.avail_time[s] };
+			if(waits.server == NO_SERVER || here.starts_sooner(waits)) waits = here;
+		}
+	}
+
+	size_t chosen = backfill.server != NO_SERVER ? backfill.server : waits.server != NO_SERVER ? waits.server : jumps.server;
+	return chosen != NO_SERVER ? &config->servers[chosen] : nullptr;
+}
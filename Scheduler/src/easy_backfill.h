@@ -0,0 +1,35 @@
+#pragma once
+#ifndef easy_backfill_h_
+#define easy_backfill_h_
+
+#ifdef __cplusplus
+#ifndef EXTERN_C
+#define EXTERN_C
+#define EXTERN_C_easy_backfill_h_
+extern "C" {
+#endif
+#else
+#define noexcept(BOOL)
+#include <stdbool.h>
+#endif
+
+#include "algorithms.h"
+
+/*
+best-fit that keeps EASY backfilling's reservation for the oldest job waiting on each server: the job only goes
+where it fits now if it would finish before that job is predicted to start, or leaves it room when it does.
+if it can't start anywhere without getting in the way of one, it goes where it's predicted to start soonest
+*/
+server_info *easy_backfill(system_config* config, job_info job);
+
+#ifdef __cplusplus
+#ifdef EXTERN_C_easy_backfill_h_
+#undef EXTERN_C_easy_backfill_h_
+#undef EXTERN_C
+}
+#endif
+#else
+#undef noexcept
+#endif
+
+#endif
@@ -0,0 +1,239 @@
+#include "fit_kernels.h"
+ASSERT_IS_POD(fit_result);
+
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FIT_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+inline namespace {
+
+	// the job's requirements narrowed to the width of the columns
+	struct request {
+		uint32_t cores;
+		uint32_t memory;
+		uint32_t disk;
+	};
+
+	typedef fit_result (*kernel_fn)(const server_columns*, size_t, size_t, const request&, uint32_t*);
+
+	fit_result empty_result() noexcept {
+		return fit_result{ 0, std::numeric_limits<uint32_t>::max(), 0, 0, 0 };
+	}
+
+	// checks lanes [from, count), the whole block for the scalar kernel and the leftovers for the others
+	void scalar_lanes(const server_columns *columns, size_t first, size_t from, size_t count, const request &req, uint32_t *fitness, fit_result &result) noexcept {
+		for(size_t i = from; i < count; ++i) {
+			size_t s = first + i;
+			fitness[i] = columns->cores[s] - req.cores;
+
+			if(columns->state[s] != SS_UNAVAILABLE && req.cores <= columns->cores[s] && req.memory <= columns->memory[s] && req.disk <= columns->disk[s]) {
+				result.mask |= uint64_t(1) << i;
+				if(fitness[i] < result.min_fitness) result.min_fitness = fitness[i];
+				if(fitness[i] > result.max_fitness) result.max_fitness = fitness[i];
+			}
+		}
+	}
+
+	// fills min_mask and max_mask for lanes [from, count) once the minimum and maximum are known
+	void scalar_extremes(const uint32_t *fitness, size_t from, size_t count, fit_result &result) noexcept {
+		for(size_t i = from; i < count; ++i) {
+			uint64_t bit = (uint64_t(1) << i) & result.mask;
+			if(fitness[i] == result.min_fitness) result.min_mask |= bit;
+			if(fitness[i] == result.max_fitness) result.max_mask |= bit;
+		}
+	}
+
+	fit_result fit_scalar(const server_columns *columns, size_t first, size_t count, const request &req, uint32_t *fitness) noexcept {
+		fit_result result = empty_result();
+		scalar_lanes(columns, first, 0, count, req, fitness, result);
+		scalar_extremes(fitness, 0, count, result);
+		return result;
+	}
+
+#ifdef FIT_KERNELS_X86
+
+	/*
+	the vector kernels compare unsigned 32-bit lanes as max(a, b) == a for a >= b, and keep running
+	minimums and maximums with servers that can't run the job blended out, so nothing branches per server.
+	the minimum and maximum are only known at the end, so a second pass over fitness picks out the lanes
+	holding them, while it's still in L1
+	*/
+	__attribute__((target("sse4.2"))) fit_result fit_sse42(const server_columns *columns, size_t first, size_t count, const request &req, uint32_t *fitness) noexcept {
+		const __m128i req_cores = _mm_set1_epi32(static_cast<int>(req.cores));
+		const __m128i req_memory = _mm_set1_epi32(static_cast<int>(req.memory));
+		const __m128i req_disk = _mm_set1_epi32(static_cast<int>(req.disk));
+		const __m128i unavailable = _mm_set1_epi32(SS_UNAVAILABLE);
+		const __m128i ones = _mm_set1_epi32(-1);
+		__m128i min = ones, max = _mm_setzero_si128();
+
+		fit_result result = empty_result();
+		size_t i = 0;
+
+		for(; i + 4 <= count; i += 4) {
+			size_t s = first + i;
+			__m128i cores = _mm_loadu_si128(reinterpret_cast<const __m128i*>(columns->cores + s));
+			__m128i memory = _mm_loadu_si128(reinterpret_cast<const __m128i*>(columns->memory + s));
+			__m128i disk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(columns->disk + s));
+			int32_t states;
+			memcpy(&states, columns->state + s, sizeof states);
+			__m128i state = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(states));
+
+			__m128i fits = _mm_and_si128(_mm_cmpeq_epi32(_mm_max_epu32(cores, req_cores), cores), _mm_cmpeq_epi32(_mm_max_epu32(memory, req_memory), memory));
+			fits = _mm_and_si128(fits, _mm_cmpeq_epi32(_mm_max_epu32(disk, req_disk), disk));
+			fits = _mm_andnot_si128(_mm_cmpeq_epi32(state, unavailable), fits);
+
+			__m128i fit = _mm_sub_epi32(cores, req_cores);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(fitness + i), fit);
+
+			min = _mm_min_epu32(min, _mm_blendv_epi8(ones, fit, fits));
+			max = _mm_max_epu32(max, _mm_and_si128(fit, fits));
+			result.mask |= uint64_t(_mm_movemask_ps(_mm_castsi128_ps(fits))) << i;
+		}
+
+		uint32_t lanes[4];
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), min);
+		for(auto lane : lanes) if(lane < result.min_fitness) result.min_fitness = lane;
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), max);
+		for(auto lane : lanes) if(lane > result.max_fitness) result.max_fitness = lane;
+
+		scalar_lanes(columns, first, i, count, req, fitness, result);
+
+		const __m128i min_fitness = _mm_set1_epi32(static_cast<int>(result.min_fitness));
+		const __m128i max_fitness = _mm_set1_epi32(static_cast<int>(result.max_fitness));
+		size_t j = 0;
+
+		for(; j + 4 <= count; j += 4) {
+			__m128i fit = _mm_loadu_si128(reinterpret_cast<const __m128i*>(fitness + j));
+			result.min_mask |= uint64_t(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(fit, min_fitness)))) << j;
+			result.max_mask |= uint64_t(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(fit, max_fitness)))) << j;
+		}
+
+		result.min_mask &= result.mask;
+		result.max_mask &= result.mask;
+		scalar_extremes(fitness, j, count, result);
+
+		return result;
+	}
+
+	__attribute__((target("avx2"))) fit_result fit_avx2(const server_columns *columns, size_t first, size_t count, const request &req, uint32_t *fitness) noexcept {
+		const __m256i req_cores = _mm256_set1_epi32(static_cast<int>(req.cores));
+		const __m256i req_memory = _mm256_set1_epi32(static_cast<int>(req.memory));
+		const __m256i req_disk = _mm256_set1_epi32(static_cast<int>(req.disk));
+		const __m256i unavailable = _mm256_set1_epi32(SS_UNAVAILABLE);
+		const __m256i ones = _mm256_set1_epi32(-1);
+		__m256i min = ones, max = _mm256_setzero_si256();
+
+		fit_result result = empty_result();
+		size_t i = 0;
+
+		for(; i + 8 <= count; i += 8) {
+			size_t s = first + i;
+			__m256i cores = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(columns->cores + s));
+			__m256i memory = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(columns->memory + s));
+			__m256i disk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(columns->disk + s));
+			__m256i state = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(columns->state + s)));
+
+			__m256i fits = _mm256_and_si256(_mm256_cmpeq_epi32(_mm256_max_epu32(cores, req_cores), cores), _mm256_cmpeq_epi32(_mm256_max_epu32(memory, req_memory), memory));
+			fits = _mm256_and_si256(fits, _mm256_cmpeq_epi32(_mm256_max_epu32(disk, req_disk), disk));
+			fits = _mm256_andnot_si256(_mm256_cmpeq_epi32(state, unavailable), fits);
+
+			__m256i fit = _mm256_sub_epi32(cores, req_cores);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(fitness + i), fit);
+
+			min = _mm256_min_epu32(min, _mm256_blendv_epi8(ones, fit, fits));
+			max = _mm256_max_epu32(max, _mm256_and_si256(fit, fits));
+			result.mask |= uint64_t(_mm256_movemask_ps(_mm256_castsi256_ps(fits))) << i;
+		}
+
+		uint32_t lanes[8];
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), min);
+		for(auto lane : lanes) if(lane < result.min_fitness) result.min_fitness = lane;
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), max);
+		for(auto lane : lanes) if(lane > result.max_fitness) result.max_fitness = lane;
+
+		scalar_lanes(columns, first, i, count, req, fitness, result);
+
+		const __m256i min_fitness = _mm256_set1_epi32(static_cast<int>(result.min_fitness));
+		const __m256i max_fitness = _mm256_set1_epi32(static_cast<int>(result.max_fitness));
+		size_t j = 0;
+
+		for(; j + 8 <= count; j += 8) {
+			__m256i fit = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(fitness + j));
+			result.min_mask |= uint64_t(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(fit, min_fitness)))) << j;
+			result.max_mask |= uint64_t(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(fit, max_fitness)))) << j;
+		}
+
+		result.min_mask &= result.mask;
+		result.max_mask &= result.mask;
+		scalar_extremes(fitness, j, count, result);
+
+		return result;
+	}
+
+#endif
+
+	struct kernel {
+		const char *name;
+		kernel_fn fn;
+		bool (*supported)();
+	};
+
+	// widest first, so the first supported one is the one to use
+	const kernel kernels[] = {
+#ifdef FIT_KERNELS_X86
+		{ "avx2", fit_avx2, [] { return __builtin_cpu_supports("avx2") != 0; } },
+		{ "sse4.2", fit_sse42, [] { return __builtin_cpu_supports("sse4.2") != 0; } },
+#endif
+		{ "scalar", fit_scalar, [] { return true; } }
+	};
+
+	const kernel *pick() noexcept {
+#ifdef FIT_KERNELS_X86
+		__builtin_cpu_init();
+#endif
+		for(auto &k : kernels) if(k.supported()) return &k;
+		return nullptr; // unreachable, scalar is always supported
+	}
+
+	const kernel *current = nullptr;
+}
+
+fit_result fit_block(const server_columns *columns, size_t first, size_t count, const job_info *job, uint32_t *fitness) noexcept {
+	if(current == nullptr) current = pick();
+
+	constexpr uintmax_t widest = std::numeric_limits<uint32_t>::max();
+
+	// nothing in the columns can hold more than 32 bits, so a bigger job fits nowhere
+	if(job->req_resc.cores > widest || job->req_resc.memory > widest || job->req_resc.disk > widest) {
+		for(size_t i = 0; i < count; ++i) fitness[i] = 0;
+		return empty_result();
+	}
+
+	request req{ static_cast<uint32_t>(job->req_resc.cores), static_cast<uint32_t>(job->req_resc.memory), static_cast<uint32_t>(job->req_resc.disk) };
+
+	return current->fn(columns, first, count, req, fitness);
+}
+
+const char *fit_kernel_name(void) noexcept {
+	if(current == nullptr) current = pick();
+
+	return current->name;
+}
+
+bool fit_kernel_use(const char *name) noexcept {
+	if(current == nullptr) current = pick();
+
+	for(auto &k : kernels) {
+		if(!strcmp(k.name, name)) {
+			if(!k.supported()) return false;
+			current = &k;
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#ifndef fit_kernels_h_
+#define fit_kernels_h_
+
+#include "system_config.h"
+#include "job_info.h"
+
+#ifdef __cplusplus
+#include "cpp_util.h"
+#ifndef EXTERN_C
+#define EXTERN_C
+#define EXTERN_C_fit_kernels_h_
+extern "C" {
+#endif
+#else
+#define noexcept
+#include <stdbool.h>
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+// the most servers fit_block takes at once, one per bit of a mask
+#define FIT_BLOCK 64
+
+// what fit_block found in a block of servers, bit i of each mask standing for server `first + i`
+typedef struct fit_result {
+	uint64_t mask; // servers that aren't unavailable and have the resources to run the job now
+	uint32_t min_fitness; // smallest fitness among `mask`, UINT32_MAX if it's empty
+	uint32_t max_fitness; // largest fitness among `mask`, 0 if it's empty
+	uint64_t min_mask; // servers in `mask` with min_fitness
+	uint64_t max_mask; // servers in `mask` with max_fitness
+} fit_result;
+
+/*
+checks a job against the available resources of servers [first, first + count) in one pass,
+with count at most FIT_BLOCK, and writes each server's available cores less the job's to fitness[i].
+fitness is only meaningful for servers in the mask, where it's the same as job_fitness.
+uses the widest of AVX2, SSE4.2 and plain C the CPU supports, chosen on the first call
+*/
+fit_result fit_block(const server_columns *columns, size_t first, size_t count, const job_info *job, uint32_t *fitness) noexcept;
+
+// the name of the implementation fit_block uses: "avx2", "sse4.2" or "scalar"
+const char *fit_kernel_name(void) noexcept;
+
+// makes fit_block use the named implementation, returning false if the CPU doesn't support it
+bool fit_kernel_use(const char *name) noexcept;
+
+#ifdef __cplusplus
+#ifdef EXTERN_C_fit_kernels_h_
+}
+#undef EXTERN_C_fit_kernels_h_
+#undef EXTERN_C
+#endif
+#else
+#undef noexcept
+#endif
+
+#endif
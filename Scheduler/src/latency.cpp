@@ -0,0 +1,126 @@
+#include "latency.h"
+ASSERT_IS_POD(latency_histogram);
+
+#include <algorithm>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <time.h>
+
+inline namespace {
+
+	constexpr uint64_t subBuckets = uint64_t(1) << LATENCY_SUB_BITS;
+
+	latency_histogram phases[LAT_NUM_PHASES];
+
+	const char *phaseNames[LAT_NUM_PHASES] = { "REDY->JOBN", "parse", "RESC", "LSTJ", "decision", "SCHD->OK" };
+
+	volatile sig_atomic_t reportRequested = 0;
+
+	// the top LATENCY_SUB_BITS + 1 bits of the value pick the bucket, the rest are dropped
+	size_t bucketOf(uint64_t ns) noexcept {
+		if(ns < subBuckets) return static_cast<size_t>(ns);
+
+		unsigned exponent = 63 - static_cast<unsigned>(__builtin_clzll(ns));
+		if(exponent >= LATENCY_MAX_BITS) return LATENCY_BUCKETS - 1;
+
+		unsigned shift = exponent - LATENCY_SUB_BITS;
+		return static_cast<size_t>(((uint64_t(shift) + 1) << LATENCY_SUB_BITS) + (ns >> shift) - subBuckets);
+	}
+
+	// the largest value that lands in a bucket
+	uint64_t highestIn(size_t bucket) noexcept {
+		if(bucket < subBuckets) return bucket;
+		if(bucket == LATENCY_BUCKETS - 1) return UINT64_MAX; // everything too big for the others
+
+		unsigned shift = static_cast<unsigned>(bucket >> LATENCY_SUB_BITS) - 1;
+		uint64_t mantissa = (bucket & (subBuckets - 1)) + subBuckets;
+		return ((mantissa + 1) << shift) - 1;
+	}
+
+	void requestReport(int) {
+		reportRequested = 1;
+	}
+
+	void printMicros(FILE *out, uint64_t ns) {
+		fprintf(out, " %11.1f", static_cast<double>(ns) / 1000);
+	}
+}
+
+uint64_t latency_now(void) noexcept {
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+void histogram_record(latency_histogram *histogram, uint64_t ns) noexcept {
+	++histogram->counts[bucketOf(ns)];
+	++histogram->total;
+	if(ns > histogram->max) histogram->max = ns;
+}
+
+uint64_t histogram_percentile(const latency_histogram *histogram, double percentile) noexcept {
+	if(histogram->total == 0) return 0;
+
+	// the rank of the sample wanted, counting from 1
+	uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100 * static_cast<double>(histogram->total)));
+	if(rank < 1) rank = 1;
+
+	uint64_t seen = 0;
+	for(size_t b = 0; b < LATENCY_BUCKETS; ++b) {
+		seen += histogram->counts[b];
+		if(seen >= rank) return std::min(highestIn(b), histogram->max);
+	}
+
+	return histogram->max;
+}
+
+uint64_t latency_record(latency_phase phase, uint64_t start) noexcept {
+	uint64_t now = latency_now();
+	histogram_record(&phases[phase], now - start);
+
+	return now;
+}
+
+const latency_histogram *latency_of(latency_phase phase) noexcept {
+	return &phases[phase];
+}
+
+void latency_reset(void) noexcept {
+	memset(phases, 0, sizeof phases);
+}
+
+void latency_print(FILE *out) noexcept {
+	fprintf(out, "%-10s %8s %11s %11s %11s %11s\n", "phase (us)", "count", "p50", "p90", "p99", "max");
+
+	for(size_t p = 0; p < LAT_NUM_PHASES; ++p) {
+		const latency_histogram &histogram = phases[p];
+		if(histogram.total == 0) continue;
+
+		fprintf(out, "%-10s %8llu", phaseNames[p], static_cast<unsigned long long>(histogram.total));
+		printMicros(out, histogram_percentile(&histogram, 50));
+		printMicros(out, histogram_percentile(&histogram, 90));
+		printMicros(out, histogram_percentile(&histogram, 99));
+		printMicros(out, histogram.max);
+		fputc('\n', out);
+	}
+
+	fflush(out);
+}
+
+void latency_report_on(int signum) noexcept {
+	struct sigaction action;
+	memset(&action, 0, sizeof action);
+	action.sa_handler = requestReport;
+	action.sa_flags = SA_RESTART; // a blocking receive carries on, and the report waits for the next job
+	sigemptyset(&action.sa_mask);
+	sigaction(signum, &action, nullptr);
+}
+
+void latency_poll(FILE *out) noexcept {
+	if(!reportRequested) return;
+
+	reportRequested = 0;
+	latency_print(out);
+}
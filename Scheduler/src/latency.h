@@ -0,0 +1,87 @@
+#pragma once
+#ifndef latency_h_
+#define latency_h_
+
+#ifdef __cplusplus
+#include "cpp_util.h"
+#ifndef EXTERN_C
+#define EXTERN_C
+#define EXTERN_C_latency_h_
+extern "C" {
+#endif
+#else
+#define noexcept
+#include <stdbool.h>
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// values below 2^LATENCY_SUB_BITS get a bucket each, above that every power of two is split into that many buckets
+#define LATENCY_SUB_BITS 5
+// values of 2^LATENCY_MAX_BITS nanoseconds (about 18 minutes) and up go to a last bucket of their own
+#define LATENCY_MAX_BITS 40
+#define LATENCY_BUCKETS (((LATENCY_MAX_BITS - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS) + 1)
+
+/*
+a log-bucketed histogram of nanosecond durations, in the style of HdrHistogram.
+each bucket is at most 1/32 of its value wide, so percentiles are within about 3% of the
+true value, and recording a sample is a bit scan and an increment, with nothing allocated.
+a zeroed histogram is empty
+*/
+typedef struct latency_histogram {
+	uint64_t counts[LATENCY_BUCKETS];
+	uint64_t total; // number of samples recorded
+	uint64_t max; // largest sample recorded, exactly
+} latency_histogram;
+
+// the phases of handling one job in run_algorithm
+typedef enum latency_phase {
+	LAT_WAIT, // from sending REDY until the job arrives
+	LAT_PARSE, // parsing the JOBN
+	LAT_RESC, // the RESC exchange of a full refresh
+	LAT_LSTJ, // the LSTJ exchanges of a full refresh, or of checking the chosen server between refreshes
+	LAT_DECISION, // choosing a server
+	LAT_SCHD, // from sending SCHD until the OK arrives, placing the job in the model in between
+	LAT_NUM_PHASES
+} latency_phase;
+
+// a monotonic timestamp in nanoseconds
+uint64_t latency_now(void) noexcept;
+
+// adds a sample to a histogram
+void histogram_record(latency_histogram *histogram, uint64_t ns) noexcept;
+
+// the smallest recorded value that `percentile` percent of samples are at or below, 0 if there are none
+uint64_t histogram_percentile(const latency_histogram *histogram, double percentile) noexcept;
+
+// records the time since `start` against a phase, and returns the time now so phases can be chained
+uint64_t latency_record(latency_phase phase, uint64_t start) noexcept;
+
+// the process-wide histogram for a phase
+const latency_histogram *latency_of(latency_phase phase) noexcept;
+
+// empties every phase's histogram
+void latency_reset(void) noexcept;
+
+// writes count, p50, p90, p99 and max for every phase that has samples
+void latency_print(FILE *out) noexcept;
+
+// makes `signum` request a report, which is written by the next latency_poll rather than in the handler
+void latency_report_on(int signum) noexcept;
+
+// writes a report if one was requested since the last poll
+void latency_poll(FILE *out) noexcept;
+
+#ifdef __cplusplus
+#ifdef EXTERN_C_latency_h_
+}
+#undef EXTERN_C_latency_h_
+#undef EXTERN_C
+#endif
+#else
+#undef noexcept
+#endif
+
+#endif
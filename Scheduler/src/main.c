@@ -1,15 +1,23 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <signal.h>
 #include "socket_client.h"
 #include "system_config.h"
 #include "algorithms.h"
+#include "cost_fit.h"
+#include "adaptive.h"
+#include "latency.h"
 
 void usage(char *name);
 
 int main(int argc, char **argv) {
 	//server_info *(*algorithm)(system_config*,server_group*,job_info) = &all_to_largest;
-	algorithm_t a = ALL_TO_LARGEST;
+	run_options options = { ALL_TO_LARGEST, 1, 1, 1, 0, COST_WEIGHT, { ADAPTIVE_QUEUE, ADAPTIVE_FREE, ADAPTIVE_LOAD }, NULL, 0 };
+	bool newline = false;
+	const char *record_path = NULL; // record the session to this trace
+	const char *replay_path = NULL; // replay this trace instead of connecting to a server
+	bool event_loop = false; // run on the coroutine client, see async_client.h
 
 	int i;
 	for (i = 1; i < argc; i++) {
@@ -18,19 +26,84 @@ int main(int argc, char **argv) {
 				case 'a':
 					i++;
 					if(strcmp(argv[i], "ff") == 0)
-						a = FIRST_FIT;
+						options.algorithm = FIRST_FIT;
 					//algorithm = &first_fit;
 					else if(strcmp(argv[i], "bf") == 0)
-						a = BEST_FIT;
+						options.algorithm = BEST_FIT;
 					//algorithm = &best_fit;
 					else if(strcmp(argv[i], "wf") == 0)
-						a = WORST_FIT;
+						options.algorithm = WORST_FIT;
 					//algorithm = &worst_fit;
 					else if(strcmp(argv[i], "pf") == 0)
-						a = PREDICTIVE_FIT;
+						options.algorithm = PREDICTIVE_FIT;
+					else if(strcmp(argv[i], "bf-easy") == 0)
+						options.algorithm = EASY_BACKFILL;
+					else if(strcmp(argv[i], "cost") == 0)
+						options.algorithm = COST_FIT;
+					else if(strcmp(argv[i], "adaptive") == 0)
+						options.algorithm = ADAPTIVE_FIT;
 					else
 						fprintf(stderr, "algorithm not implemented: %s\n", argv[i]);
 					break;
+				case 'n':
+					newline = true;
+					break;
+				case 's':
+					i++;
+					options.sync_interval = strtoul(argv[i], NULL, 10);
+					if (options.sync_interval == 0)
+						usage(argv[0]);
+					break;
+				case 'j':
+					i++;
+					options.threads = strtoul(argv[i], NULL, 10);
+					if (options.threads == 0)
+						usage(argv[0]);
+					break;
+				case 'b':
+					i++;
+					options.batch_size = strtoul(argv[i], NULL, 10);
+					if (options.batch_size == 0)
+						usage(argv[0]);
+					break;
+				case 'w':
+					i++;
+					options.batch_window = strtoul(argv[i], NULL, 10);
+					break;
+				case 'c':
+					i++;
+					options.cost_weight = strtod(argv[i], NULL);
+					if (!(options.cost_weight >= 0 && options.cost_weight <= 1))
+						usage(argv[0]);
+					break;
+				case 't':
+					i++;
+					if (sscanf(argv[i], "%lf,%lf,%lf", &options.thresholds.queue, &options.thresholds.free, &options.thresholds.load) != 3)
+						usage(argv[0]);
+					break;
+				case 'm':
+					i++;
+					options.runtime_path = argv[i];
+					break;
+				case 'p':
+					i++;
+					options.preboot = strtod(argv[i], NULL);
+					if (!(options.preboot >= 0))
+						usage(argv[0]);
+					break;
+				case 'r':
+					i++;
+					record_path = argv[i];
+					break;
+				case 'R':
+					i++;
+					replay_path = argv[i];
+					break;
+#ifdef USE_ASYNC
+				case 'e':
+					event_loop = true;
+					break;
+#endif
 				default:
 					usage(argv[0]);
 			}
@@ -39,16 +112,42 @@ int main(int argc, char **argv) {
 		}
 	}
 
-	socket_client *client = client_init(LOCALHOST, DEFAULT_PORT);
+	if (event_loop && (record_path || replay_path || options.batch_size > 1)) {
+		fprintf(stderr, "-e places each job as it arrives, and can't record or replay a trace\n");
+		usage(argv[0]);
+	}
+
+	socket_client *client;
+	if (replay_path) {
+		client = client_replay(replay_path);
+		if (!client)
+			return 1;
+	} else {
+		client = client_init(LOCALHOST, DEFAULT_PORT, newline, record_path);
+	}
+
+	// kill -USR1 reports the time spent in each phase so far, and the whole session is reported at QUIT
+	latency_report_on(SIGUSR1);
 
 	//run_algorithm(client, algorithm);
-	run_algorithm(client, a);
+#ifdef USE_ASYNC
+	if (event_loop)
+		run_algorithm_async(client, options);
+	else
+#endif
+	run_algorithm(client, options);
+	client_free(client);
+	latency_print(stderr);
 
 	return 0;
 }
 
 void usage(char *name) {
-	printf("%s%s\n", name, " [-a ALGORITHM]");
+#ifdef USE_ASYNC
+	printf("%s%s\n", name, " [-a ALGORITHM] [-n] [-s INTERVAL] [-j THREADS] [-b JOBS [-w WINDOW]] [-c WEIGHT] [-t QUEUE,FREE,LOAD] [-m MODEL] [-p HORIZON] [-r TRACE | -R TRACE | -e]");
+#else
+	printf("%s%s\n", name, " [-a ALGORITHM] [-n] [-s INTERVAL] [-j THREADS] [-b JOBS [-w WINDOW]] [-c WEIGHT] [-t QUEUE,FREE,LOAD] [-m MODEL] [-p HORIZON] [-r TRACE | -R TRACE]");
+#endif
 	exit(1);
 }
 
@@ -0,0 +1,124 @@
+#include "preboot.h"
+#include "arrivals.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+inline namespace {
+
+	// the index of the type with the fewest cores, then memory, then disk, that can run the job, or num_types if none can
+	size_t type_for(const system_config *config, const job_info &job) noexcept {
+		size_t best = config->num_types;
+		for(size_t t = 0; t < config->num_types; ++t) {
+			const resource_info &max = config->types[t].max_resc;
+			if(!job.can_run(max)) continue;
+			if(best == config->num_types) {
+				best = t;
+				continue;
+			}
+
+			const resource_info &cur = config->types[best].max_resc;
+			if(max.cores != cur.cores ? max.cores < cur.cores : max.memory != cur.memory ? max.memory < cur.memory : max.disk < cur.disk) best = t;
+		}
+		return best;
+	}
+
+	// the cores free on the type's servers that are up or booting, those with jobs waiting having none to spare
+	uintmax_t ready_cores(const system_config *config, size_t t) noexcept {
+		const server_columns &columns = config->columns;
+		uintmax_t cores = 0;
+		for(size_t s = config->type_offsets[t]; s < config->type_offsets[t + 1]; ++s) {
+			if(columns.state[s] == SS_INACTIVE || columns.state[s] == SS_UNAVAILABLE || config->servers[s].num_waiting > 0) continue;
+			cores += columns.cores[s];
+		}
+		return cores;
+	}
+}
+
+struct boot_forecast {
+	double horizon;
+	FILE *log;
+	arrival_rate jobs; // every job taken in, sized by its cores
+	std::vector<arrival_rate> types; // the jobs whose smallest fitting type it is, parallel to system_config.types
+	size_t boots;
+	server_info *started; // the server started for the last job taken in, if one was
+};
+
+boot_forecast *boot_forecast_create(const system_config *config, double horizon, FILE *log) noexcept {
+	try {
+		boot_forecast *forecast = new boot_forecast();
+		forecast->horizon = horizon;
+		forecast->log = log;
+		forecast->types.resize(config->num_types);
+		return forecast;
+
+	} catch(...) {
+
+		return nullptr;
+	}
+}
+
+bool boot_forecast_observe(boot_forecast *forecast, const system_config *config, job_info job) noexcept {
+	double cores = static_cast<double>(job.req_resc.cores);
+	if(!arrival_observe(&forecast->jobs, job, cores)) return false;
+
+	size_t t = type_for(config, job);
+	if(t != config->num_types) arrival_observe(&forecast->types[t], job, cores);
+	forecast->started = nullptr;
+	return true;
+}
+
+double boot_forecast_demand(const boot_forecast *forecast, const system_config *config, const server_type *type, intmax_t now) noexcept {
+	const arrival_rate &rate = forecast->types[static_cast<size_t>(type - config->types)];
+	if(rate.seen < 2) return 0;
+
+	// only jobs that are expected to arrive in full count, a fraction of one is no reason to start a server
+	return std::floor(forecast->horizon * static_cast<double>(type->bootTime) / arrival_gap(&rate, now)) * rate.size;
+}
+
+server_info *preboot(boot_forecast *forecast, system_config *config, job_info job, server_info *choice) noexcept {
+	// a job asked about again after a refresh gets the same answer, and its server isn't counted or logged again
+	if(!boot_forecast_observe(forecast, config, job)) return forecast->started != nullptr && forecast->started->state == SS_INACTIVE ? forecast->started : choice;
+
+	// a job that has to wait for its server, booting or otherwise, isn't the one to start another
+	if(choice == nullptr || (choice->state != SS_IDLE && choice->state != SS_ACTIVE) || !job.can_run(choice->avail_resc) || choice->num_waiting > 0) return choice;
+
+	size_t t = type_for(config, job);
+	if(t == config->num_types) return choice;
+
+	const server_type *type = &config->types[t];
+	intmax_t now = static_cast<intmax_t>(job.submit_time);
+	double demand = boot_forecast_demand(forecast, config, type, now);
+
+	// the job takes its cores from what's ready if it goes where it was going
+	uintmax_t ready = ready_cores(config, t);
+	if(choice->type == type) ready -= std::min(ready, job.req_resc.cores);
+	if(demand <= static_cast<double>(ready)) return choice;
+
+	const server_columns &columns = config->columns;
+	for(size_t s = config->type_offsets[t]; s < config->type_offsets[t + 1]; ++s) {
+		if(columns.state[s] != SS_INACTIVE) continue;
+
+		server_info *server = &config->servers[s];
+		forecast->started = server;
+		++forecast->boots;
+		if(forecast->log != nullptr) {
+			fprintf(forecast->log, "preboot: job %ju at %ju starts %s %zu (forecast %.1f cores, %ju ready)\n",
+				job.id, job.submit_time, type->name, server->id, demand, ready);
+		}
+		return server;
+	}
+
+	return choice;
+}
+
+void boot_forecast_print(const boot_forecast *forecast, FILE *out) noexcept {
+	fprintf(out, "# preboot: %zu servers started ahead of demand over %zu jobs\n", forecast->boots, forecast->jobs.seen);
+	fflush(out);
+}
+
+void boot_forecast_free(boot_forecast *forecast) noexcept {
+	delete forecast;
+}
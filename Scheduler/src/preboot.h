@@ -0,0 +1,57 @@
+#pragma once
+#ifndef preboot_h_
+#define preboot_h_
+
+#ifdef __cplusplus
+#include "cpp_util.h"
+#ifndef EXTERN_C
+#define EXTERN_C
+#define EXTERN_C_preboot_h_
+extern "C" {
+#endif
+#else
+#define noexcept
+#include <stdbool.h>
+#endif
+
+#include <stdio.h>
+#include "algorithms.h"
+
+/*
+forecasts the cores each server type will be asked for over the next `horizon` of its boot times, counting the jobs expected in full
+at the rate jobs whose smallest fitting type it is have been arriving at, smoothed over recent jobs. when the forecast is more than
+the type's servers that are up or booting have free, a job that could start now is sent to one of its inactive servers instead, so
+the server is up by the time the rest arrive. ds-server has no way to start a server without a job, so that job pays the boot time.
+hung off system_config.context.forecast, without one servers are only started when a job needs one
+*/
+typedef struct boot_forecast boot_forecast;
+
+// each server started early is written to `log`, which may be null; null if it can't be allocated
+boot_forecast *boot_forecast_create(const system_config *config, double horizon, FILE *log) noexcept;
+
+// takes in the job's arrival, once a job however often it's asked, returning false if it's been taken in already
+bool boot_forecast_observe(boot_forecast *forecast, const system_config *config, job_info job) noexcept;
+
+// the cores forecast to be asked of servers of `type` over the horizon from `now`, 0 until two of its jobs have arrived
+double boot_forecast_demand(const boot_forecast *forecast, const system_config *config, const server_type *type, intmax_t now) noexcept;
+
+// takes in the job, and returns the inactive server to start early for it, or `choice` if the servers that are up will do.
+//.. a job asked about again is given the server it was given the first time, if that's still inactive
+server_info *preboot(boot_forecast *forecast, system_config *config, job_info job, server_info *choice) noexcept;
+
+// writes how many servers were started early
+void boot_forecast_print(const boot_forecast *forecast, FILE *out) noexcept;
+
+void boot_forecast_free(boot_forecast *forecast) noexcept;
+
+#ifdef __cplusplus
+#ifdef EXTERN_C_preboot_h_
+}
+#undef EXTERN_C_preboot_h_
+#undef EXTERN_C
+#endif
+#else
+#undef noexcept
+#endif
+
+#endif
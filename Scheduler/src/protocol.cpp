@@ -0,0 +1,162 @@
+#include "protocol.h"
+ASSERT_IS_POD(str_view);
+ASSERT_IS_POD(resc_row);
+ASSERT_IS_POD(lstj_row);
+ASSERT_IS_POD(parse_error);
+
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+inline namespace {
+
+	/*
+	single pass over a message, reading one space-separated token at a time.
+	nothing is copied or allocated, integers are accumulated straight from the characters,
+	and the first failure records what was expected and where.
+	*/
+	struct tokenizer {
+		const char *start;
+		const char *pos;
+		parse_error *error;
+
+		bool fail(const char *reason) noexcept {
+			error->reason = reason;
+			error->column = static_cast<size_t>(pos - start);
+
+			return false;
+		}
+
+		// every token after the first must be separated from the last by at least one space
+		bool separator() noexcept {
+			if(*pos != ' ') return fail("expected a space");
+
+			while(*pos == ' ') ++pos;
+
+			return true;
+		}
+
+		bool word(str_view *dest) noexcept {
+			const char *begin = pos;
+
+			while(*pos != ' ' && *pos != '\0') ++pos;
+
+			if(pos == begin) return fail("expected a word");
+
+			*dest = str_view{ begin, static_cast<size_t>(pos - begin) };
+
+			return true;
+		}
+
+		bool keyword(const char *expected) noexcept {
+			size_t len = strlen(expected);
+
+			if(strncmp(pos, expected, len) || (pos[len] != ' ' && pos[len] != '\0')) return fail("unexpected message type");
+
+			pos += len;
+
+			return true;
+		}
+
+		bool unsigned_int(uintmax_t *dest) noexcept {
+			constexpr uintmax_t max = std::numeric_limits<uintmax_t>::max();
+			uintmax_t value = 0;
+
+			if(*pos < '0' || *pos > '9') return fail("expected an unsigned integer");
+
+			for(; *pos >= '0' && *pos <= '9'; ++pos) {
+				uintmax_t digit = static_cast<uintmax_t>(*pos - '0');
+
+				if(value > (max - digit) / 10) return fail("integer is too large");
+
+				value = value * 10 + digit;
+			}
+
+			if(*pos != ' ' && *pos != '\0') return fail("expected an unsigned integer");
+
+			*dest = value;
+
+			return true;
+		}
+
+		bool signed_int(intmax_t *dest) noexcept {
+			bool negative = *pos == '-';
+			uintmax_t magnitude;
+
+			if(negative) ++pos;
+
+			if(*pos < '0' || *pos > '9') return fail("expected an integer");
+
+			if(!unsigned_int(&magnitude)) return false;
+
+			if(magnitude > static_cast<uintmax_t>(std::numeric_limits<intmax_t>::max())) return fail("integer is too large");
+
+			*dest = negative ? -static_cast<intmax_t>(magnitude) : static_cast<intmax_t>(magnitude);
+
+			return true;
+		}
+
+		bool resources(resource_info *dest) noexcept {
+			return separator() && unsigned_int(&dest->cores)
+				&& separator() && unsigned_int(&dest->memory)
+				&& separator() && unsigned_int(&dest->disk);
+		}
+
+		bool end() noexcept {
+			while(*pos == ' ') ++pos;
+
+			return *pos == '\0' || fail("expected the end of the message");
+		}
+	};
+}
+
+message_type message_type_of(const char *msg) noexcept {
+
+	switch(msg[0]) {
+		case 'O': if(!strcmp(msg, "OK")) return MSG_OK; break;
+		case 'E': if(!strncmp(msg, "ERR", 3)) return MSG_ERR; break;
+		case 'N': if(!strcmp(msg, "NONE")) return MSG_NONE; break;
+		case '.': if(msg[1] == '\0') return MSG_END; break;
+		case 'D': if(!strcmp(msg, "DATA")) return MSG_DATA; break;
+		case 'J': if(!strncmp(msg, "JOBN", 4) && (msg[4] == ' ' || msg[4] == '\0')) return MSG_JOBN; break;
+	}
+
+	return MSG_OTHER;
+}
+
+bool parse_job(const char *msg, job_info *job, parse_error *error) noexcept {
+	tokenizer tok{ msg, msg, error };
+
+	return tok.keyword("JOBN")
+		&& tok.separator() && tok.unsigned_int(&job->submit_time)
+		&& tok.separator() && tok.unsigned_int(&job->id)
+		&& tok.separator() && tok.unsigned_int(&job->est_runtime)
+		&& tok.resources(&job->req_resc)
+		&& tok.end();
+}
+
+bool parse_resc_row(const char *msg, resc_row *row, parse_error *error) noexcept {
+	tokenizer tok{ msg, msg, error };
+
+	return tok.word(&row->type_name)
+		&& tok.separator() && tok.unsigned_int(&row->id)
+		&& tok.separator() && tok.signed_int(&row->state)
+		&& tok.separator() && tok.signed_int(&row->avail_time)
+		&& tok.resources(&row->avail_resc)
+		&& tok.end();
+}
+
+bool parse_lstj_row(const char *msg, lstj_row *row, parse_error *error) noexcept {
+	tokenizer tok{ msg, msg, error };
+
+	return tok.unsigned_int(&row->schd.job_id)
+		&& tok.separator() && tok.signed_int(&row->job_state)
+		&& tok.separator() && tok.signed_int(&row->schd.start_time)
+		&& tok.separator() && tok.unsigned_int(&row->schd.est_runtime)
+		&& tok.resources(&row->schd.req_resc)
+		&& tok.end();
+}
+
+void report_parse_error(const char *msg, const parse_error *error) noexcept {
+	fprintf(stderr, "Bad message: %s at column %zu\n\t%s\n\t%*s^\n", error->reason, error->column, msg, static_cast<int>(error->column), "");
+}
@@ -0,0 +1,86 @@
+#pragma once
+#ifndef protocol_h_
+#define protocol_h_
+
+#include "resource_info.h"
+#include "job_info.h"
+
+#ifdef __cplusplus
+#include "cpp_util.h"
+#ifndef EXTERN_C
+#define EXTERN_C
+#define EXTERN_C_protocol_h_
+extern "C" {
+#endif
+#else
+#define noexcept
+#include <stdbool.h>
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+// a section of a message, not null-terminated
+typedef struct str_view {
+	const char *str; // first character of the section
+	size_t len; // number of characters in the section
+} str_view;
+
+// the kinds of message the server can send, decided by the first word
+typedef enum message_type {
+	MSG_OK, // "OK"
+	MSG_ERR, // "ERR" or "ERR: <reason>"
+	MSG_NONE, // "NONE", there are no more jobs
+	MSG_END, // ".", the end of a `RESC` or `LSTJ` response
+	MSG_DATA, // "DATA", the start of a `RESC` or `LSTJ` response
+	MSG_JOBN, // "JOBN ...", a new job
+	MSG_OTHER // anything else, such as a row of a `RESC` or `LSTJ` response
+} message_type;
+
+// a row of a `RESC` response, "<type> <id> <state> <avail_time> <cores> <memory> <disk>"
+typedef struct resc_row {
+	str_view type_name; // view into the message the row was parsed from
+	uintmax_t id;
+	intmax_t state;
+	intmax_t avail_time;
+	resource_info avail_resc;
+} resc_row;
+
+// a row of an `LSTJ` response, "<job_id> <job_state> <start_time> <est_runtime> <cores> <memory> <disk>"
+typedef struct lstj_row {
+	intmax_t job_state;
+	schd_info schd;
+} lstj_row;
+
+// where and why a message couldn't be parsed
+typedef struct parse_error {
+	const char *reason; // what was expected at `column`, always a string literal
+	size_t column; // offset from the start of the message
+} parse_error;
+
+// classifies a message by its first word
+message_type message_type_of(const char *msg) noexcept;
+
+// parses "JOBN <submit_time> <id> <est_runtime> <cores> <memory> <disk>", returning false and filling `error` if malformed
+bool parse_job(const char *msg, job_info *job, parse_error *error) noexcept;
+
+// parses a row of a `RESC` response, returning false and filling `error` if malformed
+bool parse_resc_row(const char *msg, resc_row *row, parse_error *error) noexcept;
+
+// parses a row of an `LSTJ` response, returning false and filling `error` if malformed
+bool parse_lstj_row(const char *msg, lstj_row *row, parse_error *error) noexcept;
+
+// logs a parse_error to stderr, pointing at the offending column of the message
+void report_parse_error(const char *msg, const parse_error *error) noexcept;
+
+#ifdef __cplusplus
+#ifdef EXTERN_C_protocol_h_
+}
+#undef EXTERN_C_protocol_h_
+#undef EXTERN_C
+#endif
+#else
+#undef noexcept
+#endif
+
+#endif
@@ -27,4 +27,8 @@ bool operator!=(const resource_info &lhs, const resource_info &rhs)  noexcept {
 
 resource_info operator+(const resource_info &lhs, const resource_info &rhs) noexcept {
 	return resource_info{lhs.cores + rhs.cores, lhs.memory + rhs.memory, lhs.disk + rhs.disk};
+};
+
+resource_info operator-(const resource_info &lhs, const resource_info &rhs) noexcept {
+	return resource_info{lhs.cores - rhs.cores, lhs.memory - rhs.memory, lhs.disk - rhs.disk};
 };
\ No newline at end of file
@@ -0,0 +1,231 @@
+#include "runtime_model.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+inline namespace {
+
+	// a group of jobs' correction, the mean of log(actual / estimated runtime)
+	struct correction {
+		size_t samples;
+		double log_ratio;
+	};
+
+	// a group with fewer jobs than this defers to a wider one
+	constexpr size_t MIN_SAMPLES = 3;
+
+	// a group's mean is over every job until it has this many, then each new job counts for this share of it
+	constexpr size_t WINDOW = 32;
+
+	// a job that's gone is only learned from when the time since it was last seen running is at most this share of how long it had run by then,
+	//.. so taking it to have finished halfway between is off by at most half this share. a longer gap says more about how often refreshes happen than how long the job took
+	constexpr double MAX_GAP = 0.1;
+
+	// keys have the powers of two of cores, memory, disk and estimated runtime in 5 bits each, and the kind of group above them
+	constexpr uint32_t BY_SHAPE = 0, BY_RUNTIME = 1u << 20, BY_NOTHING = 2u << 20;
+
+	uint32_t bits(uintmax_t value) noexcept {
+		uint32_t width = 0;
+		for(; value != 0 && width < 31; value >>= 1) ++width;
+		return width;
+	}
+
+	uint32_t runtime_key(uintmax_t est_runtime) noexcept {
+		return BY_RUNTIME | bits(est_runtime) << 15;
+	}
+
+	uint32_t shape_key(const resource_info &req, uintmax_t est_runtime) noexcept {
+		return BY_SHAPE | bits(req.cores) | bits(req.memory) << 5 | bits(req.disk) << 10 | bits(est_runtime) << 15;
+	}
+
+	// a job seen running at a refresh
+	struct running_job {
+		intmax_t start;
+		intmax_t last_seen; // the last refresh it was running at
+		uintmax_t est_runtime;
+		resource_info req;
+		size_t server; // index in system_config.servers
+		size_t refresh; // the last refresh it was listed in
+	};
+
+	const char HEADER[] = "# runtime corrections: key samples mean_log_ratio\n";
+}
+
+struct runtime_model {
+	std::unordered_map<uint32_t, correction> corrections;
+	std::unordered_map<uintmax_t, running_job> running; // by job id
+	size_t refreshes = 0;
+	size_t observed = 0;
+	size_t generation = 1; // changes with every correction, so a simulation knows when it was run on old ones
+
+	void learn(uint32_t key, double log_ratio) {
+		++generation;
+		correction &c = corrections[key];
+		++c.samples;
+		c.log_ratio += (log_ratio - c.log_ratio) / static_cast<double>(std::min(c.samples, WINDOW));
+	}
+
+	const correction *find(uint32_t key) const {
+		auto it = corrections.find(key);
+		return it != corrections.end() && it->second.samples >= MIN_SAMPLES ? &it->second : nullptr;
+	}
+};
+
+runtime_model *runtime_model_create(void) noexcept {
+	try {
+		return new runtime_model();
+
+	} catch(...) {
+
+		return nullptr;
+	}
+}
+
+runtime_model *runtime_model_load(const char *path) noexcept {
+	FILE *file = fopen(path, "r");
+	if(file == nullptr && errno == ENOENT) return runtime_model_create();
+	if(file == nullptr) {
+		fprintf(stderr, "unable to read runtime corrections from %s: %s\n", path, strerror(errno));
+		return nullptr;
+	}
+
+	runtime_model *model = runtime_model_create();
+	char line[128];
+	size_t number = 0;
+
+	while(model != nullptr && fgets(line, sizeof line, file) != nullptr) {
+		++number;
+		if(line[0] == '#' || line[0] == '\n') continue;
+
+		unsigned long key;
+		unsigned long long samples;
+		double log_ratio;
+		if(sscanf(line, "%lx %llu %lf", &key, &samples, &log_ratio) != 3 || !std::isfinite(log_ratio)) {
+			fprintf(stderr, "malformed runtime correction on line %zu of %s\n", number, path);
+			runtime_model_free(model);
+			model = nullptr;
+			break;
+		}
+
+		try {
+			model->corrections[static_cast<uint32_t>(key)] = correction{ static_cast<size_t>(samples), log_ratio };
+
+		} catch(...) {
+
+			runtime_model_free(model);
+			model = nullptr;
+		}
+	}
+
+	fclose(file);
+	return model;
+}
+
+bool runtime_model_save(const runtime_model *model, const char *path) noexcept {
+	FILE *file = fopen(path, "w");
+	if(file == nullptr) {
+		fprintf(stderr, "unable to write runtime corrections to %s: %s\n", path, strerror(errno));
+		return false;
+	}
+
+	// in order of key, so saves of the same model are the same file
+	std::vector<std::pair<uint32_t, correction>> entries;
+	try {
+		entries.assign(model->corrections.begin(), model->corrections.end());
+	} catch(...) {}
+	std::sort(entries.begin(), entries.end(), [](const std::pair<uint32_t, correction> &lhs, const std::pair<uint32_t, correction> &rhs) { return lhs.first < rhs.first; });
+
+	fputs(HEADER, file);
+	for(auto &entry : entries) fprintf(file, "%06lx %zu %.17g\n", static_cast<unsigned long>(entry.first), entry.second.samples, entry.second.log_ratio);
+
+	if(fclose(file) != 0) {
+		fprintf(stderr, "unable to write runtime corrections to %s: %s\n", path, strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+void runtime_model_observe(runtime_model *model, resource_info req, uintmax_t est_runtime, uintmax_t runtime) noexcept {
+	if(est_runtime == 0) return;
+
+	double log_ratio = std::log(static_cast<double>(std::max<uintmax_t>(runtime, 1)) / static_cast<double>(est_runtime));
+
+	try {
+		model->learn(shape_key(req, est_runtime), log_ratio);
+		model->learn(runtime_key(est_runtime), log_ratio);
+		model->learn(BY_NOTHING, log_ratio);
+		++model->observed;
+
+	} catch(...) {}
+}
+
+uintmax_t runtime_model_correct(const runtime_model *model, resource_info req, uintmax_t est_runtime) noexcept {
+	if(est_runtime == 0) return 0;
+
+	const correction *c = model->find(shape_key(req, est_runtime));
+	if(c == nullptr) c = model->find(runtime_key(est_runtime));
+	if(c == nullptr) c = model->find(BY_NOTHING);
+	if(c == nullptr) return est_runtime;
+
+	double corrected = std::round(static_cast<double>(est_runtime) * std::exp(c->log_ratio));
+	return corrected < 1 ? 1 : corrected >= static_cast<double>(INTMAX_MAX / 2) ? static_cast<uintmax_t>(INTMAX_MAX / 2) : static_cast<uintmax_t>(corrected);
+}
+
+void runtime_model_refresh(runtime_model *model, const system_config *config, intmax_t now) noexcept {
+	size_t refresh = ++model->refreshes;
+
+	try {
+		for(size_t s = 0; s < config->num_servers; ++s) {
+			const server_info &server = config->servers[s];
+			if(server.state == SS_UNAVAILABLE) continue;
+
+			for(size_t j = 0; j < server.num_jobs; ++j) {
+				const schd_info &schd = server.jobs[j];
+				if(!~schd.start_time) continue;
+
+				// a job that's started again, after its server failed, replaces its first run
+				model->running[schd.job_id] = running_job{ schd.start_time, now, schd.est_runtime, schd.req_resc, s, refresh };
+			}
+		}
+
+	} catch(...) {}
+
+	for(auto it = model->running.begin(); it != model->running.end();) {
+		const running_job &job = it->second;
+		if(job.refresh == refresh) {
+			++it;
+			continue;
+		}
+
+		// a job that went with its server didn't finish, and one last seen too long ago could have finished any time since, so there's nothing to learn from either
+		intmax_t gap = now - job.last_seen;
+		if(config->servers[job.server].state != SS_UNAVAILABLE && static_cast<double>(gap) <= MAX_GAP * static_cast<double>(job.last_seen - job.start)) {
+			intmax_t finish = job.last_seen + gap / 2;
+			runtime_model_observe(model, job.req, job.est_runtime, static_cast<uintmax_t>(std::max<intmax_t>(finish - job.start, 1)));
+		}
+		it = model->running.erase(it);
+	}
+}
+
+size_t runtime_model_observed(const runtime_model *model) noexcept {
+	return model->observed;
+}
+
+size_t runtime_model_generation(const runtime_model *model) noexcept {
+	return model->generation;
+}
+
+void runtime_model_free(runtime_model *model) noexcept {
+	delete model;
+}
+
+uintmax_t expected_runtime(const server_info *server, const schd_info *schd) noexcept {
+	if(server->owner == nullptr || server->owner->context.runtimes == nullptr) return schd->est_runtime;
+	return runtime_model_correct(server->owner->context.runtimes, schd->req_resc, schd->est_runtime);
+}
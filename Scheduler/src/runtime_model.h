@@ -0,0 +1,76 @@
+#pragma once
+#ifndef runtime_model_h_
+#define runtime_model_h_
+
+#include "resource_info.h"
+#include "job_info.h"
+#include "system_config.h"
+
+#ifdef __cplusplus
+#include "cpp_util.h"
+#ifndef EXTERN_C
+#define EXTERN_C
+#define EXTERN_C_runtime_model_h_
+extern "C" {
+#endif
+#else
+#define noexcept
+#include <stdbool.h>
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+how far off the estimated runtimes turn out to be, learned from the jobs seen to finish.
+jobs are grouped by shape, the power of two their cores, memory, disk and estimated runtime fall in,
+and each group keeps the mean of the log of actual over estimated runtime, weighting recent jobs more once it has plenty.
+a group with too few jobs to go on falls back to every job with that estimated runtime, then to every job.
+hung off system_config.context.runtimes, and while it is the simulations of the servers' jobs use the corrected runtimes
+*/
+typedef struct runtime_model runtime_model;
+
+// a model with nothing learned; null if it can't be allocated
+runtime_model *runtime_model_create(void) noexcept;
+
+// a model saved by runtime_model_save, or one with nothing learned if there's no such file; null and logs to stderr if it can't be read
+runtime_model *runtime_model_load(const char *path) noexcept;
+
+// writes what's been learned to `path`, one line per group, returning false and logging to stderr on failure
+bool runtime_model_save(const runtime_model *model, const char *path) noexcept;
+
+// learns from a job that took `runtime` against its estimate
+void runtime_model_observe(runtime_model *model, resource_info req, uintmax_t est_runtime, uintmax_t runtime) noexcept;
+
+// the estimate corrected by what's been learned of jobs of its shape, never less than 1 unless it was 0
+uintmax_t runtime_model_correct(const runtime_model *model, resource_info req, uintmax_t est_runtime) noexcept;
+
+/*
+for after a full refresh at `now`, when every server's jobs are as LSTJ listed them: a job that was running at the last refresh
+and has gone since is taken to have finished halfway between the two, and is learned from if the refreshes were close enough
+together, next to how long it had been running, for that to be near the truth
+*/
+void runtime_model_refresh(runtime_model *model, const system_config *config, intmax_t now) noexcept;
+
+// how many jobs have been learned from
+size_t runtime_model_observed(const runtime_model *model) noexcept;
+
+// changes whenever anything is learned, and is never 0, so a simulation run on the model's corrections can tell when they've changed
+size_t runtime_model_generation(const runtime_model *model) noexcept;
+
+void runtime_model_free(runtime_model *model) noexcept;
+
+// how long a job on a server is expected to run, corrected by its owner's model if it has one
+uintmax_t expected_runtime(const server_info *server, const schd_info *schd) noexcept;
+
+#ifdef __cplusplus
+#ifdef EXTERN_C_runtime_model_h_
+}
+#undef EXTERN_C_runtime_model_h_
+#undef EXTERN_C
+#endif
+#else
+#undef noexcept
+#endif
+
+#endif
@@ -0,0 +1,216 @@
+#include "skyline.h"
+#include "runtime_model.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+inline namespace {
+
+	// a job running in the simulation, which frees its resources at `finish`
+	struct running_job {
+		intmax_t finish;
+		resource_info req;
+	};
+
+	// the heap functions keep the greatest on top, so this puts the soonest to finish there
+	bool finishes_later(const running_job &lhs, const running_job &rhs) noexcept {
+		return lhs.finish > rhs.finish;
+	}
+
+	// a job that was waiting when the simulation began, linked to the next one still waiting while it runs
+	struct waiting_job {
+		uintmax_t est_runtime;
+		size_t next; // the index of the next job still waiting, the number of waiting jobs if there's none
+	};
+
+	// reused by every build on a thread, so building allocates nothing once they've grown
+	struct simulation_scratch {
+		std::vector<running_job> running; // a min-heap on finish
+		std::vector<waiting_job> waiting; // parallel to availability_skyline.waiting
+	};
+
+	thread_local simulation_scratch scratch;
+
+	constexpr size_t never = std::numeric_limits<size_t>::max();
+
+	// the corrections the server's jobs run on, 0 when they run on their estimates
+	size_t corrections_for(const server_info *server) noexcept {
+		if(server->owner == nullptr || server->owner->context.runtimes == nullptr) return 0;
+		return runtime_model_generation(server->owner->context.runtimes);
+	}
+}
+
+struct availability_skyline {
+	bool stale = true; // the server's jobs have changed since it was built, or it never has been
+	intmax_t from; // when the simulation began
+	intmax_t first_start; // when the first waiting job started, the skyline only holds until then
+	size_t corrections; // the runtime corrections it was built on, see corrections_for
+
+	// one entry per step: each completion time, and the resources in use once any waiting jobs have started at it
+	std::vector<intmax_t> times;
+	std::vector<resource_info> util;
+
+	// the jobs waiting when the simulation began, in the order they were queued
+	struct waiting_start {
+		resource_info req;
+		size_t step; // the step it started in, never if it never did
+	};
+	std::vector<waiting_start> waiting;
+
+	// simulates the server's jobs from `time` until every one that can has finished
+	void build(const server_info *server, intmax_t time) {
+		const resource_info &max_resc = server->type->max_resc;
+		auto &running = scratch.running;
+		auto &links = scratch.waiting;
+
+		stale = false;
+		from = time;
+		corrections = corrections_for(server);
+		first_start = std::numeric_limits<intmax_t>::max();
+		times.clear();
+		util.clear();
+		waiting.clear();
+		running.clear();
+		links.clear();
+
+		resource_info used{ 0, 0, 0 };
+
+		// the fewest cores any waiting job needs, or fewer, so a step where none of them can start doesn't look at them
+		uintmax_t fewest_cores = std::numeric_limits<uintmax_t>::max();
+
+		for(auto j = 0; j < server->num_jobs; ++j) {
+			const schd_info &schd = server->jobs[j];
+
+			if(~schd.start_time) {
+				running.push_back(running_job{ schd.start_time + static_cast<intmax_t>(expected_runtime(server, &schd)), schd.req_resc });
+				used = used + schd.req_resc;
+			} else {
+				waiting.push_back(waiting_start{ schd.req_resc, never });
+				links.push_back(waiting_job{ expected_runtime(server, &schd), links.size() + 1 });
+				fewest_cores = std::min(fewest_cores, schd.req_resc.cores);
+			}
+		}
+
+		std::make_heap(running.begin(), running.end(), finishes_later);
+
+		const size_t none = links.size();
+		size_t first_waiting = 0; // none when nothing is waiting, as the last job links to none
+		intmax_t now = time;
+
+		while(true) {
+			while(!running.empty() && running.front().finish <= now) {
+				used = used - running.front().req;
+				std::pop_heap(running.begin(), running.end(), finishes_later);
+				running.pop_back();
+			}
+
+			// start whatever fits, in the order they were queued, unlinking each one that starts
+			if(first_waiting != none && used.cores + fewest_cores <= max_resc.cores) {
+				uintmax_t kept_fewest = std::numeric_limits<uintmax_t>::max();
+				size_t *link = &first_waiting;
+
+				while(*link != none) {
+					size_t w = *link;
+					const resource_info &req = waiting[w].req;
+
+					if(used + req <= max_resc) {
+						used = used + req;
+						waiting[w].step = times.size();
+						first_start = std::min(first_start, now);
+						running.push_back(running_job{ now + static_cast<intmax_t>(links[w].est_runtime), req });
+						std::push_heap(running.begin(), running.end(), finishes_later);
+						*link = links[w].next;
+
+						// none of the rest can start once the cores are used up
+						if(used.cores + fewest_cores > max_resc.cores) break;
+					} else {
+						kept_fewest = std::min(kept_fewest, req.cores);
+						link = &links[w].next;
+					}
+				}
+
+				// only a walk over every job still waiting knows the fewest cores they need
+				if(*link == none) fewest_cores = kept_fewest;
+			}
+
+			times.push_back(now);
+			util.push_back(used);
+
+			// anything still waiting now is too big for the server to ever start
+			if(running.empty()) break;
+
+			now = running.front().finish;
+		}
+	}
+
+	// whether a simulation from `time` would go exactly as this one does from there on
+	bool holds_for(const server_info *server, intmax_t time) const noexcept {
+		return !stale && from <= time && time <= first_start && corrections == corrections_for(server);
+	}
+};
+
+availability_prediction skyline_predict(server_info *server, const job_info *job, intmax_t from) {
+	if(server->skyline == nullptr) server->skyline = new availability_skyline();
+
+	availability_skyline &skyline = *server->skyline;
+	if(!skyline.holds_for(server, from)) skyline.build(server, from);
+
+	const resource_info &max_resc = server->type->max_resc;
+
+	/*
+	nothing started before `from`, so a simulation from there begins in the state of the last step at or before it.
+	a step at `from` itself is that simulation's first step, otherwise it begins between steps, nothing having changed
+	*/
+	size_t step = static_cast<size_t>(std::lower_bound(skyline.times.begin(), skyline.times.end(), from) - skyline.times.begin());
+	if(step == skyline.times.size() || skyline.times[step] != from) --step;
+
+	while(step < skyline.times.size() && !(skyline.util[step] + job->req_resc <= max_resc)) ++step;
+
+	// the job's too big for the server, so it never fits
+	if(step == skyline.times.size()) {
+		availability_prediction never_fits{ std::numeric_limits<intmax_t>::max(), 0, skyline.util.back() };
+		for(auto &w : skyline.waiting) never_fits.delayed += w.step == never && !(w.req <= job->req_resc);
+		return never_fits;
+	}
+
+	availability_prediction prediction{ std::max(skyline.times[step], from), 0, skyline.util[step] };
+
+	// the jobs still waiting at that step that the job being placed would hold up
+	for(auto &w : skyline.waiting) prediction.delayed += (w.step == never || w.step > step) && !(w.req <= job->req_resc); // NOT the same as >
+
+	return prediction;
+}
+
+job_reservation skyline_reservation(server_info *server, intmax_t from) {
+	if(server->skyline == nullptr) server->skyline = new availability_skyline();
+
+	availability_skyline &skyline = *server->skyline;
+	if(!skyline.holds_for(server, from)) skyline.build(server, from);
+
+	// the jobs waiting are the same from any time the skyline holds for, so the oldest is always the first
+	size_t step = skyline.waiting.front().step;
+	if(step == never) return job_reservation{ std::numeric_limits<intmax_t>::max(), skyline.util.back() };
+
+	return job_reservation{ skyline.times[step], skyline.util[step] };
+}
+
+intmax_t skyline_finish(server_info *server, intmax_t from) {
+	if(server->num_jobs == 0) return from;
+	if(server->skyline == nullptr) server->skyline = new availability_skyline();
+
+	availability_skyline &skyline = *server->skyline;
+	if(!skyline.holds_for(server, from)) skyline.build(server, from);
+
+	// the last step is when the last job finished, or `from` if that was before it
+	return std::max(skyline.times.back(), from);
+}
+
+void skyline_invalidate(server_info *server) noexcept {
+	if(server->skyline != nullptr) server->skyline->stale = true;
+}
+
+void skyline_release(server_info *server) noexcept {
+	delete server->skyline;
+	server->skyline = nullptr;
+}
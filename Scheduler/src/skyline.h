@@ -0,0 +1,75 @@
+#pragma once
+#ifndef skyline_h_
+#define skyline_h_
+
+#include "system_config.h"
+#include "job_info.h"
+
+#ifdef __cplusplus
+#include "cpp_util.h"
+#ifndef EXTERN_C
+#define EXTERN_C
+#define EXTERN_C_skyline_h_
+extern "C" {
+#endif
+#else
+#define noexcept
+#include <stdbool.h>
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+// when a busy server could start a job, as predictive_fit weighs it
+typedef struct availability_prediction {
+	intmax_t avail; // the first time the job would fit alongside the server's running jobs
+	size_t delayed; // the server's jobs still waiting then that don't fit within the job's requirements
+	resource_info util; // the resources in use then, before the job
+} availability_prediction;
+
+// the start EASY backfilling holds for the oldest job waiting on a server
+typedef struct job_reservation {
+	intmax_t start; // when it's predicted to start, INTMAX_MAX if it's too big to ever start
+	resource_info util; // the resources in use once it has
+} job_reservation;
+
+/*
+a server's jobs run forward on their estimated runtimes (see expected_runtime in runtime_model.h), waiting jobs starting in order as soon as they fit,
+until every one has finished, kept as the resources in use after each completion: a piecewise-constant
+skyline of the server's future. a server's skyline is built the first time it's asked about and kept until
+its jobs or the runtime corrections they run on change, so a server nothing has happened to isn't simulated again for every job.
+a skyline built from one time answers for any later time up to the first time a waiting job started in it,
+after which its jobs would have started differently, and is rebuilt otherwise
+*/
+typedef struct availability_skyline availability_skyline;
+
+/*
+the earliest time from `from` on that the job fits on the server, from its skyline, built or rebuilt if need be.
+the step `from` falls in is found with a binary search, then the steps after it are walked until the job fits.
+the same as simulating from `from` each time, for a server with jobs and a `from` that isn't negative
+*/
+availability_prediction skyline_predict(server_info *server, const job_info *job, intmax_t from);
+
+// the reservation for the oldest job waiting on a server from `from` on, from its skyline as above. the server must have a job waiting
+job_reservation skyline_reservation(server_info *server, intmax_t from);
+
+// when the last of a server's jobs is predicted to finish from `from` on, from its skyline as above, `from` if it has none
+intmax_t skyline_finish(server_info *server, intmax_t from);
+
+// marks a server's skyline out of date, for when its jobs have changed
+void skyline_invalidate(server_info *server) noexcept;
+
+// frees a server's skyline
+void skyline_release(server_info *server) noexcept;
+
+#ifdef __cplusplus
+#ifdef EXTERN_C_skyline_h_
+}
+#undef EXTERN_C_skyline_h_
+#undef EXTERN_C
+#endif
+#else
+#undef noexcept
+#endif
+
+#endif
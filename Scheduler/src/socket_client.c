@@ -6,6 +6,9 @@
 #include <arpa/inet.h>
 #include <stdbool.h>
 #include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/uio.h>
 
 #include "socket_client.h"
 
@@ -14,9 +17,23 @@
 #define OK "OK"
 #define END "."
 #define VERBOSE
-#define BUF_SIZE 1024
+#define BUF_SIZE 4096
+
+/* A trace starts with TRACE_MAGIC and a byte of flags, followed by one record per
+ * message: a kind byte, the nanoseconds since the previous record and the length of
+ * the message as LEB128 varints, then the message itself without any terminator. */
+#define TRACE_MAGIC "DSTRACE1"
+#define TRACE_NEWLINE 1
+#define TRACE_SENT '>'
+#define TRACE_RECEIVED '<'
+#define TRACE_SYSTEM_XML 'X' // the system.xml the server wrote, so a replay reads the same one
 
 bool client_msg_resp(socket_client *client, const char *msg, const char *expected_response);
+static void record_message(socket_client *client, char kind, const char *msg, size_t length);
+static void record_file(socket_client *client, const char *path);
+static void replay_sent(socket_client *client, const char *msg);
+static const char *replay_received(socket_client *client);
+static void replay_files(socket_client *client);
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  * creates and prepares socket to communicate with server  *
@@ -24,62 +41,338 @@ bool client_msg_resp(socket_client *client, const char *msg, const char *expecte
  * message to be sent is "REDY", after which the server    *
  * will start sending jobs.								   *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
-socket_client *client_init(char *host, int port) {
-	socket_client *client = malloc(sizeof *client);
-	client->socket = malloc(sizeof *client->socket);
-	client->fd = socket(AF_INET, SOCK_STREAM, 0);
-	client->socket->sin_family = AF_INET;
-	client->socket->sin_port = htons(port);
-	inet_pton(AF_INET, host, &client->socket->sin_addr);
-	int connect_status = connect(client->fd, (struct sockaddr *)client->socket, sizeof(*client->socket));
+socket_client *client_init(char *host, int port, bool newline, const char *trace_path) {
+	struct sockaddr_in *address = malloc(sizeof *address);
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	address->sin_family = AF_INET;
+	address->sin_port = htons(port);
+	inet_pton(AF_INET, host, &address->sin_addr);
+	int connect_status = connect(fd, (struct sockaddr *)address, sizeof(*address));
 	if (connect_status < 0) {
 		fprintf(stderr, "%s\n", "Connection Failed");
 		exit(1);
 	}
+	socket_client *client = client_from_fd(fd, newline);
+	client->socket = address;
+	if (trace_path && !client_record(client, trace_path))
+		exit(1);
 	if (!client_msg_resp(client, "HELO", OK))
 		exit(1);
 	if (!client_msg_resp(client, "AUTH comp335", OK))
 		exit(1);
+	if (client->trace)
+		record_file(client, "system.xml");
 	return client;
 }
 
-/* Send a null-terminated string to the server over a socket. */
+/* Wraps an already connected file descriptor, without performing the greeting.
+ * This is what lets the framing be tested over a socketpair. */
+socket_client *client_from_fd(int fd, bool newline) {
+	socket_client *client = malloc(sizeof *client);
+	client->socket = NULL;
+	client->fd = fd;
+	client->newline = newline;
+	client->buffer = malloc(sizeof *client->buffer * BUF_SIZE);
+	client->buf_size = BUF_SIZE;
+	client->buf_start = client->buf_end = 0;
+	client->trace = NULL;
+	client->replay = false;
+	client->trace_time = 0;
+	return client;
+}
+
+/* Starts recording every message sent and received to a new trace at trace_path. */
+bool client_record(socket_client *client, const char *trace_path) {
+	FILE *trace = fopen(trace_path, "wb");
+	if (!trace) {
+		fprintf(stderr, "unable to record to %s\n", trace_path);
+		return false;
+	}
+	fwrite(TRACE_MAGIC, 1, strlen(TRACE_MAGIC), trace);
+	fputc(client->newline ? TRACE_NEWLINE : 0, trace);
+	client->trace = trace;
+	return true;
+}
+
+/* Creates a client that plays back a trace made by client_record, with no server at
+ * all. Every message received is the one recorded, and every message sent has to be
+ * the one recorded, so the client does exactly the work it did in the recorded session.
+ * The greeting is replayed here, as client_init would have done it, and system.xml is
+ * rewritten as it was recorded. */
+socket_client *client_replay(const char *trace_path) {
+	char magic[sizeof TRACE_MAGIC];
+	FILE *trace = fopen(trace_path, "rb");
+	if (!trace) {
+		fprintf(stderr, "unable to replay %s\n", trace_path);
+		return NULL;
+	}
+	size_t length = fread(magic, 1, strlen(TRACE_MAGIC), trace);
+	int flags = fgetc(trace);
+	if (length != strlen(TRACE_MAGIC) || memcmp(magic, TRACE_MAGIC, length) != 0 || flags == EOF) {
+		fprintf(stderr, "%s is not a trace\n", trace_path);
+		fclose(trace);
+		return NULL;
+	}
+	socket_client *client = client_from_fd(-1, flags & TRACE_NEWLINE);
+	client->trace = trace;
+	client->replay = true;
+	if (!client_msg_resp(client, "HELO", OK) || !client_msg_resp(client, "AUTH comp335", OK)) {
+		client_free(client);
+		return NULL;
+	}
+	replay_files(client);
+	return client;
+}
+
+static uint64_t monotonic_ns(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static void write_varint(FILE *trace, uint64_t value) {
+	while (value >= 0x80) {
+		fputc((int)(value & 0x7f) | 0x80, trace);
+		value >>= 7;
+	}
+	fputc((int)value, trace);
+}
+
+static bool read_varint(FILE *trace, uint64_t *value) {
+	int byte, shift = 0;
+	*value = 0;
+	do {
+		if ((byte = fgetc(trace)) == EOF || shift > 63)
+			return false;
+		*value |= (uint64_t)(byte & 0x7f) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+	return true;
+}
+
+static void record_message(socket_client *client, char kind, const char *msg, size_t length) {
+	uint64_t now = monotonic_ns();
+	fputc(kind, client->trace);
+	write_varint(client->trace, client->trace_time ? now - client->trace_time : 0);
+	write_varint(client->trace, length);
+	fwrite(msg, 1, length, client->trace);
+	client->trace_time = now;
+}
+
+static void record_file(socket_client *client, const char *path) {
+	FILE *file = fopen(path, "rb");
+	if (!file)
+		return;
+	char chunk[BUF_SIZE];
+	size_t length, total = 0;
+	char *contents = NULL;
+	while ((length = fread(chunk, 1, sizeof chunk, file)) > 0) {
+		contents = realloc(contents, total + length);
+		memcpy(contents + total, chunk, length);
+		total += length;
+	}
+	fclose(file);
+	record_message(client, TRACE_SYSTEM_XML, contents, total);
+	free(contents);
+}
+
+/* Writes out any files recorded next in the trace, so they exist before the client
+ * goes looking for them rather than whenever the next message is replayed. */
+static void replay_files(socket_client *client) {
+	int kind;
+	uint64_t delta, length;
+	while ((kind = fgetc(client->trace)) == TRACE_SYSTEM_XML) {
+		if (!read_varint(client->trace, &delta) || !read_varint(client->trace, &length))
+			return;
+		FILE *file = fopen("system.xml", "wb");
+		for (uint64_t i = 0; i < length; i++) {
+			int byte = fgetc(client->trace);
+			if (file && byte != EOF)
+				fputc(byte, file);
+		}
+		if (file)
+			fclose(file);
+	}
+	if (kind != EOF)
+		ungetc(kind, client->trace);
+}
+
+/* Reads the header of the next message in the trace, returning false at the end of it. */
+static bool next_record(socket_client *client, int *kind, uint64_t *length) {
+	uint64_t delta;
+	replay_files(client);
+	if ((*kind = fgetc(client->trace)) == EOF)
+		return false;
+	return read_varint(client->trace, &delta) && read_varint(client->trace, length);
+}
+
+static void replay_diverged(socket_client *client, const char *msg) {
+	fprintf(stderr, "replay diverged at byte %ld of the trace, sending \"%s\"\n", ftell(client->trace), msg);
+	exit(1);
+}
+
+/* Checks a message being sent against the next one recorded, byte for byte. */
+static void replay_sent(socket_client *client, const char *msg) {
+	int kind;
+	uint64_t length;
+	size_t msg_length = strlen(msg);
+	if (!next_record(client, &kind, &length) || kind != TRACE_SENT || length != msg_length)
+		replay_diverged(client, msg);
+	char chunk[BUF_SIZE];
+	for (size_t offset = 0; offset < msg_length; offset += sizeof chunk) {
+		size_t part = msg_length - offset < sizeof chunk ? msg_length - offset : sizeof chunk;
+		if (fread(chunk, 1, part, client->trace) != part || memcmp(chunk, msg + offset, part) != 0)
+			replay_diverged(client, msg);
+	}
+}
+
+/* Loads the next message recorded as received into the buffer, or returns NULL at the end of the trace. */
+static const char *replay_received(socket_client *client) {
+	int kind;
+	uint64_t length;
+	if (!next_record(client, &kind, &length))
+		return NULL;
+	if (kind != TRACE_RECEIVED) {
+		fprintf(stderr, "replay diverged at byte %ld of the trace, receiving where the client sent\n", ftell(client->trace));
+		exit(1);
+	}
+	while (length + 1 > client->buf_size) {
+		client->buf_size *= 2;
+		client->buffer = realloc(client->buffer, sizeof *client->buffer * client->buf_size);
+	}
+	if (fread(client->buffer, 1, length, client->trace) != length)
+		return NULL;
+	client->buffer[length] = '\0';
+	return client->buffer;
+}
+
+/* Send a null-terminated string to the server over a socket.
+ * In newline mode the terminator goes out in the same syscall as the message.
+ * If the other end has gone away this fails quietly instead of raising SIGPIPE,
+ * and the next receive reports the closed connection. */
 void client_send(socket_client *client, const char *msg) {
-	send(client->fd, msg, strlen(msg), 0);
+	if (client->replay) {
+		replay_sent(client, msg);
+		return;
+	}
+	if (client->trace)
+		record_message(client, TRACE_SENT, msg, strlen(msg));
+	struct iovec iov[2] = { { (void *)msg, strlen(msg) }, { "\n", 1 } };
+	struct msghdr header = { .msg_iov = iov, .msg_iovlen = client->newline ? 2 : 1 };
+	sendmsg(client->fd, &header, MSG_NOSIGNAL);
+}
+
+/* Reads whatever is available from the socket onto the end of the buffer, once.
+ * Unconsumed data is moved to the front first, and the buffer only grows if
+ * a single message doesn't fit, so once it's big enough this never allocates.
+ * One byte is always kept spare so a message can be null-terminated in place.
+ * Returns 1 if anything was read, 0 if the connection was closed, and -1 if the
+ * read failed, errno saying why: EAGAIN when a non-blocking socket has nothing yet. */
+int client_fill(socket_client *client) {
+	if (client->buf_start > 0) {
+		memmove(client->buffer, client->buffer + client->buf_start, client->buf_end - client->buf_start);
+		client->buf_end -= client->buf_start;
+		client->buf_start = 0;
+	}
+	if (client->buf_end + 1 >= client->buf_size) {
+		client->buf_size *= 2;
+		client->buffer = realloc(client->buffer, sizeof *client->buffer * client->buf_size);
+	}
+	ssize_t length;
+	do {
+		length = read(client->fd, client->buffer + client->buf_end, client->buf_size - client->buf_end - 1);
+	} while (length < 0 && errno == EINTR);
+	if (length <= 0)
+		return length < 0 ? -1 : 0;
+	client->buf_end += length;
+	return 1;
 }
 
-/* Returns a string that is sent by the server. */
-char *client_receive(socket_client *client) {
-	char *buffer = malloc(sizeof *buffer * BUF_SIZE);
-	int length = read(client->fd, buffer, BUF_SIZE - 1);
-	buffer[length] = '\0';
-	char *msg = calloc(length + 1, sizeof *msg);
-	strncpy(msg, buffer, length);
-	free(buffer);
+/* Returns the next message sent by the server, as a null-terminated view into
+ * the receive buffer. The view is only valid until the next call on this client.
+ * In newline mode messages are split on '\n', so several messages arriving in one
+ * segment or one message arriving over several segments are both handled. Otherwise
+ * the server gives us nothing to frame with, so each read is taken as one message,
+ * which holds because the server only ever sends one message per request. */
+const char *client_receive(socket_client *client) {
+	const char *msg = client_try_receive(client);
+	if (!msg) {
+		fprintf(stderr, "%s\n", "Connection closed by server");
+		exit(1);
+	}
+	return msg;
+}
+
+/* As client_receive, but returns NULL if the connection closes before a whole
+ * message arrives, for the ends of a connection that have to outlive it. */
+const char *client_try_receive(socket_client *client) {
+	if (client->replay)
+		return replay_received(client);
+
+	const char *msg;
+	while (!(msg = client_buffered(client)))
+		if (client_fill(client) <= 0)
+			return NULL;
+	return msg;
+}
+
+/* Returns the next message if the whole of it has already been read, framed as
+ * client_receive frames it, or NULL without reading anything if it hasn't. */
+const char *client_buffered(socket_client *client) {
+	if (client->buf_start == client->buf_end) {
+		client->buf_start = client->buf_end = 0;
+		return NULL;
+	}
+
+	size_t end;
+	if (client->newline) {
+		char *terminator = memchr(client->buffer + client->buf_start, '\n', client->buf_end - client->buf_start);
+		if (!terminator)
+			return NULL;
+		end = terminator - client->buffer;
+	} else {
+		end = client->buf_end;
+	}
+
+	char *msg = client->buffer + client->buf_start;
+	client->buffer[end] = '\0';
+	if (client->trace)
+		record_message(client, TRACE_RECEIVED, msg, end - client->buf_start);
+	client->buf_start = end < client->buf_end ? end + 1 : end;
 	return msg;
 }
 
 /* Sends a message and then checks if the response is the one expected.
- * If we know exactly what the response should be then use this.
- * Because there is an issue where the client is receiving more data at
- * the end of a string, this function only tests n number of characters,
- * where n=strlen(expected_response). */
+ * If we know exactly what the response should be then use this. */
 bool client_msg_resp(socket_client *client, const char *msg, const char *expected_response) {
-	size_t len = strlen(expected_response);
-	bool result = true;
 	client_send(client, msg);
-	char *response = client_receive(client);
-	if (strncmp(response, expected_response, len) != 0) {
-		fprintf(stderr, "expected \"%s\" of size %lu but received \"%s\" of size %lu in response to \"%s\" of size %lu\n", expected_response, len, response, strlen(response), msg, strlen(msg));
-		//fprintf(stderr, "%s%s%s%s%c\n", "expected \"", expected_response, "\" but received \"", response, '"');
+	return client_expect(client, msg, expected_response);
+}
+
+/* Checks the response to `msg`, already sent with client_send, is the one expected.
+ * The server only answers one message at a time, so the most a round trip can be
+ * shortened by is the work the client does between sending and calling this. */
+bool client_expect(socket_client *client, const char *msg, const char *expected_response) {
+	return client_check(msg, client_receive(client), expected_response);
+}
+
+/* Checks a response to `msg` is the one expected, logging both if it isn't. */
+bool client_check(const char *msg, const char *response, const char *expected_response) {
+	bool result = true;
+	if (strcmp(response, expected_response) != 0) {
+		fprintf(stderr, "expected \"%s\" of size %lu but received \"%s\" of size %lu in response to \"%s\" of size %lu\n", expected_response, strlen(expected_response), response, strlen(response), msg, strlen(msg));
 		result = false;
 	}
-	free(response);
 
 	return result;
 }
 
 void client_free(socket_client *client) {
+	if (client->trace)
+		fclose(client->trace);
+	if (client->fd >= 0)
+		close(client->fd);
+	free(client->buffer);
 	free(client->socket);
 	free(client);
 }
@@ -3,6 +3,9 @@
 
 #include <sys/socket.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
 #include "job_info.h"
 
 #define LOCALHOST "127.0.0.1"
@@ -11,12 +14,28 @@
 typedef struct socket_client {
 	struct sockaddr_in *socket;
 	int fd;
+	bool newline; // messages are terminated by '\n' in both directions (server config newline="true")
+	char *buffer; // persistent receive buffer, received messages are views into this
+	size_t buf_size; // capacity of buffer
+	size_t buf_start; // start of the data that hasn't been returned as a message yet
+	size_t buf_end; // end of the data read from the socket so far
+	FILE *trace; // if not NULL, every message is recorded here, or read from here when replaying
+	bool replay; // messages come from the trace instead of a server, and sent messages are checked against it
+	uint64_t trace_time; // monotonic time of the last message recorded, in nanoseconds
 } socket_client;
 
-socket_client *client_init(char *host, int port);
+socket_client *client_init(char *host, int port, bool newline, const char *trace_path);
+socket_client *client_from_fd(int fd, bool newline);
+bool client_record(socket_client *client, const char *trace_path);
+socket_client *client_replay(const char *trace_path);
 void client_free(socket_client *client);
 void client_send(socket_client *client, const char *msg);
 bool client_msg_resp(socket_client *client, const char *msg, const char *expected_response);
-char *client_receive(socket_client *client);
+bool client_expect(socket_client *client, const char *msg, const char *expected_response);
+bool client_check(const char *msg, const char *response, const char *expected_response);
+const char *client_receive(socket_client *client);
+const char *client_try_receive(socket_client *client);
+const char *client_buffered(socket_client *client);
+int client_fill(socket_client *client);
 
 #endif
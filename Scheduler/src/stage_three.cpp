@@ -1,4 +1,6 @@
 #include "stage_three.h"
+#include "thread_pool.h"
+#include "runtime_model.h"
 
 #include <algorithm>
 #include <functional>
@@ -7,6 +9,7 @@
 #include <cstdint>
 #include <iostream>
 #include <cstdio>
+#include <vector>
 
 constexpr resource_info RESC_MAX {
 	std::numeric_limits<uintmax_t>::max(),
@@ -31,170 +34,286 @@ bool all_resc_larger(const resource_info &lhs, const resource_info &rhs) noexcep
 	return lhs.cores > rhs.cores && lhs.memory > rhs.memory && lhs.disk > rhs.disk;
 }
 
-size_t waiting_jobs(const server_info *server) noexcept {
-	size_t total = 0;
-	for(auto s = 0; s < server->num_jobs; ++s) {
-		if(!~server->jobs[s].start_time) total++;
-	}
-	return total;
-}
-
-size_t inactive_of_type(const system_config* config, const server_type* type) noexcept {
-	size_t inactive = 0;
-	for(auto s = 0; s < type->limit; ++s) {
-		if(start_of_type(config, type)[s].state == SS_INACTIVE) inactive++;
-	}
-	return inactive;
-}
-
 enum search_mode {SM_PREDICTIVE = 0, SM_START_NEW = 1, SM_BEST_FIT = 2};
 
-// general idea: schedule job on available servers, then on offline servers, then on busy servers with descending quantity of jobs
-server_info *predictive_fit(system_config* config, job_info job) {
-	server_info *cur_server = nullptr;
-	resource_info cur_margin = RESC_MAX;
-	intmax_t cur_avail = std::numeric_limits<intmax_t>::max();
-	size_t cur_delayed = std::numeric_limits<size_t>::max();
-	search_mode cur_mode = SM_PREDICTIVE;
-
-	for(auto s = 0; s < config->num_servers; ++s) {
-
-		auto *new_server = &config->servers[s];
+inline namespace {
 
-		if(!job.can_run(new_server->type->max_resc) || new_server->state == SS_UNAVAILABLE) continue;
-
-		intmax_t new_avail = new_server->avail_time;
-		size_t new_delayed = 0;
-		resource_info new_margin;
-		search_mode new_mode = SM_PREDICTIVE;
-
-		if(job.can_run(new_server->avail_resc) && waiting_jobs(new_server) == 0) {
-
-			new_margin = resc_diff(new_server->avail_resc, job.req_resc);
-			new_mode = new_server->state == SS_INACTIVE ? SM_START_NEW : SM_BEST_FIT;
-
-		} else if(cur_mode == SM_PREDICTIVE) { // avoid doing work that we don't need to
-
-			if(new_server->state == SS_ACTIVE) new_avail = static_cast<intmax_t>(job.submit_time);
+	// a server that can take the job, and what predictive_fit compares it by
+	struct candidate {
+		server_info *server;
+		resource_info margin;
+		intmax_t avail;
+		size_t delayed;
+		search_mode mode;
+	};
 
-			std::vector<schd_info> pending_jobs;
-			for(auto j = 0; j < new_server->num_jobs; ++j) {
-				pending_jobs.push_back(new_server->jobs[j]);
-			}
+	/*
+	sizes up server `s` for the job, returning false if it can't take it.
+	one that can't run it yet is only simulated if `simulate` is set, and is passed over otherwise
+	*/
+	bool evaluate(system_config *config, const job_info &job, size_t s, bool simulate, candidate &next) {
+		const server_columns &columns = config->columns;
 
-			resource_info new_util = resc_diff(new_server->type->max_resc, new_server->avail_resc);
+		// servers that can't take the job are ruled out from the columns alone, without touching their server_info
+		if(!job.can_run(config->types[columns.type_index[s]].max_resc) || columns.state[s] == SS_UNAVAILABLE) return false;
 
-			// run a simulation of the currently allocated jobs until we hit a time when there are enough resources available to run the new one, then return that resource quantity and the time
-			while(!pending_jobs.empty()) {
+		next.server = &config->servers[s];
+		next.avail = columns.avail_time[s];
+		next.delayed = 0;
 
-				pending_jobs.erase(std::remove_if(pending_jobs.begin(), pending_jobs.end(), [new_avail](schd_info arg) { return ~arg.start_time && arg.start_time + arg.est_runtime <= new_avail; }), pending_jobs.end());
+		if(columns_can_run(&columns, s, &job) && next.server->num_waiting == 0) {
 
-				new_util = RESC_MIN;
-				new_delayed = 0;
+			next.margin = resc_diff(columns_avail_resc(&columns, s), job.req_resc);
+			next.mode = columns.state[s] == SS_INACTIVE ? SM_START_NEW : SM_BEST_FIT;
+			return true;
+		}
 
-				for(auto schd_job : pending_jobs) {
-					if(~schd_job.start_time) new_util = new_util + schd_job.req_resc;
-				}
+		if(!simulate) return false; // avoid doing work that we don't need to
 
-				for(auto &schd_job : pending_jobs) {
-					if(!~schd_job.start_time) {
-						if((new_util + schd_job.req_resc) <= new_server->type->max_resc) {
-							new_util = new_util + schd_job.req_resc;
-							schd_job.start_time = new_avail;
-						} else if(!(schd_job.req_resc <= job.req_resc)) new_delayed++; // NOT the same as >
-					}
-				}
+		if(next.server->state == SS_ACTIVE) next.avail = static_cast<intmax_t>(job.submit_time);
 
-				if((new_util + job.req_resc) <= new_server->type->max_resc) break;// if the job can run now, it gets run
+		// run a simulation of the currently allocated jobs until we hit a time when there are enough resources available to run the new one
+		availability_prediction prediction = predict_availability(next.server, &job, next.avail);
 
-				intmax_t next_finished_time = std::numeric_limits<intmax_t>::max();
-				for(auto schd_job : pending_jobs) {
-					if(~schd_job.start_time) next_finished_time = std::min(schd_job.start_time + static_cast<intmax_t>(schd_job.est_runtime), next_finished_time);
-				}
+		next.avail = prediction.avail;
+		next.delayed = prediction.delayed;
+		next.margin = resc_diff(prediction.util + job.req_resc, next.server->type->max_resc);
+		next.mode = SM_PREDICTIVE;
+		return true;
+	}
 
-				new_avail = next_finished_time;
-			}
+	/*
+	whether `next`, found after `cur`, takes its place as the choice.
+	this isn't an ordering, a server can beat one that beats a third which beats the first, so the choice depends on the order servers are seen in
+	*/
+	bool replaces(const system_config *config, const job_info &job, const candidate &next, const candidate &cur) {
+		if(next.mode != cur.mode || cur.server == nullptr) return next.mode >= cur.mode;
 
-			new_margin = resc_diff(new_util + job.req_resc, new_server->type->max_resc);
-		}
+		const server_info *new_server = next.server, *cur_server = cur.server;
+		const resource_info &new_margin = next.margin, &cur_margin = cur.margin;
+		intmax_t new_avail = next.avail, cur_avail = cur.avail;
+		size_t new_delayed = next.delayed, cur_delayed = cur.delayed;
 
-		if(new_mode < cur_mode) continue;
-		else if(cur_mode == new_mode && cur_server != nullptr) switch(cur_mode) {
+		switch(cur.mode) {
 
 			case SM_BEST_FIT:
 
 				// compare by available time, if the difference is relevant
 				if((new_server->state == SS_BOOTING && (new_avail - job.submit_time) >= job.est_runtime) || (cur_server->state == SS_BOOTING && (cur_avail - job.submit_time) >= job.est_runtime)) {
-					if(new_avail < cur_avail) break;
-					else if(new_avail > cur_avail) continue;
+					if(new_avail < cur_avail) return true;
+					else if(new_avail > cur_avail) return false;
 				}
 
 				// compare by best-fit
-				if(new_margin.cores < cur_margin.cores || new_margin < cur_margin) break;
-				else if(new_margin.cores > cur_margin.cores || new_margin > cur_margin) continue;
+				if(new_margin.cores < cur_margin.cores || new_margin < cur_margin) return true;
+				else if(new_margin.cores > cur_margin.cores || new_margin > cur_margin) return false;
 
 				// compare by cost
-				if(new_server->type->rate < cur_server->type->rate) break;
-				continue;
+				return new_server->type->rate < cur_server->type->rate;
 
 			case SM_START_NEW:
 
 				// start large servers but don't take the last one
-				if(all_resc_larger(new_margin, cur_server->type->max_resc) && inactive_of_type(config, new_server->type) > 2) break;
-				else if(all_resc_larger(cur_margin, new_server->type->max_resc) && inactive_of_type(config, cur_server->type) > 2) continue;
-					
+				if(all_resc_larger(new_margin, cur_server->type->max_resc) && servers_in_state(config, new_server->type, SS_INACTIVE) > 2) return true;
+				else if(all_resc_larger(cur_margin, new_server->type->max_resc) && servers_in_state(config, cur_server->type, SS_INACTIVE) > 2) return false;
+
 				// account for boot time if relevant
 				if(new_server->type->bootTime <= job.est_runtime && cur_server->type->bootTime <= job.est_runtime) {
 					// best-fit if boot time isn't relevant
-					if(new_margin.cores < cur_margin.cores || new_margin < cur_margin) break;
-					else if(new_margin.cores > cur_margin.cores || new_margin > cur_margin) continue;
+					if(new_margin.cores < cur_margin.cores || new_margin < cur_margin) return true;
+					else if(new_margin.cores > cur_margin.cores || new_margin > cur_margin) return false;
 				}
 
 				// if possible, take the one with lower bootup time
-				if(new_server->type->bootTime < cur_server->type->bootTime) break;
-				else if(new_server->type->bootTime > cur_server->type->bootTime) continue;
+				if(new_server->type->bootTime < cur_server->type->bootTime) return true;
+				else if(new_server->type->bootTime > cur_server->type->bootTime) return false;
 
 				// compare by cost
-				if(new_server->type->rate < cur_server->type->rate) break;
-				continue;
+				return new_server->type->rate < cur_server->type->rate;
 
 			case SM_PREDICTIVE:
 
 				// compare by weighted available time
-				if(new_avail + (1 + new_delayed) * job.est_runtime <= cur_avail) break;
-				else if(new_avail >= cur_avail + (1 + cur_delayed) * job.est_runtime) continue;
+				if(new_avail + (1 + new_delayed) * job.est_runtime <= cur_avail) return true;
+				else if(new_avail >= cur_avail + (1 + cur_delayed) * job.est_runtime) return false;
 
 				// compare by available time
-				if(new_avail < cur_avail) break;
-				else if(new_avail > cur_avail) continue;
+				if(new_avail < cur_avail) return true;
+				else if(new_avail > cur_avail) return false;
 
 				// compare by potentially delayed jobs
-				if(new_delayed < cur_delayed) break;
-				else if(new_delayed > cur_delayed) continue;
-				
+				if(new_delayed < cur_delayed) return true;
+				else if(new_delayed > cur_delayed) return false;
+
 				// step forward in time and perform best-fit as usual
 				if((new_delayed == 0 && cur_delayed == 0) || (has_zeroed_resc(new_margin) && has_zeroed_resc(cur_margin))) {
-					if(new_margin.cores < cur_margin.cores || new_margin < cur_margin) break;
-					else if(new_margin.cores > cur_margin.cores || new_margin > cur_margin) continue;
+					if(new_margin.cores < cur_margin.cores || new_margin < cur_margin) return true;
+					else if(new_margin.cores > cur_margin.cores || new_margin > cur_margin) return false;
 
 				} else { // try to leave resources to run the delayed jobs
-					if(new_margin.cores > cur_margin.cores || new_margin > cur_margin) break;
-					else if(new_margin.cores < cur_margin.cores || new_margin < cur_margin) continue;
+					if(new_margin.cores > cur_margin.cores || new_margin > cur_margin) return true;
+					else if(new_margin.cores < cur_margin.cores || new_margin < cur_margin) return false;
 				}
 
 				// compare by cost
-				if(new_server->type->rate < cur_server->type->rate)break;
-				continue;
+				return new_server->type->rate < cur_server->type->rate;
+		}
+
+		return false;
+	}
+
+	constexpr size_t NONE_STARTED = std::numeric_limits<size_t>::max();
+
+	/*
+	whether server `s` is an inactive server just like `started`, the last one found that would have to start.
+	its candidate would be the same, and as servers are ordered by type only servers of that type lie between them,
+	none of which can have made it compare differently, so it can be passed over. a type's inactive servers are mostly
+	identical, so this leaves one of them to size up rather than all of them
+	*/
+	bool same_as_started(const server_columns &columns, size_t s, size_t started) noexcept {
+		return started != NONE_STARTED && columns.state[s] == SS_INACTIVE && columns.type_index[s] == columns.type_index[started]
+			&& columns.cores[s] == columns.cores[started] && columns.memory[s] == columns.memory[started] && columns.disk[s] == columns.disk[started];
+	}
+
+	constexpr candidate NO_CANDIDATE{ nullptr, RESC_MAX, std::numeric_limits<intmax_t>::max(), std::numeric_limits<size_t>::max(), SM_PREDICTIVE };
+
+	/*
+	a higher mode always replaces the choice and a lower one never does, so the choice is only ever made between servers of
+	the highest mode found, in the order they're found. a chunk of servers searched on its own keeps those of the highest mode in it,
+	which includes every one the whole search would have compared once the chunks are put back in order
+	*/
+	struct chunk_search {
+		search_mode mode;
+		std::vector<candidate> found; // in server order
+	};
+
+	struct parallel_search {
+		system_config *config;
+		const job_info *job;
+		size_t chunk_size;
+		std::vector<chunk_search> chunks;
+	};
+
+	// reused for every job, so searching allocates nothing once the lists have grown
+	thread_local parallel_search searched;
+
+	// fewer servers than this to a chunk and handing them to another thread costs more than searching them
+	constexpr size_t MIN_CHUNK = 16;
+
+	void search_chunk(void *context, size_t c) {
+		parallel_search &search = *static_cast<parallel_search*>(context);
+		chunk_search &chunk = search.chunks[c];
+		size_t end = std::min(search.config->num_servers, (c + 1) * search.chunk_size);
+
+		chunk.mode = SM_PREDICTIVE;
+		chunk.found.clear();
+		size_t started = NONE_STARTED;
 
+		for(size_t s = c * search.chunk_size; s < end; ++s) {
+			candidate next;
+			if(same_as_started(search.config->columns, s, started)) continue;
+			if(!evaluate(search.config, *search.job, s, chunk.mode == SM_PREDICTIVE, next) || next.mode < chunk.mode) continue;
+			if(next.mode == SM_START_NEW) started = s;
+
+			if(next.mode > chunk.mode) {
+				chunk.mode = next.mode;
+				chunk.found.clear();
+			}
+			chunk.found.push_back(next);
+		}
+	}
+}
+
+// general idea: schedule job on available servers, then on offline servers, then on busy servers with descending quantity of jobs
+server_info *predictive_fit(system_config* config, job_info job) {
+	candidate cur = NO_CANDIDATE;
+
+	// more chunks than threads, as some take far longer to simulate than others
+	size_t chunks = config->context.workers != nullptr ? std::min(thread_pool_threads(config->context.workers) * 4, config->num_servers / MIN_CHUNK) : 0;
+
+	if(chunks < 2) {
+		size_t started = NONE_STARTED;
+
+		for(size_t s = 0; s < config->num_servers; ++s) {
+			candidate next;
+			if(same_as_started(config->columns, s, started) || !evaluate(config, job, s, cur.mode == SM_PREDICTIVE, next)) continue;
+			if(next.mode == SM_START_NEW) started = s;
+			if(replaces(config, job, next, cur)) cur = next;
+		}
+
+		return cur.server;
+	}
+
+	// the servers are searched in chunks across the workers, then what they found is compared in server order, as above
+	searched.config = config;
+	searched.job = &job;
+	searched.chunk_size = (config->num_servers + chunks - 1) / chunks;
+	searched.chunks.resize(chunks);
+	thread_pool_run(config->context.workers, chunks, search_chunk, &searched);
+
+	search_mode mode = SM_PREDICTIVE;
+	for(auto &chunk : searched.chunks) mode = std::max(mode, chunk.mode);
+
+	for(auto &chunk : searched.chunks) {
+		if(chunk.mode != mode) continue;
+		for(auto &next : chunk.found) {
+			if(replaces(config, job, next, cur)) cur = next;
+		}
+	}
+
+	return cur.server;
+}
+
+availability_prediction predict_availability(server_info *server, const job_info *job, intmax_t from) {
+	if(server->num_jobs == 0) return availability_prediction{ from, 0, resc_diff(server->type->max_resc, server->avail_resc) };
+
+	// a job started before 0 would have the start time that means waiting, which only the step-by-step simulation reproduces
+	if(from < 0) return predict_availability_scan(server, job, from);
+
+	return skyline_predict(server, job, from);
+}
+
+availability_prediction predict_availability_scan(const server_info *server, const job_info *job, intmax_t from) {
+	intmax_t new_avail = from;
+	size_t new_delayed = 0;
+
+	std::vector<schd_info> pending_jobs;
+	for(auto j = 0; j < server->num_jobs; ++j) {
+		pending_jobs.push_back(server->jobs[j]);
+		pending_jobs.back().est_runtime = expected_runtime(server, &server->jobs[j]);
+	}
+
+	resource_info new_util = resc_diff(server->type->max_resc, server->avail_resc);
+
+	while(!pending_jobs.empty()) {
+
+		pending_jobs.erase(std::remove_if(pending_jobs.begin(), pending_jobs.end(), [new_avail](schd_info arg) { return ~arg.start_time && arg.start_time + arg.est_runtime <= new_avail; }), pending_jobs.end());
+
+		new_util = RESC_MIN;
+		new_delayed = 0;
+
+		for(auto schd_job : pending_jobs) {
+			if(~schd_job.start_time) new_util = new_util + schd_job.req_resc;
+		}
+
+		for(auto &schd_job : pending_jobs) {
+			if(!~schd_job.start_time) {
+				if((new_util + schd_job.req_resc) <= server->type->max_resc) {
+					new_util = new_util + schd_job.req_resc;
+					schd_job.start_time = new_avail;
+				} else if(!(schd_job.req_resc <= job->req_resc)) new_delayed++; // NOT the same as >
+			}
 		}
-		
-		// update current selection
-		cur_server = new_server;
-		cur_margin = new_margin;
-		cur_avail = new_avail;
-		cur_mode = new_mode;
-		cur_delayed = new_delayed;
+
+		if((new_util + job->req_resc) <= server->type->max_resc) break;// if the job can run now, it gets run
+
+		intmax_t next_finished_time = std::numeric_limits<intmax_t>::max();
+		for(auto schd_job : pending_jobs) {
+			if(~schd_job.start_time) next_finished_time = std::min(schd_job.start_time + static_cast<intmax_t>(schd_job.est_runtime), next_finished_time);
+		}
+
+		new_avail = next_finished_time;
 	}
 
-	return cur_server;
+	return availability_prediction{ new_avail, new_delayed, new_util };
 }
\ No newline at end of file
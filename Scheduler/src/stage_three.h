@@ -15,9 +15,20 @@ extern "C" {
 #endif
 
 #include "algorithms.h"
+#include "skyline.h"
 
 server_info *predictive_fit(system_config* config, job_info job);
 
+/*
+simulates a server's jobs from `from` on their estimated runtimes (see expected_runtime in runtime_model.h), starting waiting jobs in order
+as soon as they fit, until the job would fit too, which it must once the server is empty.
+answered from the server's skyline, see skyline.h, which is only simulated again once its jobs change
+*/
+availability_prediction predict_availability(server_info *server, const job_info *job, intmax_t from);
+
+// the same prediction, stepping through every job at every completion, which predict_availability is checked against
+availability_prediction predict_availability_scan(const server_info *server, const job_info *job, intmax_t from);
+
 #ifdef __cplusplus
 #ifdef EXTERN_C_stage_three_h_
 }
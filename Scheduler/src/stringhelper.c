@@ -2,8 +2,8 @@
 #include "stringhelper.h"
 #include "job_info.h"
 
-#include <pcre2.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 char *create_schd_str(unsigned long id, char *server_name, unsigned long server_id) {
@@ -12,6 +12,7 @@ char *create_schd_str(unsigned long id, char *server_name, unsigned long server_
 	return schd;
 }
 
+#ifdef USE_PCRE2
 regex_info *regex_init(const char *regex_str) {
 	regex_info *info = malloc(sizeof *info);
 
@@ -82,4 +83,4 @@ job_info strtojob(const char *jobstr, regex_info *regex) {
 	//pcre2_match_data_free(regex->match_data);
 	return j;
 }
-
+#endif
@@ -1,9 +1,15 @@
 #ifndef stringhelper_h_
 #define stringhelper_h_
 
+#include "job_info.h"
+
+char *create_schd_str(unsigned long id, char *server_name, unsigned long server_id);
+
+/* The regex job parser has been replaced by parse_job in protocol.h, and is only
+ * built with USE_PCRE2 defined so the two can still be compared */
+#ifdef USE_PCRE2
 #define PCRE2_CODE_UNIT_WIDTH 8
 #include <pcre2.h>
-#include "job_info.h"
 
 #define JOB_REGEX "JOBN ([0-9]+) ([0-9]+) ([0-9]+) ([0-9]+) ([0-9]+) ([0-9]+)"
 
@@ -15,6 +21,6 @@ typedef struct {
 regex_info *regex_init(const char *pattern);
 void regex_free(regex_info *regex);
 job_info strtojob(const char *jobstr, regex_info *regex);
-char *create_schd_str(unsigned long id, char *server_name, unsigned long server_id);
+#endif
 
 #endif
@@ -1,7 +1,15 @@
 #include "system_config.h"
+#include "protocol.h"
+#include "latency.h"
+#include "capacity_index.h"
+#include "capacity_tree.h"
+#include "skyline.h"
+#include "runtime_model.h"
 ASSERT_IS_POD(server_type);
 ASSERT_IS_POD(server_info);
 ASSERT_IS_POD(server_group);
+ASSERT_IS_POD(server_columns);
+ASSERT_IS_POD(algorithm_context);
 ASSERT_IS_POD(system_config);
 
 #include <tinyxml.h>
@@ -9,6 +17,8 @@ ASSERT_IS_POD(system_config);
 #include <sstream>
 #include <stdexcept>
 #include <optional>
+#include <algorithm>
+#include <limits>
 
 inline namespace {
 
@@ -78,31 +88,108 @@ inline namespace {
 		} else return true;
 	}
 	
-	// helper to call update_server_from_string on a system_config until a socket_client runs out of updates to send
-	std::vector<server_info*> process_resc_data(system_config *config, socket_client *client) {
+	// FNV-1a, type names are short so this is about as cheap as comparing them
+	size_t hash_name(const char *name, size_t len) noexcept {
+		uint64_t hash = 14695981039346656037ull;
+
+		for(size_t i = 0; i < len; ++i) hash = (hash ^ static_cast<unsigned char>(name[i])) * 1099511628211ull;
+
+		return static_cast<size_t>(hash);
+	}
+
+	// helper to take in `RESC` rows on a system_config until a socket_client runs out of updates to send,
+	//.. `start` being when the `RESC` request was sent
+	std::vector<server_info*> process_resc_data(system_config *config, socket_client *client, uint64_t start) {
 		std::vector<server_info*> vec;
 		client_send(client, "OK");
-		std::string response = strcpy_and_free(client_receive(client));
+		const char *response = client_receive(client);
 
-		while(response != ".") {
-			vec.push_back(config->update_server_from_string(response));
+		// each row is checked before the next is asked for, then taken in, columns and index included, while the server sends it.
+		//.. the row stays valid until the next receive, as sending doesn't touch the receive buffer
+		while(strcmp(response, ".")) {
+			resc_row row;
+			server_info *server = config->check_resc_row(response, row);
 			client_send(client, "OK");
-			response = strcpy_and_free(client_receive(client));
+			server->update(static_cast<server_state>(row.state), row.avail_time, row.avail_resc);
+			vec.push_back(server);
+			response = client_receive(client);
 		}
 
-		for(auto server : vec) {
-			if(server->state == SS_INACTIVE || server->state == SS_UNAVAILABLE) continue;
-			else if(server->state == SS_IDLE) {
-				if(server->jobs != nullptr) {
-					free(server->jobs);
-					server->jobs = nullptr;
-					server->num_jobs = 0;
-				}
-			} else server->update_jobs(client);
-		}
+		start = latency_record(LAT_RESC, start);
+
+		config->update_jobs(client, vec);
+
+		latency_record(LAT_LSTJ, start);
 
 		return vec;
 	};
+
+	// helper to ask for a server's jobs, the response is read by receive_lstj_data, and the client is free in between
+	void send_lstj_request(const server_info *server, socket_client *client, std::string &request) {
+		request.assign("LSTJ ").append(server->type->name).append(" ").append(std::to_string(server->id));
+		client_send(client, request.c_str());
+	}
+
+	// helper to read the response to send_lstj_request, leaving the server's unfinished jobs in `vec`
+	void receive_lstj_data(server_info *server, socket_client *client, const std::string &request, std::vector<schd_info> &vec) {
+		if(!client_expect(client, request.c_str(), "DATA")) throw std::runtime_error("Server did not respond as expected!");
+
+		vec.clear();
+
+		client_send(client, "OK");
+
+		const char *response = client_receive(client);
+
+		while(strcmp(response, ".")) {
+			lstj_row row;
+			server->check_job_row(response, row);
+
+			// as with RESC, the row is taken in while the next is on its way
+			client_send(client, "OK");
+			server->take_job_row(row, vec);
+
+			response = client_receive(client);
+		}
+	}
+
+	// helper to run one `LSTJ` exchange for a server, leaving its unfinished jobs in `vec`
+	void process_lstj_data(server_info *server, socket_client *client, std::string &request, std::vector<schd_info> &vec) {
+		send_lstj_request(server, client, request);
+		receive_lstj_data(server, client, request, vec);
+	}
+
+	// the jobs on a server that haven't started, for when they've been replaced wholesale
+	size_t count_waiting(const server_info *server) noexcept {
+		size_t waiting = 0;
+
+		for(auto j = 0; j < server->num_jobs; ++j) if(!~server->jobs[j].start_time) ++waiting;
+
+		return waiting;
+	}
+
+	// the resources used by the jobs on a server that have started
+	resource_info running_resc(const server_info *server) noexcept {
+		resource_info used{ 0, 0, 0 };
+
+		for(auto j = 0; j < server->num_jobs; ++j) if(~server->jobs[j].start_time) used = used + server->jobs[j].req_resc;
+
+		return used;
+	}
+
+	// start every waiting job on a server that fits in the remaining resources at `time`, in the order they were queued
+	void start_waiting_jobs(server_info *server, intmax_t time) noexcept {
+		resource_info used = running_resc(server);
+
+		for(auto j = 0; j < server->num_jobs; ++j) {
+			auto &schd = server->jobs[j];
+
+			if(!~schd.start_time && used + schd.req_resc <= server->type->max_resc) {
+				schd.start_time = time;
+				used = used + schd.req_resc;
+				--server->num_waiting;
+			}
+		}
+	}
 }
 
 void server_type::release() noexcept {
@@ -111,6 +198,7 @@ void server_type::release() noexcept {
 
 void server_info::release() noexcept {
 	if(jobs != nullptr) free(jobs);
+	skyline_release(this);
 }
 
 void server_group::release() noexcept {
@@ -126,13 +214,56 @@ void system_config::release() noexcept {
 	for(auto i = 0; i < num_types; ++i) const_cast<server_type*>(types)[i].release();
 
 	free(const_cast<server_type*>(types));
+
+	free(type_offsets);
+
+	free(const_cast<server_type**>(type_table));
+
+	free(columns.state);
+	free(columns.avail_time);
+	free(columns.cores);
+	free(columns.memory);
+	free(columns.disk);
+	free(columns.type_index);
+
+	if(capacity != nullptr) capacity_index_free(capacity);
+	if(first_fit != nullptr) capacity_tree_free(first_fit);
+	free(state_counts);
+}
+
+void system_config::index_types() {
+	type_offsets = static_cast<size_t*>(realloc(type_offsets, sizeof(size_t)*(num_types + 1)));
+
+	// servers are laid out by type, so each type starts where the previous one's servers end
+	type_offsets[0] = 0;
+	for(auto t = 0; t < num_types; ++t) type_offsets[t + 1] = type_offsets[t] + types[t].limit;
+
+	// at least twice as many slots as types keeps probe sequences short
+	size_t slots = 2;
+	while(slots < num_types * 2) slots *= 2;
+
+	type_table = static_cast<const server_type**>(realloc(const_cast<server_type**>(type_table), sizeof(server_type*)*slots));
+	type_table_mask = slots - 1;
+
+	for(auto i = 0; i < slots; ++i) type_table[i] = nullptr;
+
+	for(auto t = 0; t < num_types; ++t) {
+		size_t len = strlen(types[t].name);
+		size_t slot = hash_name(types[t].name, len) & type_table_mask;
+
+		// the first type with a given name wins, the same as a linear search would give
+		while(type_table[slot] != nullptr && strcmp(type_table[slot]->name, types[t].name)) slot = (slot + 1) & type_table_mask;
+
+		if(type_table[slot] == nullptr) type_table[slot] = &types[t];
+	}
 }
 
 void system_config::update(socket_client *client) {
+	uint64_t start = latency_now();
 
 	if(!client_msg_resp(client, "RESC All", "DATA")) throw std::runtime_error("Server did not respond as expected!");
 
-	else process_resc_data(this, client);
+	else process_resc_data(this, client, start);
 }
 
 void system_config::update(socket_client *client, const server_type *type) {
@@ -140,10 +271,11 @@ void system_config::update(socket_client *client, const server_type *type) {
 	request << "RESC Type " << type->name;
 
 	auto request_str = request.str(); // required for safety because this is otherwise a temporary object
+	uint64_t start = latency_now();
 
 	if(!client_msg_resp(client, request_str.c_str(), "DATA")) throw std::runtime_error("Server did not respond as expected!");
 
-	else process_resc_data(this, client);
+	else process_resc_data(this, client, start);
 };
 
 std::vector<server_info *> system_config::update(socket_client *client, const resource_info &resc) {
@@ -151,71 +283,252 @@ std::vector<server_info *> system_config::update(socket_client *client, const re
 	request << "RESC Avail " << resc.cores << " " << resc.memory << " " << resc.disk;
 
 	auto request_str = request.str(); // required for safety because this is otherwise a temporary object
+	uint64_t start = latency_now();
 
 	if(!client_msg_resp(client, request_str.c_str(), "DATA")) throw std::runtime_error("Server did not respond as expected!");
 
-	else return process_resc_data(this, client);
+	else return process_resc_data(this, client, start);
 }
 
-server_info *system_config::update_server_from_string(const std::string &str) {
-	std::istringstream stream(str);
-	std::string name;
-	size_t id;
-	int state;
-	intmax_t time;
-	resource_info resc;
-
-	// use standard istream parsing to just split values at spaces, works great for our use-case
-	stream >> name >> id >> state >> time >> resc.cores >> resc.memory >> resc.disk;
+server_info *system_config::update_server_from_string(const char *str) {
+	resc_row row;
+	server_info *server = check_resc_row(str, row);
 
-	auto *type = type_by_name(name.c_str());
-	server_info *server = &start_of_type(type)[id];
-
-	server->update(static_cast<server_state>(state), time, resc);
+	server->update(static_cast<server_state>(row.state), row.avail_time, row.avail_resc);
 
 	return server;
 };
 
+server_info *system_config::check_resc_row(const char *str, resc_row &row) const {
+	parse_error error;
+
+	// the row is decoded in place, and the type is found from a view of its name, so nothing is copied
+	if(!parse_resc_row(str, &row, &error)) {
+		report_parse_error(str, &error);
+		throw std::runtime_error("Server sent a malformed server!");
+	}
+
+	auto *type = type_by_name(row.type_name.str, row.type_name.len);
+
+	if(row.id >= type->limit) throw std::out_of_range("Server sent a server id that doesn't exist!");
+	if(row.state < SS_INACTIVE || row.state > SS_UNAVAILABLE) throw std::out_of_range("Server sent a server state that doesn't exist!");
+
+	return &start_of_type(type)[row.id];
+}
+
+void server_info::check_job_row(const char *str, lstj_row &row) const {
+	parse_error error;
+
+	if(!parse_lstj_row(str, &row, &error)) {
+		report_parse_error(str, &error);
+		throw std::runtime_error("Server sent a malformed job!");
+	}
+}
+
+void server_info::take_job_row(const lstj_row &row, std::vector<schd_info> &vec) {
+	if(row.job_state > 2) return; // the job has finished, effectively
+
+	if(state == SS_BOOTING && row.job_state == 1 && ~row.schd.start_time) avail_time = row.schd.start_time;
+	vec.push_back(row.schd);
+}
+
+void server_info::replace_jobs(const std::vector<schd_info> &vec) noexcept {
+
+	// a server whose jobs are just as they were keeps its skyline
+	bool same = vec.size() == num_jobs && std::equal(vec.begin(), vec.end(), jobs, [](const schd_info &lhs, const schd_info &rhs) {
+		return lhs.job_id == rhs.job_id && lhs.start_time == rhs.start_time && lhs.est_runtime == rhs.est_runtime && lhs.req_resc == rhs.req_resc;
+	});
+	if(!same) skyline_invalidate(this);
+
+	if(vec.empty()) {
+		if(jobs != nullptr) free(jobs);
+		jobs = nullptr;
+		num_jobs = 0;
+
+	} else {
+		if(vec.size() != num_jobs) jobs = static_cast<schd_info*>(realloc(jobs, sizeof(schd_info)*vec.size()));
+		memcpy(jobs, vec.data(), sizeof(schd_info)*vec.size());
+		num_jobs = vec.size();
+	}
+
+	num_waiting = count_waiting(this);
+
+	sync(); // `LSTJ` can move a booting server's avail_time
+}
+
+bool server_info::matches_jobs(const std::vector<schd_info> &vec) const noexcept {
+
+	// only the jobs themselves and whether they've started are compared, since the start times
+	//.. the model predicts come from estimated runtimes and won't match the server exactly
+	return vec.size() == num_jobs && std::equal(vec.begin(), vec.end(), jobs, [](const schd_info &lhs, const schd_info &rhs) {
+		return lhs.job_id == rhs.job_id && !~lhs.start_time == !~rhs.start_time;
+	});
+}
+
+void system_config::update_jobs(socket_client *client, const std::vector<server_info*> &servers) {
+	// the server reads one command at a time and drops anything sent after it, so the
+	//.. requests can't be written up front; instead every job list is refreshed in one
+	//.. pass that shares the request and row buffers between servers, and each server's
+	//.. jobs are taken in, skyline and columns included, while the next server's are sent
+	std::string request;
+	std::vector<schd_info> vec;
+	const std::vector<schd_info> none;
+	server_info *listed = nullptr; // the server whose jobs are in `vec` and haven't been assigned yet
+
+	for(auto server : servers) {
+		if(server->state == SS_INACTIVE || server->state == SS_UNAVAILABLE) continue;
+		else if(server->state == SS_IDLE) server->replace_jobs(none);
+		else {
+			send_lstj_request(server, client, request);
+			if(listed != nullptr) listed->replace_jobs(vec);
+			receive_lstj_data(server, client, request, vec);
+			listed = server;
+		}
+	}
+
+	if(listed != nullptr) listed->replace_jobs(vec);
+}
+
 void server_info::update_jobs(socket_client *client) {
-	std::ostringstream request;
-	request << "LSTJ " << type->name << " " << id;
+	std::string request;
+	std::vector<schd_info> vec;
 
-	auto request_str = request.str(); // required for safety because this is otherwise a temporary object
+	process_lstj_data(this, client, request, vec);
+	replace_jobs(vec);
+}
 
-	if(!client_msg_resp(client, request_str.c_str(), "DATA")) throw std::runtime_error("Server did not respond as expected!");
+void system_config::advance(intmax_t time) noexcept {
+
+	for(auto s = 0; s < num_servers; ++s) servers[s].advance(time);
+}
+
+bool system_config::check(socket_client *client, server_info *server) {
 
+	// only our own decisions can change a server that isn't running, and the model already has those
+	if(server->state == SS_INACTIVE || server->state == SS_UNAVAILABLE) return true;
+
+	std::string request;
 	std::vector<schd_info> vec;
 
-	client_send(client, "OK");
+	process_lstj_data(server, client, request, vec);
 
-	std::string response = strcpy_and_free(client_receive(client));
+	bool accurate = server->matches_jobs(vec);
 
-	while(response != ".") {
-		std::istringstream stream(response);
-		//size_t job_id;
-		int job_state;
-		schd_info schd;
-		//intmax_t start_time;
-		//uintmax_t est_runtime;
-		//resource_info resc;
+	server->replace_jobs(vec);
 
-		stream >> schd.job_id >> job_state >> schd.start_time >> schd.est_runtime >> schd.req_resc.cores >> schd.req_resc.memory >> schd.req_resc.disk;
+	return accurate;
+}
 
-		if(job_state > 2) continue; // job has finished, effectively
-		if(this->state == SS_BOOTING && job_state == 1 && ~schd.start_time) this->avail_time = schd.start_time;
-		vec.push_back(schd);
-		client_send(client, "OK");
-		response = client_receive(client);
+void server_info::sync() const noexcept {
+	auto &columns = owner->columns;
+	size_t s = static_cast<size_t>(this - owner->servers);
+
+	uint8_t old_state = columns.state[s];
+	uint32_t old_cores = columns.cores[s];
+	intmax_t old_avail_time = columns.avail_time[s];
+	uint32_t old_memory = columns.memory[s];
+	uint32_t old_disk = columns.disk[s];
+
+	columns.state[s] = static_cast<uint8_t>(state);
+	columns.avail_time[s] = avail_time;
+	columns.cores[s] = static_cast<uint32_t>(avail_resc.cores);
+	columns.memory[s] = static_cast<uint32_t>(avail_resc.memory);
+	columns.disk[s] = static_cast<uint32_t>(avail_resc.disk);
+
+	if(owner->state_counts != nullptr && columns.state[s] != old_state) {
+		size_t *counts = &owner->state_counts[columns.type_index[s] * (SS_UNAVAILABLE + 1)];
+		--counts[old_state];
+		++counts[columns.state[s]];
 	}
 
-	if(jobs != nullptr) free(jobs);
-	if(vec.empty()) {
+	if(owner->capacity != nullptr) capacity_index_update(owner->capacity, &columns, s, old_state, old_cores, old_avail_time);
+
+	bool resources_changed = columns.state[s] != old_state || columns.cores[s] != old_cores || columns.memory[s] != old_memory || columns.disk[s] != old_disk;
+	if(owner->first_fit != nullptr && resources_changed) capacity_tree_update(owner->first_fit, &columns, s);
+}
+
+void server_info::advance(intmax_t time) noexcept {
+
+	switch(state) {
+		case SS_INACTIVE:
+			avail_time = time + static_cast<intmax_t>(type->bootTime);
+			sync();
+			return;
+
+		case SS_BOOTING:
+			if(avail_time > time) return;
+
+			// nothing has really started until the server is up, so start everything that fits at that point
+			for(auto j = 0; j < num_jobs; ++j) jobs[j].start_time = -1;
+			num_waiting = num_jobs;
+			start_waiting_jobs(this, avail_time);
+			skyline_invalidate(this);
+			break;
+
+		case SS_IDLE:
+		case SS_ACTIVE:
+			break;
+
+		default:
+			return;
+	}
+
+	// repeatedly finish the earliest job(s) to finish, until the next one to finish would do so after `time`
+	while(true) {
+		intmax_t next_finished_time = std::numeric_limits<intmax_t>::max();
+
+		for(auto j = 0; j < num_jobs; ++j) {
+			if(~jobs[j].start_time) next_finished_time = std::min(jobs[j].start_time + static_cast<intmax_t>(expected_runtime(this, &jobs[j])), next_finished_time);
+		}
+
+		if(next_finished_time > time) break;
+
+		auto end = std::remove_if(jobs, jobs + num_jobs, [this, next_finished_time](const schd_info &schd) {
+			return ~schd.start_time && schd.start_time + static_cast<intmax_t>(expected_runtime(this, &schd)) <= next_finished_time;
+		});
+
+		num_jobs = end - jobs;
+		start_waiting_jobs(this, next_finished_time);
+		skyline_invalidate(this);
+	}
+
+	if(num_jobs == 0 && jobs != nullptr) {
+		free(jobs);
 		jobs = nullptr;
-		num_jobs = 0;
 	}
-	else {
-		num_jobs = memcpy_from_vector(jobs, vec);
+
+	// the server reports idle servers as available now, and busy servers as -1
+	state = num_jobs == 0 ? SS_IDLE : SS_ACTIVE;
+	avail_time = num_jobs == 0 ? time : -1;
+	avail_resc = type->max_resc - running_resc(this);
+	sync();
+}
+
+void server_info::assign(const job_info &job) noexcept {
+	intmax_t time = static_cast<intmax_t>(job.submit_time);
+	schd_info schd{ job.id, -1, job.est_runtime, job.req_resc };
+
+	if(state == SS_INACTIVE) {
+		state = SS_BOOTING;
+		avail_time = time + static_cast<intmax_t>(type->bootTime);
 	}
+
+	// booting servers also have resources reserved for the jobs that will start once they're up
+	if(job.can_run(avail_resc)) {
+		schd.start_time = state == SS_BOOTING ? avail_time : time;
+		avail_resc = avail_resc - job.req_resc;
+	}
+
+	if(state == SS_IDLE) {
+		state = SS_ACTIVE;
+		avail_time = -1;
+	}
+
+	jobs = static_cast<schd_info*>(realloc(jobs, sizeof(schd_info)*(num_jobs + 1)));
+	jobs[num_jobs++] = schd;
+	if(!~schd.start_time) ++num_waiting;
+	skyline_invalidate(this);
+	sync();
 }
 
 system_config *parse_config(const char *path) noexcept {
@@ -251,11 +564,33 @@ system_config *parse_config(const char *path) noexcept {
 		return nullptr;
 	} // otherwise success
 
+	system_config *config = create_config(types.data(), types.size());
+
+	for(auto type : types) free(type.name);
+
+	return config;
+}
+
+system_config *create_config(const server_type *types, size_t num_types) noexcept {
+
+	// the columns hold resources in 32 bits, which is all ds-sim ever sends
+	for(auto t = 0; t < num_types; ++t) {
+		const resource_info &max = types[t].max_resc;
+
+		if(max.cores > UINT32_MAX || max.memory > UINT32_MAX || max.disk > UINT32_MAX) {
+			std::cerr << "Parser: bad attribute: server type '" << types[t].name << "' has resources that don't fit in 32 bits\n";
+
+			return nullptr;
+		}
+	}
+
 	system_config *config = static_cast<system_config *>(malloc(sizeof(system_config)));
 
-	// have to make a copy of the server_type-s first, otherwise the vector will
-	//.. still own the memory they live in when we initialize server_info-s with them
-	config->num_types = memcpy_from_vector(config->types, types);
+	// the types are copied, names included, so the config owns everything it points to
+	auto copies = std::vector<server_type>(types, types + num_types);
+	for(auto &type : copies) type.name = strdup(type.name);
+
+	config->num_types = memcpy_from_vector(config->types, copies);
 
 	// use a vector for this, again to avoid over-alloc or realloc
 	auto servers = std::vector<server_info>();
@@ -264,13 +599,56 @@ system_config *parse_config(const char *path) noexcept {
 		auto *type = &config->types[t];
 
 		for(size_t id = 0; id < type->limit; ++id) {
-			servers.push_back(server_info{ type, id, server_state::SS_INACTIVE, 0, type->max_resc, nullptr, 0 });
+			servers.push_back(server_info{ type, id, server_state::SS_INACTIVE, 0, type->max_resc, nullptr, 0, 0, config, nullptr });
 		}
 	}
 
 	// we own these to begin with, so no problem here
 	config->num_servers = memcpy_from_vector(config->servers, servers);
 
+	config->type_offsets = nullptr;
+	config->type_table = nullptr;
+	config->index_types();
+
+	auto &columns = config->columns;
+	columns.state = static_cast<uint8_t*>(calloc(config->num_servers, sizeof(uint8_t)));
+	columns.avail_time = static_cast<intmax_t*>(calloc(config->num_servers, sizeof(intmax_t)));
+	columns.cores = static_cast<uint32_t*>(calloc(config->num_servers, sizeof(uint32_t)));
+	columns.memory = static_cast<uint32_t*>(calloc(config->num_servers, sizeof(uint32_t)));
+	columns.disk = static_cast<uint32_t*>(calloc(config->num_servers, sizeof(uint32_t)));
+	columns.type_index = static_cast<uint32_t*>(calloc(config->num_servers, sizeof(uint32_t)));
+
+	// the columns are filled before the index and tree are built from them
+	config->capacity = nullptr;
+	config->first_fit = nullptr;
+	config->state_counts = nullptr;
+	config->context = algorithm_context{};
+
+	// calloc may return null for no servers at all
+	if(config->num_servers > 0 && (columns.state == nullptr || columns.avail_time == nullptr || columns.cores == nullptr || columns.memory == nullptr || columns.disk == nullptr || columns.type_index == nullptr)) {
+		free_config(config);
+
+		return nullptr;
+	}
+
+	for(auto t = 0; t < config->num_types; ++t) {
+		for(auto s = config->type_offsets[t]; s < config->type_offsets[t + 1]; ++s) columns.type_index[s] = static_cast<uint32_t>(t);
+	}
+	for(auto s = 0; s < config->num_servers; ++s) config->servers[s].sync();
+
+	config->state_counts = static_cast<size_t*>(calloc(config->num_types * (SS_UNAVAILABLE + 1), sizeof(size_t)));
+	if(config->state_counts != nullptr) {
+		for(auto s = 0; s < config->num_servers; ++s) ++config->state_counts[columns.type_index[s] * (SS_UNAVAILABLE + 1) + columns.state[s]];
+	}
+	config->capacity = capacity_index_create(config);
+	config->first_fit = capacity_tree_create(&columns, config->num_servers);
+
+	if((config->num_types > 0 && config->state_counts == nullptr) || config->capacity == nullptr || config->first_fit == nullptr) {
+		free_config(config);
+
+		return nullptr;
+	}
+
 	return config;
 }
 
@@ -286,7 +664,14 @@ void free_group(server_group *group) noexcept {
 
 const server_type *system_config::type_by_name(const char *name) const {
 
-	for(auto t = 0; t < num_types; ++t) if(!strcmp(types[t].name, name)) return &types[t];
+	return type_by_name(name, strlen(name));
+}
+
+const server_type *system_config::type_by_name(const char *name, size_t len) const {
+
+	for(size_t slot = hash_name(name, len) & type_table_mask; type_table[slot] != nullptr; slot = (slot + 1) & type_table_mask) {
+		if(!strncmp(type_table[slot]->name, name, len) && type_table[slot]->name[len] == '\0') return type_table[slot];
+	}
 
 	throw std::invalid_argument("No type exists with requested name!");
 }
@@ -303,7 +688,7 @@ const server_type *type_by_name(const system_config *config, const char* name) n
 
 server_info *system_config::start_of_type(const server_type *type) const {
 
-	for(auto s = 0; s < num_servers; ++s) if(servers[s].type == type) return &servers[s];
+	if(type >= types && type < types + num_types && type->limit > 0) return &servers[type_offsets[type - types]];
 
 	throw std::invalid_argument("No servers exist with requested type!");
 };
@@ -319,6 +704,10 @@ server_info *start_of_type(const system_config *config, const server_type *type)
 	}
 }
 
+size_t servers_in_state(const system_config *config, const server_type *type, server_state state) noexcept {
+	return config->state_counts[(type - config->types) * (SS_UNAVAILABLE + 1) + state];
+}
+
 bool update_config(system_config *config, socket_client *client) noexcept {
 	try {
 		config->update(client);
@@ -331,6 +720,24 @@ bool update_config(system_config *config, socket_client *client) noexcept {
 	}
 };
 
+void advance_config(system_config *config, intmax_t time) noexcept {
+	config->advance(time);
+}
+
+void assign_job(server_info *server, job_info job) noexcept {
+	server->assign(job);
+}
+
+bool check_server(system_config *config, socket_client *client, server_info *server) noexcept {
+	try {
+		return config->check(client, server);
+
+	} catch(...) {
+
+		return false;
+	}
+}
+
 bool update_servers_by_type(system_config *config, socket_client *client, const server_type *type) noexcept {
 	try {
 		config->update(client, type);
@@ -364,6 +771,7 @@ bool server_info::update(server_state state, intmax_t time, const resource_info
 		this->state = state;
 		this->avail_time = time;
 		this->avail_resc = resc;
+		sync();
 
 		return true;
 
@@ -376,9 +784,16 @@ bool update_server(server_info *server, server_state state, intmax_t time, resou
 
 void server_info::reset() noexcept {
 	avail_resc = type->max_resc;
+	sync();
 }
 
 void reset_server(server_info *server) noexcept {
 	//TODO: figure out what avail_time is, currently assuming it's "time until available"
 	server->reset();
+}
+
+void sync_server(server_info *server) noexcept {
+	server->num_waiting = count_waiting(server);
+	skyline_invalidate(server);
+	server->sync();
 }
\ No newline at end of file
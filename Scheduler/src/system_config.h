@@ -3,6 +3,7 @@
 #define system_config_h_
 
 #include "resource_info.h"
+#include "job_info.h"
 
 #ifdef __cplusplus
 #include "cpp_util.h"
@@ -19,6 +20,12 @@ extern "C" {
 #include <stdint.h>
 #include "socket_client.h"
 
+#ifdef __cplusplus
+// the decoded rows of `RESC` and `LSTJ` responses, see protocol.h
+struct resc_row;
+struct lstj_row;
+#endif
+
 typedef struct server_type {
 	char *name; // the human-readable name of the server type
 	uintmax_t limit; // the maximum number of concurrent instances of this type
@@ -46,9 +53,26 @@ typedef struct server_info {
 	resource_info avail_resc; // the available resources on this server
 	schd_info *jobs;
 	size_t num_jobs;
+	size_t num_waiting; // how many of the jobs haven't started, kept by every member that changes them
+	struct system_config *owner; // the config whose columns mirror this server
+	struct availability_skyline *skyline; // the jobs' predicted resource use over time, see skyline.h, null until first asked for
 #ifdef __cplusplus
+	// copies the fields mirrored in the owner's columns there, every member that changes them does this itself
+	void sync() const noexcept;
 	bool update(server_state state, intmax_t time, const resource_info &resc) noexcept;
 	void update_jobs(socket_client* client);
+	// decodes a row of this server's `LSTJ` response into `row`, throws if it's malformed
+	void check_job_row(const char *str, struct lstj_row &row) const;
+	// takes in a row checked by check_job_row, adding its job to `jobs` unless it's finished
+	void take_job_row(const struct lstj_row &row, std::vector<schd_info> &jobs);
+	// replaces the modelled jobs with those `LSTJ` listed, keeping the skyline if they're the same
+	void replace_jobs(const std::vector<schd_info> &jobs) noexcept;
+	// whether the modelled jobs are those `LSTJ` listed, going only by which jobs there are and whether they've started
+	bool matches_jobs(const std::vector<schd_info> &jobs) const noexcept;
+	// simulate the server forward to `time`, running its jobs for their estimated runtimes
+	void advance(intmax_t time) noexcept;
+	// record that `job` was scheduled on this server at the time it was submitted
+	void assign(const job_info &job) noexcept;
 	void reset() noexcept;
 	void release() noexcept;
 #endif
@@ -63,13 +87,59 @@ typedef struct server_group {
 #endif
 } server_group;
 
+/*
+the fields the algorithms scan for every job, stored column by column in arrays parallel to
+system_config.servers, so a scan only brings the columns it reads into the cache.
+ds-sim sends resources as 32-bit integers, so the available resources are narrowed to that
+*/
+typedef struct server_columns {
+	uint8_t *state; // server_state
+	intmax_t *avail_time;
+	uint32_t *cores; // available cores
+	uint32_t *memory; // available memory
+	uint32_t *disk; // available disk
+	uint32_t *type_index; // index of the server's type in system_config.types
+} server_columns;
+
+// whether a job fits in the available resources of the server at index `s`, reading only its columns
+static inline bool columns_can_run(const server_columns *columns, size_t s, const job_info *job) {
+	return job->req_resc.cores <= columns->cores[s] && job->req_resc.memory <= columns->memory[s] && job->req_resc.disk <= columns->disk[s];
+}
+
+// the available resources of the server at index `s`, widened back from its columns
+static inline resource_info columns_avail_resc(const server_columns *columns, size_t s) {
+	resource_info resc = { columns->cores[s], columns->memory[s], columns->disk[s] };
+	return resc;
+}
+
+// what the algorithms keep between jobs, set up by run_algorithm for the options it's given. none of it is owned by the config, and all of it may be null
+typedef struct algorithm_context {
+	struct thread_pool *workers; // shares predictive_fit's search between threads, see thread_pool.h, null to search on one
+	struct cost_model *costs; // cost_fit's weight and the tally of what it placed, see cost_fit.h, null for the default weight
+	struct adaptive_selector *selector; // picks adaptive_fit's algorithm from the load, see adaptive.h, null for Best-Fit
+	struct runtime_model *runtimes; // corrects the estimated runtimes the servers' jobs are simulated with, see runtime_model.h, null to trust them
+	struct boot_forecast *forecast; // starts servers ahead of the jobs forecast to need them, see preboot.h, null to start them only when a job does
+} algorithm_context;
+
 typedef struct system_config {
 	const server_type *types; // collection of types, ordered as parsed from XML
 	size_t num_types; // number of types
 	server_info *servers; // flat collection of servers, ordered by type then id
 	size_t num_servers; // number of servers
+	size_t *type_offsets; // index in servers of the first server of each type, parallel to types
+	const server_type **type_table; // open-addressed hash table of types by name, empty slots are null
+	size_t type_table_mask; // number of slots in type_table minus one, the number of slots is a power of two
+	server_columns columns; // the servers' hot fields, see server_columns
+	struct capacity_index *capacity; // the servers ordered by available cores, see capacity_index.h
+	struct capacity_tree *first_fit; // the most resources available over each range of servers, see capacity_tree.h
+	size_t *state_counts; // servers of each type in each state, SS_UNAVAILABLE + 1 to a type in the order of types, kept by server_info.sync
+	algorithm_context context; // what the algorithms keep between jobs, see algorithm_context
 #ifdef __cplusplus
+	// builds type_offsets and type_table from types, for when types or their limits have changed
+	void index_types();
 	const server_type *type_by_name(const char *name) const;
+	// as above, but for a name that isn't null-terminated
+	const server_type *type_by_name(const char *name, size_t len) const;
 	server_info *start_of_type(const server_type *type) const;
 	// handler for `RESC All`, throws if the server does something unexpected
 	void update(socket_client *client);
@@ -78,8 +148,19 @@ typedef struct system_config {
 	// handler for `RESC Avail ..`, throws if the server does something unexpected
 	// returns the servers updated by the RESC command
 	std::vector<server_info*> update(socket_client *client, const resource_info &resc);
+	// handler for `LSTJ ..` over a batch of servers, skipping those that can't have jobs
+	// throws if the server does something unexpected
+	void update_jobs(socket_client *client, const std::vector<server_info*> &servers);
+	// simulate every server forward to `time`, see server_info::advance
+	void advance(intmax_t time) noexcept;
+	// handler for `LSTJ ..` on one server, replacing its modelled jobs if they differ from the server's
+	// returns whether the model was accurate, throws if the server does something unexpected
+	bool check(socket_client *client, server_info *server);
 	// format is "<type> <id> <state> <avail_time> <avail_cores> <avail_mem> <avail_disk>"
-	server_info *update_server_from_string(const std::string &str);
+	server_info *update_server_from_string(const char *str);
+	// decodes a `RESC` row into `row` and returns the server it's about, to be updated once the row's been acknowledged
+	// throws if the row is malformed or names no server
+	server_info *check_resc_row(const char *str, struct resc_row &row) const;
 	void release() noexcept;
 #endif
 } system_config;
@@ -92,6 +173,14 @@ the caller is responsible for calling free_config on the result
 */
 system_config *parse_config(const char *path) noexcept;
 
+/*
+builds a system_config from a collection of types, copying them and their names,
+with every server inactive, exactly as parse_config leaves them.
+returns nullptr and logs to stderr if a type's resources don't fit in 32 bits.
+the caller is responsible for calling free_config on the result
+*/
+system_config *create_config(const server_type *types, size_t num_types) noexcept;
+
 // utility to enable a system_config to be freed in one go
 void free_config(system_config *config) noexcept;
 
@@ -104,6 +193,9 @@ const server_type *type_by_name(const system_config *config, const char* name) n
 // gets the first server of a given type, all other servers of that type follow it in the same memory region
 server_info *start_of_type(const system_config *config, const server_type *type) noexcept;
 
+// how many servers of a given type are in a given state, without looking at them
+size_t servers_in_state(const system_config *config, const server_type *type, server_state state) noexcept;
+
 // wrapper around system_config.update, returns true on success and false on failure
 bool update_config(system_config *config, socket_client *client) noexcept;
 
@@ -114,12 +206,24 @@ bool update_servers_by_type(system_config *config, socket_client *client, const
 // the caller is responsible for calling free_group on the result
 server_group *updated_servers_by_avail(system_config *config, socket_client *client, const resource_info resc) noexcept;
 
+// wrapper around system_config.advance, brings the local model of the servers up to `time` without any network traffic
+void advance_config(system_config *config, intmax_t time) noexcept;
+
+// wrapper around server_info.assign, records a scheduling decision in the local model
+void assign_job(server_info *server, job_info job) noexcept;
+
+// wrapper around system_config.check, returns false if the model has drifted or the check failed
+bool check_server(system_config *config, socket_client *client, server_info *server) noexcept;
+
 // validates the new resources for the server, returning true and updating if they're valid; false otherwise
 //bool update_server(server_info *server, server_state state, int time, resource_info resc) noexcept;
 
 // reset the resources availiable on a server to default values
 void reset_server(server_info *server) noexcept;
 
+// wrapper around server_info.sync, for after writing a server's fields directly, jobs included
+void sync_server(server_info *server) noexcept;
+
 #ifdef __cplusplus
 #ifdef EXTERN_C_system_config_h_
 }
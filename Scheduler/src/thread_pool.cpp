@@ -0,0 +1,98 @@
+#include "thread_pool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct thread_pool {
+	std::vector<std::thread> workers;
+
+	std::mutex mutex;
+	std::condition_variable work_ready; // a batch has been handed out, or the pool is stopping
+	std::condition_variable work_done; // the last worker has finished with a batch
+
+	// the current batch, only changed under the mutex while no worker is in it
+	size_t tasks = 0;
+	void (*task)(void*, size_t) = nullptr;
+	void *context = nullptr;
+	size_t batch = 0; // counts batches, so a worker knows a new one from the one it's just done
+	size_t busy = 0; // workers still in the current batch
+	bool stopping = false;
+
+	std::atomic<size_t> next{ 0 }; // the next task of the batch to be taken
+
+	// takes tasks from the current batch until there are none left
+	void work() noexcept {
+		for(size_t i = next.fetch_add(1); i < tasks; i = next.fetch_add(1)) task(context, i);
+	}
+
+	void worker() noexcept {
+		size_t seen = 0;
+		std::unique_lock<std::mutex> lock(mutex);
+
+		while(true) {
+			work_ready.wait(lock, [&] { return stopping || batch != seen; });
+			if(stopping) return;
+
+			seen = batch;
+			lock.unlock();
+			work();
+			lock.lock();
+
+			if(--busy == 0) work_done.notify_one();
+		}
+	}
+};
+
+thread_pool *thread_pool_create(size_t threads) noexcept {
+	thread_pool *pool = nullptr;
+
+	try {
+		pool = new thread_pool();
+		for(size_t t = 1; t < threads; ++t) pool->workers.emplace_back([pool] { pool->worker(); });
+
+		return pool;
+
+	} catch(...) {
+
+		if(pool != nullptr) thread_pool_free(pool);
+		return nullptr;
+	}
+}
+
+size_t thread_pool_threads(const thread_pool *pool) noexcept {
+	return pool->workers.size() + 1;
+}
+
+void thread_pool_run(thread_pool *pool, size_t tasks, void (*task)(void *context, size_t i), void *context) noexcept {
+	{
+		std::lock_guard<std::mutex> lock(pool->mutex);
+		pool->tasks = tasks;
+		pool->task = task;
+		pool->context = context;
+		pool->next = 0;
+		pool->busy = pool->workers.size();
+		++pool->batch;
+	}
+
+	pool->work_ready.notify_all();
+	pool->work();
+
+	// the batch can't be replaced until every worker has stopped taking tasks from it
+	std::unique_lock<std::mutex> lock(pool->mutex);
+	pool->work_done.wait(lock, [pool] { return pool->busy == 0; });
+}
+
+void thread_pool_free(thread_pool *pool) noexcept {
+	{
+		std::lock_guard<std::mutex> lock(pool->mutex);
+		pool->stopping = true;
+	}
+
+	pool->work_ready.notify_all();
+	for(auto &worker : pool->workers) worker.join();
+
+	delete pool;
+}
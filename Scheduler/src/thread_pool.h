@@ -0,0 +1,50 @@
+#pragma once
+#ifndef thread_pool_h_
+#define thread_pool_h_
+
+#ifdef __cplusplus
+#include "cpp_util.h"
+#ifndef EXTERN_C
+#define EXTERN_C
+#define EXTERN_C_thread_pool_h_
+extern "C" {
+#endif
+#else
+#define noexcept
+#include <stdbool.h>
+#endif
+
+#include <stddef.h>
+
+/*
+worker threads that are started once and wait between batches of work, so a batch per job
+costs a wake-up rather than starting threads. the thread handing out a batch works on it too
+*/
+typedef struct thread_pool thread_pool;
+
+// starts threads - 1 workers, to share work with the calling thread; null if they can't be started
+thread_pool *thread_pool_create(size_t threads) noexcept;
+
+// the number of threads a batch is shared between, the calling thread included
+size_t thread_pool_threads(const thread_pool *pool) noexcept;
+
+/*
+calls task(context, i) once for every i in [0, tasks), on whichever thread is free next, and returns once every call has.
+everything written before this is visible to the tasks, and everything the tasks write is visible after it
+*/
+void thread_pool_run(thread_pool *pool, size_t tasks, void (*task)(void *context, size_t i), void *context) noexcept;
+
+// stops the workers and waits for them to exit
+void thread_pool_free(thread_pool *pool) noexcept;
+
+#ifdef __cplusplus
+#ifdef EXTERN_C_thread_pool_h_
+}
+#undef EXTERN_C_thread_pool_h_
+#undef EXTERN_C
+#endif
+#else
+#undef noexcept
+#endif
+
+#endif
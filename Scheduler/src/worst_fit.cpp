@@ -1,44 +1,73 @@
 #include "worst_fit.h"
 #include "cpp_util.h"
+#include "fit_kernels.h"
+#include "capacity_index.h"
 
+#include <algorithm>
 #include <limits>
 #include <cstdint>
 
 server_info *worst_fit(system_config* config, job_info job) {
+	return capacity_worst_fit(config, &job);
+}
+
+server_info *worst_fit_scan(system_config* config, job_info job) {
+	// servers are checked a block at a time by fit_block, the chosen server_info is looked up at the end
+	const server_columns &columns = config->columns;
+	uint32_t fitness[FIT_BLOCK];
 	intmax_t worst_fit, other_fit, type_fit;
-	server_info *worst_server, *other_server, *type_server;
+	size_t worst_server = 0, other_server = 0, type_server = 0;
 	worst_fit = other_fit = type_fit = std::numeric_limits<intmax_t>::min();
 
-	for(auto s = 0; s < config->num_servers; ++s) {
-		auto server = &config->servers[s];
+	for(size_t first = 0; first < config->num_servers; first += FIT_BLOCK) {
+		size_t count = std::min<size_t>(FIT_BLOCK, config->num_servers - first);
+		fit_result fit = fit_block(&columns, first, count, &job, fitness);
 
-		if(server->state == server_state::SS_UNAVAILABLE) continue;
+		// only a server fitter than one of the two so far can change anything, so most blocks are ruled out whole
+		uint64_t bits = static_cast<intmax_t>(fit.max_fitness) > std::min(worst_fit, other_fit) ? fit.mask : 0;
 
-		else if(job.can_run(server->avail_resc)) {
-			intmax_t fitness = job.fitness(server->avail_resc);
+		for(; bits != 0; bits &= bits - 1) {
+			size_t i = static_cast<size_t>(__builtin_ctzll(bits));
+			size_t s = first + i;
+			auto state = static_cast<server_state>(columns.state[s]);
+			intmax_t avail_time = columns.avail_time[s];
 
-			if(fitness > worst_fit && server->avail_time <= static_cast<intmax_t>(job.submit_time) && (server->state == SS_ACTIVE || server->state == SS_IDLE)) {
-				worst_fit = fitness;
-				worst_server = server;
+			if(fitness[i] > worst_fit && avail_time <= static_cast<intmax_t>(job.submit_time) && (state == SS_ACTIVE || state == SS_IDLE)) {
+				worst_fit = fitness[i];
+				worst_server = s;
 
-			} else if(fitness > other_fit && server->avail_time <= static_cast<intmax_t>(job.submit_time + server->type->bootTime)) {
-				other_fit = fitness;
-				other_server = server;
+			} else if(fitness[i] > other_fit && avail_time <= static_cast<intmax_t>(job.submit_time + config->types[columns.type_index[s]].bootTime)) {
+				other_fit = fitness[i];
+				other_server = s;
 			}
+		}
+
+		// the fitness of the server's type only matters until a server is found above
+		if(worst_fit < 0 && other_fit < 0) {
+			for(size_t i = 0; i < count; ++i) {
+				size_t s = first + i;
 
-		} else if(job.can_run(server->type->max_resc)) {
-			intmax_t fitness = job.fitness(server->type->max_resc);
+				if(fit.mask & (uint64_t(1) << i) || columns.state[s] == SS_UNAVAILABLE) continue;
 
-			if(fitness > type_fit) {
-				type_fit = fitness;
-				type_server = server;
+				const resource_info &max_resc = config->types[columns.type_index[s]].max_resc;
+
+				if(job.can_run(max_resc)) {
+					intmax_t max_fitness = job.fitness(max_resc);
+
+					if(max_fitness > type_fit) {
+						type_fit = max_fitness;
+						type_server = s;
+					}
+				}
 			}
 		}
 	}
 
-	if(worst_fit >= 0) return worst_server;
+	if(worst_fit >= 0) return &config->servers[worst_server];
 	
-	else if(other_fit >= 0) return other_server;
+	else if(other_fit >= 0) return &config->servers[other_server];
+
+	else if(type_fit >= 0) return &config->servers[type_server];
 
-	else return type_server;
+	else return nullptr;
 }
@@ -15,8 +15,12 @@ extern "C" {
 
 #include "algorithms.h"
 
+// the server with the most cores left once the job is running, looked up in the capacity index
 server_info *worst_fit(system_config* config, job_info job);
 
+// the same choice as worst_fit, made by checking every server
+server_info *worst_fit_scan(system_config* config, job_info job);
+
 #ifdef __cplusplus
 #ifdef EXTERN_C_worst_fit_h_
 #undef EXTERN_C_worst_fit_h_
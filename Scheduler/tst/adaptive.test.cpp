@@ -0,0 +1,171 @@
+#define EXTERN_C
+extern "C" {
+#include "../src/adaptive.h"
+}
+#undef EXTERN_C
+#include "test_util.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <string>
+
+namespace {
+	char typeName[] = "medium";
+	const server_type type{ typeName, 4, 60, 0.4f, resource_info{ 4, 16000, 64000 } };
+	const adaptive_thresholds thresholds{ ADAPTIVE_QUEUE, ADAPTIVE_FREE, ADAPTIVE_LOAD };
+
+	// fills the server at `s` with a job using every core, and queues `waiting` more behind it
+	void fill(system_config *config, size_t s, size_t waiting) {
+		server_info &server = config->servers[s];
+		server.state = SS_IDLE;
+		sync_server(&server);
+		for(size_t j = 0; j <= waiting; ++j) server.assign(job_info{ 0, 1000 + j, 100000, type.max_resc });
+	}
+
+	// a small, short job every `gap` seconds, starting from job `first`
+	job_info arrival(uintmax_t first, uintmax_t n, uintmax_t gap) {
+		return job_info{ (first + n) * gap, first + n, 100, resource_info{ 1, 1000, 1000 } };
+	}
+
+	TEST(Adaptive, LightLoadStartsWithBestFit) {
+		system_config *config = create_config(&type, 1);
+		FILE *log = tmpfile();
+		ASSERT_NE(log, nullptr);
+		adaptive_selector *selector = adaptive_create(thresholds, log);
+		ASSERT_NE(selector, nullptr);
+
+		EXPECT_EQ(adaptive_select(selector, config, arrival(0, 0, 1000)), BEST_FIT);
+		EXPECT_DOUBLE_EQ(adaptive_metrics(selector).free, 1);
+		EXPECT_NE(contents(log).find("job 0 at 0 starts with bf"), std::string::npos);
+
+		fclose(log);
+		adaptive_free(selector);
+		free_config(config);
+	}
+
+	// no server has room to spare, but nothing's queueing either, so jobs are spread out
+	TEST(Adaptive, BusyServersWorstFit) {
+		system_config *config = create_config(&type, 1);
+		for(size_t s = 0; s < config->num_servers; ++s) fill(config, s, 0);
+		adaptive_selector *selector = adaptive_create(thresholds, nullptr);
+		ASSERT_NE(selector, nullptr);
+
+		EXPECT_EQ(adaptive_select(selector, config, arrival(0, 0, 1000)), WORST_FIT);
+
+		adaptive_free(selector);
+		free_config(config);
+	}
+
+	// jobs start queueing, and once the first pick has had its dwell and enough have queued for the smoothed queue to cross the threshold it switches, once
+	TEST(Adaptive, QueueingSwitchesToPredictiveFit) {
+		system_config *config = create_config(&type, 1);
+		FILE *log = tmpfile();
+		ASSERT_NE(log, nullptr);
+		adaptive_selector *selector = adaptive_create(thresholds, log);
+		ASSERT_NE(selector, nullptr);
+
+		EXPECT_EQ(adaptive_select(selector, config, arrival(0, 0, 1000)), BEST_FIT);
+		for(size_t s = 0; s < config->num_servers; ++s) fill(config, s, 2);
+
+		algorithm_t picked = BEST_FIT;
+		size_t jobs = 1;
+		for(; jobs < ADAPTIVE_DWELL + 20 && picked != PREDICTIVE_FIT; ++jobs) picked = adaptive_select(selector, config, arrival(0, jobs, 1000));
+
+		EXPECT_EQ(picked, PREDICTIVE_FIT);
+		EXPECT_GT(jobs, ADAPTIVE_DWELL) << "bf should be kept for its dwell";
+		EXPECT_GE(adaptive_metrics(selector).queue, ADAPTIVE_QUEUE);
+
+		std::string text = contents(log);
+		EXPECT_NE(text.find("-> pf"), std::string::npos);
+		EXPECT_EQ(text.find("-> pf"), text.rfind("-> pf"));
+
+		fclose(log);
+		adaptive_free(selector);
+		free_config(config);
+	}
+
+	// a free fleet still counts as heavily loaded if work is arriving faster than it could get through it
+	TEST(Adaptive, ArrivalRatePredictiveFit) {
+		system_config *config = create_config(&type, 1);
+		adaptive_selector *selector = adaptive_create(adaptive_thresholds{ ADAPTIVE_QUEUE, ADAPTIVE_FREE, 1 }, nullptr);
+		ASSERT_NE(selector, nullptr);
+
+		// 16 cores take a 4 core job of 100 seconds every 25 seconds, or more often
+		algorithm_t picked = BEST_FIT;
+		for(uintmax_t j = 0; j < ADAPTIVE_DWELL + 20; ++j) picked = adaptive_select(selector, config, job_info{ j * 20, j, 100, resource_info{ 4, 1000, 1000 } });
+		EXPECT_EQ(picked, PREDICTIVE_FIT);
+		EXPECT_NEAR(adaptive_metrics(selector).load, 1.25, 1e-9);
+
+		adaptive_free(selector);
+		free_config(config);
+	}
+
+	// once the queue has drained, pf is still kept until its dwell is up
+	TEST(Adaptive, DwellKeepsPick) {
+		system_config *busy = create_config(&type, 1);
+		for(size_t s = 0; s < busy->num_servers; ++s) fill(busy, s, 2);
+		system_config *idle = create_config(&type, 1);
+		adaptive_selector *selector = adaptive_create(thresholds, nullptr);
+		ASSERT_NE(selector, nullptr);
+
+		EXPECT_EQ(adaptive_select(selector, busy, arrival(0, 0, 1000)), PREDICTIVE_FIT);
+		for(uintmax_t j = 1; j < ADAPTIVE_DWELL; ++j) EXPECT_EQ(adaptive_select(selector, idle, arrival(0, j, 1000)), PREDICTIVE_FIT) << "job " << j;
+		EXPECT_EQ(adaptive_select(selector, idle, arrival(0, ADAPTIVE_DWELL, 1000)), BEST_FIT);
+
+		adaptive_free(selector);
+		free_config(idle);
+		free_config(busy);
+	}
+
+	// a queue just under the threshold isn't enough to drop pf, as long as it's within the band
+	TEST(Adaptive, BandKeepsPredictiveFit) {
+		const server_type wide{ typeName, 5, 60, 0.4f, type.max_resc };
+		system_config *busy = create_config(&wide, 1);
+		for(size_t s = 0; s < busy->num_servers; ++s) fill(busy, s, 2);
+		// 2 jobs waiting over 5 busy servers
+		system_config *under = create_config(&wide, 1);
+		for(size_t s = 0; s < under->num_servers; ++s) fill(under, s, s < 2 ? 1 : 0);
+		adaptive_selector *selector = adaptive_create(thresholds, nullptr);
+		ASSERT_NE(selector, nullptr);
+
+		EXPECT_EQ(adaptive_select(selector, busy, arrival(0, 0, 1000)), PREDICTIVE_FIT);
+		algorithm_t picked = PREDICTIVE_FIT;
+		for(uintmax_t j = 1; j < ADAPTIVE_DWELL + 40 && picked == PREDICTIVE_FIT; ++j) picked = adaptive_select(selector, under, arrival(0, j, 1000));
+		EXPECT_EQ(picked, PREDICTIVE_FIT);
+		EXPECT_LT(adaptive_metrics(selector).queue, ADAPTIVE_QUEUE);
+
+		adaptive_free(selector);
+		free_config(under);
+		free_config(busy);
+	}
+
+	// a job asked about again after a refresh doesn't count twice
+	TEST(Adaptive, SameJobOnce) {
+		system_config *config = create_config(&type, 1);
+		FILE *out = tmpfile();
+		ASSERT_NE(out, nullptr);
+		adaptive_selector *selector = adaptive_create(thresholds, nullptr);
+		ASSERT_NE(selector, nullptr);
+
+		adaptive_select(selector, config, arrival(0, 0, 1000));
+		for(size_t s = 0; s < config->num_servers; ++s) fill(config, s, 10);
+		EXPECT_EQ(adaptive_select(selector, config, arrival(0, 0, 1000)), BEST_FIT);
+
+		adaptive_print(selector, out);
+		EXPECT_EQ(contents(out), "# adaptive: 1 jobs with bf, 0 jobs with wf, 0 jobs with pf, 0 switches\n");
+
+		fclose(out);
+		adaptive_free(selector);
+		free_config(config);
+	}
+
+	TEST(Adaptive, BestFitWithoutSelector) {
+		system_config *config = create_config(&type, 1);
+		fill(config, 1, 0);
+		config->servers[2].state = SS_IDLE;
+		sync_server(&config->servers[2]);
+
+		job_info job = arrival(0, 0, 1000);
+		EXPECT_EQ(adaptive_fit(config, job), best_fit(config, job));
+		free_config(config);
+	}
+}
\ No newline at end of file
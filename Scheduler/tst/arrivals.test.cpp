@@ -0,0 +1,50 @@
+#define EXTERN_C
+extern "C" {
+#include "../src/arrivals.h"
+}
+#undef EXTERN_C
+#include <gtest/gtest.h>
+
+namespace {
+	const resource_info req{ 2, 1000, 1000 };
+
+	job_info arrival(uintmax_t id, uintmax_t submit) {
+		return job_info{ submit, id, 100, req };
+	}
+
+	// the first gap is taken as it is, and the rest smoothed towards
+	TEST(Arrivals, SmoothsGapAndSize) {
+		arrival_rate rate{};
+		EXPECT_TRUE(arrival_observe(&rate, arrival(0, 0), 4));
+		EXPECT_DOUBLE_EQ(rate.size, 4);
+		EXPECT_DOUBLE_EQ(rate.gap, 0);
+
+		EXPECT_TRUE(arrival_observe(&rate, arrival(1, 100), 4));
+		EXPECT_DOUBLE_EQ(rate.gap, 100);
+
+		EXPECT_TRUE(arrival_observe(&rate, arrival(2, 110), 9));
+		EXPECT_DOUBLE_EQ(rate.gap, 100 + ARRIVAL_SMOOTHING * (10 - 100));
+		EXPECT_DOUBLE_EQ(rate.size, 4 + ARRIVAL_SMOOTHING * (9 - 4));
+		EXPECT_EQ(rate.seen, 3);
+	}
+
+	// a job asked about again after a refresh is still the one arrival
+	TEST(Arrivals, SameJobOnce) {
+		arrival_rate rate{};
+		EXPECT_TRUE(arrival_observe(&rate, arrival(0, 0), 1));
+		EXPECT_TRUE(arrival_observe(&rate, arrival(1, 50), 1));
+		EXPECT_FALSE(arrival_observe(&rate, arrival(1, 50), 1));
+		EXPECT_EQ(rate.seen, 2);
+		EXPECT_DOUBLE_EQ(rate.gap, 50);
+	}
+
+	// jobs submitted together are a second apart, and a stream that's gone quiet is slower than its smoothed gap
+	TEST(Arrivals, GapAsOfNow) {
+		arrival_rate rate{};
+		arrival_observe(&rate, arrival(0, 100), 1);
+		arrival_observe(&rate, arrival(1, 100), 1);
+		EXPECT_DOUBLE_EQ(arrival_gap(&rate, 100), 1);
+		EXPECT_DOUBLE_EQ(arrival_gap(&rate, 400), 300);
+		EXPECT_DOUBLE_EQ(arrival_gap(&rate, 50), 1);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "../src/async_client.h"
+#include "test_util.h"
+#include <gtest/gtest.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+	// the messages, received one after another
+	task<std::vector<std::string>> receiveLines(async_connection &connection, size_t count) {
+		std::vector<std::string> lines;
+		while(lines.size() < count) lines.push_back(co_await connection.receive_line());
+		co_return lines;
+	}
+
+	task<void> sendLine(async_connection &connection, const char *msg) {
+		co_await connection.send(msg);
+	}
+
+	TEST(AsyncConnection, ReceivesWhatsBuffered) {
+		ClientPair pair(true);
+		event_loop loop;
+		async_connection connection(loop, pair.client);
+		pair.serverWrite("OK\nDATA 1 124\n");
+		EXPECT_EQ(loop.run(receiveLines(connection, 2)), (std::vector<std::string>{ "OK", "DATA 1 124" }));
+	}
+
+	// half a line is held until the rest arrives, and the wait for it runs deferred work
+	TEST(AsyncConnection, WaitsForTheRestOfALine) {
+		ClientPair pair(true);
+		event_loop loop;
+		async_connection connection(loop, pair.client);
+		pair.serverWrite("JOBN 0 1 ");
+		loop.defer([&pair] { pair.serverWrite("2 3 4 5\nNONE\n"); });
+		EXPECT_EQ(loop.run(receiveLines(connection, 2)), (std::vector<std::string>{ "JOBN 0 1 2 3 4 5", "NONE" }));
+		EXPECT_EQ(loop.deferred_while_waiting(), 1);
+		EXPECT_EQ(loop.deferred_settled(), 0);
+	}
+
+	TEST(AsyncConnection, SendsAsClientSendDoes) {
+		for(bool newline : { false, true }) {
+			ClientPair pair(newline);
+			event_loop loop;
+			async_connection connection(loop, pair.client);
+			loop.run(sendLine(connection, "REDY"));
+			EXPECT_EQ(pair.serverRead(), newline ? "REDY\n" : "REDY");
+		}
+	}
+
+	TEST(AsyncConnection, ClosedConnectionThrows) {
+		ClientPair pair(true);
+		event_loop loop;
+		async_connection connection(loop, pair.client);
+		pair.serverWrite("OK\n");
+		close(pair.server_fd);
+		pair.server_fd = -1;
+		EXPECT_THROW(loop.run(receiveLines(connection, 2)), std::runtime_error);
+	}
+
+	// the client is left blocking once the connection's done with it, for QUIT
+	TEST(AsyncConnection, RestoresBlocking) {
+		ClientPair pair(true);
+		event_loop loop;
+		{
+			async_connection connection(loop, pair.client);
+			EXPECT_TRUE(fcntl(pair.client->fd, F_GETFL) & O_NONBLOCK);
+		}
+		EXPECT_FALSE(fcntl(pair.client->fd, F_GETFL) & O_NONBLOCK);
+	}
+
+	TEST(AsyncConnection, RefusesTraces) {
+		ClientPair pair(true);
+		char path[] = "/tmp/async-trace-XXXXXX";
+		close(mkstemp(path));
+		ASSERT_TRUE(client_record(pair.client, path));
+		event_loop loop;
+		EXPECT_THROW(async_connection(loop, pair.client), std::invalid_argument);
+		unlink(path);
+	}
+
+	// whatever hasn't run while waiting runs on settle, in the order it was deferred
+	TEST(EventLoop, SettleRunsInOrder) {
+		event_loop loop;
+		std::vector<int> ran;
+		for(int i = 0; i < 3; ++i) loop.defer([&ran, i] { ran.push_back(i); });
+		EXPECT_TRUE(ran.empty());
+		loop.settle();
+		EXPECT_EQ(ran, (std::vector<int>{ 0, 1, 2 }));
+		EXPECT_EQ(loop.deferred_settled(), 3);
+		loop.settle();
+		EXPECT_EQ(loop.deferred_settled(), 3);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#define EXTERN_C
+extern "C" {
+#include "../src/algorithms.h"
+}
+#undef EXTERN_C
+#include "../src/capacity_index.h"
+#include "random_fleet.h"
+#include <gtest/gtest.h>
+#include <string>
+
+namespace {
+	constexpr const char* configSimple2Path = "test-data/config_simple2-system.xml";
+
+	// any amount free, so ties are common
+	constexpr fleet_spread fleetSpread{ { 40, 30, 20 }, false };
+	constexpr job_spread jobSpread{ 4, 300, 8, 10, 8 };
+
+	void expectSameAsScans(system_config *config, const job_info &job) {
+		EXPECT_EQ(best_fit(config, job), best_fit_scan(config, job)) << "best fit, job " << job.id;
+		EXPECT_EQ(worst_fit(config, job), worst_fit_scan(config, job)) << "worst fit, job " << job.id;
+	}
+
+	TEST(CapacityIndex, SameAsScansOnRandomFleets) {
+		Lcg lcg{ 1 };
+		for(int fleet = 0; fleet < 20; ++fleet) {
+			system_config *config = randomFleet(lcg, fleetSpread);
+			for(uintmax_t j = 0; j < 200; ++j) expectSameAsScans(config, randomJob(lcg, j, jobSpread));
+			free_config(config);
+		}
+	}
+
+	// every way a server changes has to move it in the index
+	TEST(CapacityIndex, FollowsEveryChange) {
+		Lcg lcg{ 2 };
+		system_config *config = randomFleet(lcg, fleetSpread);
+		for(uintmax_t j = 0; j < 500; ++j) {
+			server_info &server = config->servers[lcg.next(config->num_servers)];
+			const resource_info &max = server.type->max_resc;
+			switch(lcg.next(5)) {
+				case 0:
+					server.update(static_cast<server_state>(lcg.next(5)), static_cast<intmax_t>(lcg.next(300)), resource_info{ lcg.next(max.cores + 1), max.memory, max.disk });
+					break;
+				case 1:
+					server.assign(randomJob(lcg, j, jobSpread));
+					break;
+				case 2:
+					config->advance(static_cast<intmax_t>(j));
+					break;
+				case 3:
+					server.reset();
+					break;
+				default:
+					server.state = SS_UNAVAILABLE;
+					sync_server(&server);
+			}
+			expectSameAsScans(config, randomJob(lcg, j, jobSpread));
+		}
+		free_config(config);
+	}
+
+	TEST(CapacityIndex, RealConfig) {
+		system_config *config = parse_config(configSimple2Path);
+		ASSERT_NE(config, nullptr);
+		ASSERT_NE(config->capacity, nullptr);
+
+		// nothing is running, so worst-fit wants the biggest inactive server, best-fit the smallest that fits
+		job_info job{ 0, 0, 100, resource_info{ 2, 1000, 1000 } };
+		server_info *worst = worst_fit(config, job);
+		server_info *best = best_fit(config, job);
+		ASSERT_NE(worst, nullptr);
+		ASSERT_NE(best, nullptr);
+		for(size_t t = 0; t < config->num_types; ++t) {
+			EXPECT_LE(config->types[t].max_resc.cores, worst->type->max_resc.cores);
+			if(job_can_run(&job, config->types[t].max_resc)) EXPECT_GE(config->types[t].max_resc.cores, best->type->max_resc.cores);
+		}
+		expectSameAsScans(config, job);
+
+		// a job bigger than any server has nowhere to go
+		job.req_resc.cores = 1000;
+		EXPECT_EQ(best_fit(config, job), nullptr);
+		EXPECT_EQ(worst_fit(config, job), nullptr);
+		free_config(config);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,152 @@
+#define EXTERN_C
+extern "C" {
+#include "../src/algorithms.h"
+}
+#undef EXTERN_C
+#include "../src/capacity_tree.h"
+#include "random_fleet.h"
+#include <gtest/gtest.h>
+#include <string>
+
+namespace {
+	constexpr const char* configSimple2Path = "test-data/config_simple2-system.xml";
+
+	// several blocks of servers per type, so the walk crosses blocks and subtrees, with some left mostly full
+	constexpr fleet_spread fleetSpread{ { 150, 100, 70 }, true };
+	constexpr job_spread jobSpread{ 4, 300, 8, 17, 17 };
+
+	// first-fit by the definition, reading the servers themselves rather than the columns
+	server_info *bruteForce(system_config *config, const job_info &job) {
+		for(size_t s = 0; s < config->num_servers; ++s) {
+			server_info &server = config->servers[s];
+			if(server.state != SS_UNAVAILABLE && job.can_run(server.avail_resc)) return &server;
+		}
+		for(size_t s = 0; s < config->num_servers; ++s) {
+			server_info &server = config->servers[s];
+			if(server.state != SS_UNAVAILABLE && job.can_run(server.type->max_resc)) return &server;
+		}
+		return nullptr;
+	}
+
+	void expectSameAsBruteForce(system_config *config, const job_info &job) {
+		server_info *expected = bruteForce(config, job);
+		EXPECT_EQ(first_fit(config, job), expected) << "job " << job.id;
+		EXPECT_EQ(first_fit_scan(config, job), expected) << "job " << job.id;
+	}
+
+	TEST(CapacityTree, SameAsBruteForceOnRandomFleets) {
+		Lcg lcg{ 1 };
+		for(int fleet = 0; fleet < 20; ++fleet) {
+			system_config *config = randomFleet(lcg, fleetSpread);
+			for(uintmax_t j = 0; j < 200; ++j) expectSameAsBruteForce(config, randomJob(lcg, j, jobSpread));
+			free_config(config);
+		}
+	}
+
+	// every way a server changes has to reach the tree
+	TEST(CapacityTree, FollowsEveryChange) {
+		Lcg lcg{ 2 };
+		system_config *config = randomFleet(lcg, fleetSpread);
+		for(uintmax_t j = 0; j < 1000; ++j) {
+			server_info &server = config->servers[lcg.next(config->num_servers)];
+			const resource_info &max = server.type->max_resc;
+			switch(lcg.next(6)) {
+				case 0:
+					server.update(static_cast<server_state>(lcg.next(5)), static_cast<intmax_t>(lcg.next(300)), resource_info{ lcg.next(max.cores + 1), 1000 * lcg.next(max.memory / 1000 + 1), max.disk });
+					break;
+				case 1:
+					server.assign(randomJob(lcg, j, jobSpread));
+					break;
+				case 2:
+					config->advance(static_cast<intmax_t>(j));
+					break;
+				case 3:
+					server.reset();
+					break;
+				case 4:
+					// only the memory and disk, which best-fit and worst-fit don't order by
+					server.avail_resc.memory = 1000 * lcg.next(max.memory / 1000 + 1);
+					server.avail_resc.disk = 4000 * lcg.next(max.disk / 4000 + 1);
+					sync_server(&server);
+					break;
+				default:
+					server.state = SS_UNAVAILABLE;
+					sync_server(&server);
+			}
+			expectSameAsBruteForce(config, randomJob(lcg, j, jobSpread));
+		}
+		free_config(config);
+	}
+
+	// servers that each have enough of one resource but not all three, so the walk has to back out of subtrees
+	TEST(CapacityTree, NoServerHasEverything) {
+		char name[] = "odd";
+		server_type type{ name, 1000, 60, 0.1f, resource_info{ 8, 8000, 8000 } };
+		system_config *config = create_config(&type, 1);
+		for(size_t s = 0; s < config->num_servers; ++s) {
+			server_info &server = config->servers[s];
+			server.state = SS_ACTIVE;
+			server.avail_resc = s % 3 == 0 ? resource_info{ 8, 0, 0 } : s % 3 == 1 ? resource_info{ 0, 8000, 0 } : resource_info{ 0, 0, 8000 };
+			sync_server(&server);
+		}
+
+		// nothing fits now, so it's the first server, which could run it once free
+		job_info job{ 0, 0, 100, resource_info{ 1, 1000, 1000 } };
+		EXPECT_EQ(first_fit(config, job), &config->servers[0]);
+
+		// until one near the end frees up
+		server_info &last = config->servers[997];
+		last.avail_resc = resource_info{ 1, 1000, 1000 };
+		sync_server(&last);
+		EXPECT_EQ(first_fit(config, job), &last);
+
+		// and an unavailable one is never chosen
+		last.state = SS_UNAVAILABLE;
+		sync_server(&last);
+		EXPECT_EQ(first_fit(config, job), &config->servers[0]);
+		config->servers[0].state = SS_UNAVAILABLE;
+		sync_server(&config->servers[0]);
+		EXPECT_EQ(first_fit(config, job), &config->servers[1]);
+		free_config(config);
+	}
+
+	// a server gaining memory and disk while its cores stay the same still has to reach the tree
+	TEST(CapacityTree, MemoryAndDiskAlone) {
+		char name[] = "cores";
+		server_type type{ name, 1000, 60, 0.1f, resource_info{ 8, 8000, 8000 } };
+		system_config *config = create_config(&type, 1);
+		for(size_t s = 0; s < config->num_servers; ++s) {
+			config->servers[s].state = SS_ACTIVE;
+			config->servers[s].avail_resc = resource_info{ 4, 0, 0 };
+			sync_server(&config->servers[s]);
+		}
+
+		job_info job{ 0, 0, 100, resource_info{ 1, 1000, 1000 } };
+		EXPECT_EQ(first_fit(config, job), &config->servers[0]);
+
+		server_info &server = config->servers[700];
+		server.avail_resc.memory = server.avail_resc.disk = 8000;
+		sync_server(&server);
+		EXPECT_EQ(first_fit(config, job), &server);
+		free_config(config);
+	}
+
+	TEST(CapacityTree, RealConfig) {
+		system_config *config = parse_config(configSimple2Path);
+		ASSERT_NE(config, nullptr);
+		ASSERT_NE(config->first_fit, nullptr);
+
+		// nothing is running, so it's the first server of the first type big enough
+		job_info job{ 0, 0, 100, resource_info{ 2, 1000, 1000 } };
+		server_info *first = first_fit(config, job);
+		ASSERT_NE(first, nullptr);
+		EXPECT_EQ(first->id, 0u);
+		for(size_t t = 0; config->types + t != first->type; ++t) EXPECT_FALSE(job_can_run(&job, config->types[t].max_resc));
+		expectSameAsBruteForce(config, job);
+
+		// a job bigger than any server has nowhere to go
+		job.req_resc.cores = 1000;
+		EXPECT_EQ(first_fit(config, job), nullptr);
+		free_config(config);
+	}
+}
\ No newline at end of file
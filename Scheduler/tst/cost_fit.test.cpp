@@ -0,0 +1,101 @@
+#define EXTERN_C
+extern "C" {
+#include "../src/cost_fit.h"
+}
+#undef EXTERN_C
+#include <gtest/gtest.h>
+#include <string>
+
+namespace {
+	char tinyName[] = "tiny";
+	char largeName[] = "large";
+	const server_type types[]{
+		{ tinyName, 1, 60, 0.1f, resource_info{ 1, 1000, 4000 } },
+		{ largeName, 1, 60, 0.8f, resource_info{ 8, 32000, 256000 } }
+	};
+
+	// one tiny server then one large one, both inactive
+	system_config *fleet() {
+		return create_config(types, 2);
+	}
+
+	void makeIdle(server_info *server) {
+		server->state = SS_IDLE;
+		server->avail_time = 0;
+		sync_server(server);
+	}
+
+	TEST(CostFit, CheaperTypeForSmallJob) {
+		system_config *config = fleet();
+		EXPECT_EQ(cost_fit(config, job_info{ 0, 0, 1000, resource_info{ 1, 500, 500 } }), &config->servers[0]);
+		free_config(config);
+	}
+
+	// a job that's done before the server's other jobs are costs nothing, so it's worth leaving a snugger fit for
+	TEST(CostFit, ShareBusyServer) {
+		system_config *config = fleet();
+		makeIdle(&config->servers[0]);
+		makeIdle(&config->servers[1]);
+		config->servers[1].assign(job_info{ 0, 0, 10000, resource_info{ 2, 1000, 1000 } });
+
+		job_info job{ 0, 1, 100, resource_info{ 1, 500, 500 } };
+		EXPECT_EQ(estimate_cost(&config->servers[1], job).cost, 0);
+		EXPECT_EQ(cost_fit(config, job), &config->servers[1]);
+		EXPECT_EQ(best_fit(config, job), &config->servers[0]);
+		free_config(config);
+	}
+
+	// waiting for the busy tiny server is cheap but slow, booting the large one is quick but dear
+	TEST(CostFit, WeightTradesWaitForCost) {
+		system_config *config = fleet();
+		makeIdle(&config->servers[0]);
+		config->servers[0].assign(job_info{ 0, 0, 1000, resource_info{ 1, 500, 500 } });
+		job_info job{ 0, 1, 100, resource_info{ 1, 500, 500 } };
+
+		EXPECT_EQ(estimate_cost(&config->servers[0], job).turnaround, 1100);
+		EXPECT_EQ(estimate_cost(&config->servers[1], job).turnaround, 160);
+
+		for(double weight : { 0.0, 0.5, 1.0 }) {
+			cost_model *model = cost_model_create(config, weight);
+			ASSERT_NE(model, nullptr);
+			config->context.costs = model;
+			EXPECT_EQ(cost_fit(config, job), &config->servers[weight < 0.5 ? 1 : 0]) << "With: weight=" << weight;
+			config->context.costs = nullptr;
+			cost_model_free(model);
+		}
+		free_config(config);
+	}
+
+	// booting is billed along with the job, and a server is only counted the first time it's given one
+	TEST(CostFit, TallyEstimates) {
+		system_config *config = fleet();
+		cost_model *model = cost_model_create(config, COST_WEIGHT);
+		ASSERT_NE(model, nullptr);
+
+		job_info first{ 0, 0, 3540, resource_info{ 1, 500, 500 } };
+		cost_model_record(model, &config->servers[0], estimate_cost(&config->servers[0], first));
+		config->servers[0].assign(first);
+
+		job_info second{ 0, 1, 3600, resource_info{ 1, 500, 500 } };
+		cost_model_record(model, &config->servers[0], estimate_cost(&config->servers[0], second));
+		config->servers[0].assign(second);
+
+		cost_summary tiny = cost_model_summary(model, &config->types[0]);
+		EXPECT_NEAR(tiny.cost, 0.2, 1e-6);
+		EXPECT_EQ(tiny.turnaround, 3600 + 7200);
+		EXPECT_EQ(tiny.jobs, 2);
+		EXPECT_EQ(tiny.servers, 1);
+
+		EXPECT_EQ(cost_model_summary(model, &config->types[1]).jobs, 0);
+		EXPECT_EQ(cost_model_summary(model, nullptr).jobs, 2);
+
+		cost_model_free(model);
+		free_config(config);
+	}
+
+	TEST(CostFit, TooBigForEveryServer) {
+		system_config *config = fleet();
+		EXPECT_EQ(cost_fit(config, job_info{ 0, 0, 100, resource_info{ 9, 500, 500 } }), nullptr);
+		free_config(config);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#define EXTERN_C
+extern "C" {
+#include "../src/easy_backfill.h"
+}
+#undef EXTERN_C
+#include <gtest/gtest.h>
+#include <string>
+
+namespace {
+	char typeName[] = "large";
+	const server_type type{ typeName, 2, 60, 0.4f, resource_info{ 8, 16000, 64000 } };
+
+	/*
+	two running servers, the first with a job using `running` cores until 1000 and a job that needs
+	`waiting` cores queued behind it, which is reserved to start at 1000. the second has nothing on it
+	*/
+	system_config *reservedFleet(uintmax_t running, uintmax_t waiting) {
+		system_config *config = create_config(&type, 1);
+		for(size_t s = 0; s < config->num_servers; ++s) {
+			config->servers[s].state = SS_IDLE;
+			sync_server(&config->servers[s]);
+		}
+		config->servers[0].assign(job_info{ 0, 0, 1000, resource_info{ running, 1000, 1000 } });
+		config->servers[0].assign(job_info{ 0, 1, 1000, resource_info{ waiting, 1000, 1000 } });
+		return config;
+	}
+
+	// a short job fills the gap in front of the reservation, as it's the snuggest fit
+	TEST(EasyBackfill, FinishesBeforeReservation) {
+		system_config *config = reservedFleet(6, 8);
+		EXPECT_EQ(easy_backfill(config, job_info{ 100, 2, 900, resource_info{ 2, 1000, 1000 } }), &config->servers[0]);
+		free_config(config);
+	}
+
+	// a long one would still be running when the waiting job is due to start, so goes elsewhere
+	TEST(EasyBackfill, WouldDelayReservation) {
+		system_config *config = reservedFleet(6, 8);
+		EXPECT_EQ(easy_backfill(config, job_info{ 100, 2, 901, resource_info{ 2, 1000, 1000 } }), &config->servers[1]);
+
+		// best-fit would take the snuggest fit regardless
+		EXPECT_EQ(best_fit(config, job_info{ 100, 2, 901, resource_info{ 2, 1000, 1000 } }), &config->servers[0]);
+		free_config(config);
+	}
+
+	// the waiting job leaves room for it, so how long it runs doesn't matter
+	TEST(EasyBackfill, RoomBesideReservation) {
+		system_config *config = reservedFleet(6, 4);
+		EXPECT_EQ(easy_backfill(config, job_info{ 100, 2, 5000, resource_info{ 2, 1000, 1000 } }), &config->servers[0]);
+		free_config(config);
+	}
+
+	// with nowhere else to run, it holds up the waiting job rather than not running
+	TEST(EasyBackfill, NowhereElse) {
+		system_config *config = reservedFleet(6, 8);
+		ASSERT_TRUE(config->servers[1].update(SS_UNAVAILABLE, -1, type.max_resc));
+		EXPECT_EQ(easy_backfill(config, job_info{ 100, 2, 5000, resource_info{ 2, 1000, 1000 } }), &config->servers[0]);
+		free_config(config);
+	}
+
+	// a job that can't start anywhere goes where it's predicted to start first
+	TEST(EasyBackfill, WaitsForSoonestStart) {
+		system_config *config = reservedFleet(6, 8);
+		config->servers[1].assign(job_info{ 0, 3, 500, resource_info{ 7, 1000, 1000 } });
+		EXPECT_EQ(easy_backfill(config, job_info{ 100, 2, 100, resource_info{ 4, 1000, 1000 } }), &config->servers[1]);
+		free_config(config);
+	}
+
+	TEST(EasyBackfill, TooBigForEveryServer) {
+		system_config *config = reservedFleet(6, 8);
+		EXPECT_EQ(easy_backfill(config, job_info{ 100, 2, 100, resource_info{ 9, 1000, 1000 } }), nullptr);
+		free_config(config);
+	}
+}
\ No newline at end of file
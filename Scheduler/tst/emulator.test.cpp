@@ -0,0 +1,352 @@
+#define EXTERN_C
+extern "C" {
+#include "../src/algorithms.h"
+}
+#undef EXTERN_C
+#include "../emulator/emulator.h"
+#include "../src/protocol.h"
+#ifdef USE_ASYNC
+#include "../src/async_client.h"
+#endif
+#include "test_util.h"
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+	constexpr const char* emulatorConfigPath = "test-data/emulator-config.xml";
+
+	// runs each test in a directory of its own, since the emulator writes system.xml wherever it's run from
+	class EmulatorTest : public ::testing::Test {
+	protected:
+		char original_dir[PATH_MAX];
+		char temp_dir[32];
+		emulator *emu;
+
+		void SetUp() override {
+			char config_path[PATH_MAX];
+			ASSERT_NE(getcwd(original_dir, sizeof original_dir), nullptr);
+			ASSERT_NE(realpath(emulatorConfigPath, config_path), nullptr);
+			strcpy(temp_dir, "/tmp/emulator-test-XXXXXX");
+			ASSERT_NE(mkdtemp(temp_dir), nullptr);
+			ASSERT_EQ(chdir(temp_dir), 0);
+			emu = emulator_create(config_path);
+			ASSERT_NE(emu, nullptr);
+		}
+
+		void TearDown() override {
+			if(emu != nullptr) emulator_free(emu);
+			unlink("system.xml");
+			chdir(original_dir);
+			rmdir(temp_dir);
+		}
+
+		// every job the emulator sends, without scheduling any of them
+		std::vector<std::string> allJobs() {
+			std::vector<std::string> jobs;
+			socket_client *client = emulator_connect(emu);
+			client_send(client, "REDY");
+			for(const char *msg = client_receive(client); message_type_of(msg) == MSG_JOBN; msg = client_receive(client)) {
+				jobs.push_back(msg);
+				client_send(client, "REDY");
+			}
+			client_send(client, "QUIT");
+			client_receive(client);
+			emulator_wait(emu);
+			client_free(client);
+			return jobs;
+		}
+
+		// sends a request and collects the rows of the listing it starts
+		std::vector<std::string> listing(socket_client *client, const char *request) {
+			std::vector<std::string> rows;
+			if(!client_msg_resp(client, request, "DATA")) return rows;
+			client_send(client, "OK");
+			for(const char *msg = client_receive(client); strcmp(msg, "."); msg = client_receive(client)) {
+				rows.push_back(msg);
+				client_send(client, "OK");
+			}
+			return rows;
+		}
+
+		// the REDYs, RESCs and SCHDs the client sent for one batch, from the first REDY after the last batch's SCHDs to its own last SCHD
+		struct batch {
+			size_t redy;
+			size_t resc;
+			std::vector<uintmax_t> scheduled; // job ids, in the order they were sent
+		};
+
+		// runs a session with the options, returning everything the client sent, a message per line
+		std::string session(run_options options, void (*run)(socket_client*, run_options) = run_algorithm) {
+			FILE *log = tmpfile();
+			emulator_log(emu, log);
+			socket_client *client = emulator_connect(emu);
+			run(client, options);
+			emulator_wait(emu);
+			client_free(client);
+			emulator_log(emu, nullptr);
+			std::string sent = contents(log);
+			fclose(log);
+			return sent;
+		}
+
+		// runs a session with the options, and splits what the client sent into batches
+		std::vector<batch> batches(run_options options) {
+			std::vector<batch> sent(1, batch{ 0, 0, {} });
+			std::istringstream log(session(options));
+			for(std::string line; std::getline(log, line);) {
+				uintmax_t id;
+				if(!line.compare(0, 4, "REDY")) {
+					if(!sent.back().scheduled.empty()) sent.push_back(batch{ 0, 0, {} });
+					++sent.back().redy;
+				} else if(!line.compare(0, 4, "RESC")) {
+					++sent.back().resc;
+				} else if(sscanf(line.c_str(), "SCHD %ju", &id) == 1) {
+					sent.back().scheduled.push_back(id);
+				}
+			}
+
+			// the last REDY only gets NONE
+			if(sent.back().scheduled.empty()) sent.pop_back();
+			return sent;
+		}
+
+		// every job the emulator sends, parsed and indexed by id
+		std::vector<job_info> parsedJobs() {
+			std::vector<job_info> jobs;
+			for(auto &msg : allJobs()) {
+				job_info job;
+				parse_error error;
+				EXPECT_TRUE(parse_job(msg.c_str(), &job, &error)) << msg;
+				EXPECT_EQ(job.id, jobs.size());
+				jobs.push_back(job);
+			}
+			return jobs;
+		}
+	};
+
+	TEST(EmulatorCreate, NoSuchFile) {
+		EXPECT_EQ(emulator_create("test-data/this should break.xml"), nullptr);
+	}
+
+	TEST(EmulatorCreate, NotADsSimConfig) {
+		EXPECT_EQ(emulator_create("test-data/system.xml"), nullptr);
+	}
+
+	TEST_F(EmulatorTest, JobCountTermination) {
+		EXPECT_EQ(emulator_num_jobs(emu), 30);
+		EXPECT_FALSE(emulator_newline(emu));
+	}
+
+	TEST_F(EmulatorTest, GreetingWritesSystemXml) {
+		socket_client *client = emulator_connect(emu);
+		ASSERT_NE(client, nullptr);
+		system_config *config = parse_config("system.xml");
+		ASSERT_NE(config, nullptr);
+		ASSERT_EQ(config->num_types, 2);
+		EXPECT_STREQ(config->types[1].name, "large");
+		EXPECT_EQ(config->types[1].bootTime, 120);
+		EXPECT_EQ(config->num_servers, 3);
+		free_config(config);
+		client_send(client, "QUIT");
+		EXPECT_STREQ(client_receive(client), "QUIT");
+		EXPECT_TRUE(emulator_wait(emu));
+		client_free(client);
+	}
+
+	TEST_F(EmulatorTest, SameWorkloadEverySession) {
+		auto first = allJobs();
+		auto second = allJobs();
+		ASSERT_EQ(first.size(), 30);
+		EXPECT_EQ(first, second);
+		for(auto &msg : first) {
+			job_info job;
+			parse_error error;
+			EXPECT_TRUE(parse_job(msg.c_str(), &job, &error)) << msg;
+		}
+	}
+
+	TEST_F(EmulatorTest, BootThenRun) {
+		socket_client *client = emulator_connect(emu);
+		ASSERT_NE(client, nullptr);
+		client_send(client, "REDY");
+		job_info job;
+		parse_error error;
+		ASSERT_TRUE(parse_job(client_receive(client), &job, &error));
+		intmax_t boot_end = static_cast<intmax_t>(job.submit_time) + 120;
+
+		auto before = listing(client, "RESC Type large");
+		ASSERT_EQ(before.size(), 1);
+		EXPECT_EQ(before[0], "large 0 0 " + std::to_string(boot_end) + " 8 32000 256000");
+
+		std::string schd = "SCHD " + std::to_string(job.id) + " large 0";
+		ASSERT_TRUE(client_msg_resp(client, schd.c_str(), "OK"));
+
+		// booting, with the job's resources already reserved for when it starts
+		auto booting = listing(client, "RESC Type large");
+		ASSERT_EQ(booting.size(), 1);
+		resc_row row;
+		ASSERT_TRUE(parse_resc_row(booting[0].c_str(), &row, &error));
+		EXPECT_EQ(row.state, SS_BOOTING);
+		EXPECT_EQ(row.avail_time, -1);
+		EXPECT_EQ(row.avail_resc, (resource_info{8, 32000, 256000} - job.req_resc));
+
+		auto jobs = listing(client, "LSTJ large 0");
+		ASSERT_EQ(jobs.size(), 1);
+		lstj_row job_row;
+		ASSERT_TRUE(parse_lstj_row(jobs[0].c_str(), &job_row, &error));
+		EXPECT_EQ(job_row.schd.job_id, job.id);
+		EXPECT_EQ(job_row.job_state, 1);
+		EXPECT_EQ(job_row.schd.start_time, boot_end);
+
+		// the same job can't be scheduled twice
+		EXPECT_FALSE(client_msg_resp(client, schd.c_str(), "OK"));
+
+		client_send(client, "QUIT");
+		EXPECT_STREQ(client_receive(client), "QUIT");
+		EXPECT_TRUE(emulator_wait(emu));
+		client_free(client);
+
+		auto summary = emulator_get_summary(emu);
+		EXPECT_EQ(summary.jobs_scheduled, 1);
+		EXPECT_EQ(summary.servers_used, 1);
+		EXPECT_EQ(summary.avg_waiting_time, 120);
+		EXPECT_GT(summary.total_cost, 0);
+	}
+
+	TEST_F(EmulatorTest, Errors) {
+		socket_client *client = emulator_connect(emu);
+		ASSERT_NE(client, nullptr);
+		client_send(client, "FOO");
+		EXPECT_STREQ(client_receive(client), "ERR: invalid command (FOO)");
+		client_send(client, "SCHD 0 small 0");
+		EXPECT_STREQ(client_receive(client), "ERR: No such waiting job exists");
+		client_send(client, "REDY");
+		client_receive(client);
+		client_send(client, "SCHD 0 medium 0");
+		EXPECT_STREQ(client_receive(client), "ERR: No such server exists");
+		client_send(client, "LSTJ small 2");
+		EXPECT_STREQ(client_receive(client), "ERR: invalid job listing query");
+		client_send(client, "QUIT");
+		EXPECT_STREQ(client_receive(client), "QUIT");
+		EXPECT_TRUE(emulator_wait(emu));
+		client_free(client);
+	}
+
+	TEST_F(EmulatorTest, Disconnect) {
+		socket_client *client = emulator_connect(emu);
+		ASSERT_NE(client, nullptr);
+		client_free(client);
+		EXPECT_FALSE(emulator_wait(emu));
+	}
+
+	TEST_F(EmulatorTest, RunAlgorithm) {
+		for(auto algorithm : { BEST_FIT, WORST_FIT, PREDICTIVE_FIT, EASY_BACKFILL, COST_FIT, ADAPTIVE_FIT }) {
+			for(size_t sync_interval : { 1, 10 }) {
+				socket_client *client = emulator_connect(emu);
+				ASSERT_NE(client, nullptr);
+				run_algorithm(client, run_options{ algorithm, sync_interval });
+				EXPECT_TRUE(emulator_wait(emu)) << "With: algorithm=" << algorithm << ", sync_interval=" << sync_interval << std::endl;
+				client_free(client);
+				EXPECT_EQ(emulator_get_summary(emu).jobs_scheduled, 30) << "With: algorithm=" << algorithm << ", sync_interval=" << sync_interval << std::endl;
+			}
+		}
+	}
+
+#ifdef USE_ASYNC
+	// the coroutine client sends exactly what the blocking one does, the work it moves into the waits changes no decision
+	TEST_F(EmulatorTest, RunAlgorithmAsync) {
+		for(auto algorithm : { BEST_FIT, WORST_FIT, PREDICTIVE_FIT, EASY_BACKFILL, COST_FIT, ADAPTIVE_FIT }) {
+			for(size_t sync_interval : { 1, 10 }) {
+				for(double preboot : { 0.0, 2.0 }) {
+					run_options options{ algorithm, sync_interval };
+					options.preboot = preboot;
+					std::string blocking = session(options);
+					std::string async = session(options, run_algorithm_async);
+					EXPECT_EQ(emulator_get_summary(emu).jobs_scheduled, 30) << "With: algorithm=" << algorithm << ", sync_interval=" << sync_interval << ", preboot=" << preboot;
+					EXPECT_EQ(async, blocking) << "With: algorithm=" << algorithm << ", sync_interval=" << sync_interval << ", preboot=" << preboot;
+				}
+			}
+		}
+	}
+#endif
+
+	// every job still gets scheduled when they're taken in batches, whether batches end on size, time or the last job
+	TEST_F(EmulatorTest, RunBatches) {
+		for(auto algorithm : { FIRST_FIT, BEST_FIT, PREDICTIVE_FIT }) {
+			for(size_t batch_size : { 2, 7, 100 }) {
+				for(uintmax_t batch_window : { 0, 200 }) {
+					socket_client *client = emulator_connect(emu);
+					ASSERT_NE(client, nullptr);
+					run_options options{ algorithm, 1, 1, batch_size, batch_window };
+					run_algorithm(client, options);
+					EXPECT_TRUE(emulator_wait(emu)) << "With: algorithm=" << algorithm << ", batch_size=" << batch_size << ", batch_window=" << batch_window;
+					client_free(client);
+					EXPECT_EQ(emulator_get_summary(emu).jobs_scheduled, 30) << "With: algorithm=" << algorithm << ", batch_size=" << batch_size << ", batch_window=" << batch_window;
+				}
+			}
+		}
+	}
+
+	// a full batch is fetched with one REDY per job, the servers are listed once, and then every job is sent biggest first
+	TEST_F(EmulatorTest, BatchRefreshesOnceLargestFirst) {
+		auto jobs = parsedJobs();
+		ASSERT_EQ(jobs.size(), 30);
+		auto sent = batches(run_options{ BEST_FIT, 1, 1, 7, 0 });
+
+		ASSERT_EQ(sent.size(), 5);
+		for(size_t b = 0; b < sent.size(); ++b) {
+			size_t first = b * 7, size = std::min<size_t>(7, jobs.size() - first);
+			EXPECT_EQ(sent[b].resc, 1) << "batch " << b;
+			// the last batch asks once more, and is told there are no more jobs
+			EXPECT_EQ(sent[b].redy, b + 1 < sent.size() ? size : size + 1) << "batch " << b;
+
+			auto scheduled = sent[b].scheduled;
+			ASSERT_EQ(scheduled.size(), size) << "batch " << b;
+			for(size_t i = 1; i < scheduled.size(); ++i) {
+				const job_info &prev = jobs[scheduled[i - 1]], &cur = jobs[scheduled[i]];
+				auto key = [](const job_info &job) { return std::make_tuple(-static_cast<intmax_t>(job.req_resc.cores), -static_cast<intmax_t>(job.req_resc.memory), -static_cast<intmax_t>(job.req_resc.disk), job.id); };
+				EXPECT_LT(key(prev), key(cur)) << "batch " << b << ": job " << prev.id << " sent before job " << cur.id;
+			}
+
+			std::sort(scheduled.begin(), scheduled.end());
+			for(size_t i = 0; i < size; ++i) EXPECT_EQ(scheduled[i], first + i) << "batch " << b;
+		}
+	}
+
+	// a job submitted more than the window after the batch's first ends the batch, and is the first job of the next one without being asked for again
+	TEST_F(EmulatorTest, BatchWindowHoldsTheNextJob) {
+		constexpr uintmax_t window = 200;
+		auto jobs = parsedJobs();
+		ASSERT_EQ(jobs.size(), 30);
+
+		// the batches the window should cut the workload into, by the index of their first job
+		std::vector<size_t> starts{ 0 };
+		for(size_t j = 1; j < jobs.size(); ++j) {
+			if(jobs[j].submit_time > jobs[starts.back()].submit_time + window) starts.push_back(j);
+		}
+		starts.push_back(jobs.size());
+		ASSERT_GT(starts.size(), 3);
+		ASSERT_LT(starts.size(), jobs.size() + 1);
+
+		auto sent = batches(run_options{ BEST_FIT, 1, 1, 100, window });
+		ASSERT_EQ(sent.size(), starts.size() - 1);
+		for(size_t b = 0; b < sent.size(); ++b) {
+			size_t size = starts[b + 1] - starts[b];
+			EXPECT_EQ(sent[b].resc, 1) << "batch " << b;
+			// every batch's last REDY brings the job that ends it, or NONE, so each later batch starts with a job it didn't ask for
+			EXPECT_EQ(sent[b].redy, b == 0 ? size + 1 : size) << "batch " << b;
+
+			auto scheduled = sent[b].scheduled;
+			std::sort(scheduled.begin(), scheduled.end());
+			ASSERT_EQ(scheduled.size(), size) << "batch " << b;
+			for(size_t i = 0; i < size; ++i) EXPECT_EQ(scheduled[i], starts[b] + i) << "batch " << b;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,121 @@
+#define EXTERN_C
+extern "C" {
+#include "../src/algorithms.h"
+}
+#undef EXTERN_C
+#include "../src/fit_kernels.h"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+
+namespace {
+	constexpr const char* configSimple2Path = "test-data/config_simple2-system.xml";
+
+	// every implementation this CPU can run, scalar always among them
+	std::vector<std::string> supportedKernels() {
+		std::vector<std::string> names;
+		std::string original = fit_kernel_name();
+		for(const char *name : { "avx2", "sse4.2", "scalar" }) {
+			if(fit_kernel_use(name)) names.push_back(name);
+		}
+		fit_kernel_use(original.c_str());
+		return names;
+	}
+
+	// a config of `n` servers in arbitrary states, with resources wide enough to need all 32 bits
+	system_config *randomFleet(size_t n, uint64_t seed) {
+		char name[] = "any";
+		server_type type{ name, n, 60, 1.0, resource_info{ 0xF0000000u, 4096, 0xFFFFFFFFu } };
+		system_config *config = create_config(&type, 1);
+		for(size_t s = 0; s < n; ++s) {
+			seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+			server_info &server = config->servers[s];
+			server.state = static_cast<server_state>((seed >> 33) % 5);
+			server.avail_time = static_cast<intmax_t>(seed >> 50);
+			server.avail_resc = resource_info{ (seed >> 20) % 16 + (s % 7 == 0 ? 0xE0000000u : 0), (seed >> 40) % 4096, seed % 3 ? 0xFFFFFFFFu : (seed >> 8) % 100 };
+			sync_server(&server);
+		}
+		return config;
+	}
+
+	TEST(FitKernels, ScalarIsAlwaysSupported) {
+		EXPECT_TRUE(fit_kernel_use("scalar"));
+		EXPECT_STREQ(fit_kernel_name(), "scalar");
+		EXPECT_FALSE(fit_kernel_use("mmx"));
+		EXPECT_STREQ(fit_kernel_name(), "scalar");
+		fit_kernel_use(supportedKernels().front().c_str());
+	}
+
+	// every block size, including the leftovers the vector kernels hand to scalar code, against the plain checks
+	TEST(FitKernels, AgreeWithJobCanRun) {
+		system_config *config = randomFleet(1000, 42);
+		const job_info jobs[] = {
+			job_info{ 0, 0, 1, resource_info{ 3, 1000, 50 } },
+			job_info{ 0, 1, 1, resource_info{ 0, 0, 0 } },
+			job_info{ 0, 2, 1, resource_info{ 0xE0000000u, 0, 0 } },
+			job_info{ 0, 3, 1, resource_info{ 1, 1, uintmax_t(1) << 33 } }
+		};
+
+		for(auto &name : supportedKernels()) {
+			ASSERT_TRUE(fit_kernel_use(name.c_str()));
+			for(auto &job : jobs) {
+				for(size_t count = 1; count <= FIT_BLOCK; ++count) {
+					size_t first = (count * 13) % (config->num_servers - FIT_BLOCK);
+					uint32_t fitness[FIT_BLOCK];
+					fit_result fit = fit_block(&config->columns, first, count, &job, fitness);
+
+					uint64_t mask = 0;
+					uint32_t min = UINT32_MAX, max = 0;
+					for(size_t i = 0; i < count; ++i) {
+						const server_info &server = config->servers[first + i];
+						if(server.state == SS_UNAVAILABLE || !job_can_run(&job, server.avail_resc)) continue;
+						mask |= uint64_t(1) << i;
+						EXPECT_EQ(fitness[i], job_fitness(&job, server.avail_resc)) << name;
+						min = std::min(min, fitness[i]);
+						max = std::max(max, fitness[i]);
+					}
+
+					uint64_t minMask = 0, maxMask = 0;
+					for(size_t i = 0; i < count; ++i) {
+						if(!(mask & (uint64_t(1) << i))) continue;
+						if(fitness[i] == min) minMask |= uint64_t(1) << i;
+						if(fitness[i] == max) maxMask |= uint64_t(1) << i;
+					}
+
+					EXPECT_EQ(fit.mask, mask) << name << " job " << job.id << " count " << count;
+					EXPECT_EQ(fit.min_fitness, min) << name;
+					EXPECT_EQ(fit.max_fitness, max) << name;
+					EXPECT_EQ(fit.min_mask, minMask) << name;
+					EXPECT_EQ(fit.max_mask, maxMask) << name;
+				}
+			}
+		}
+
+		fit_kernel_use(supportedKernels().front().c_str());
+		free_config(config);
+	}
+
+	TEST(FitKernels, SameChoiceWithEveryKernel) {
+		system_config *config = parse_config(configSimple2Path);
+		ASSERT_NE(config, nullptr);
+		for(size_t s = 0; s < config->num_servers; s += 3) {
+			config->servers[s].assign(job_info{ s, s, 100, resource_info{ 1, 100, 100 } });
+		}
+
+		for(auto scan : { best_fit_scan, worst_fit_scan }) {
+			for(uintmax_t cores : { 1, 2, 4, 16, 64 }) {
+				job_info job{ 10, 1000, 100, resource_info{ cores, 1000, 1000 } };
+				const server_info *expected = nullptr;
+				for(auto &name : supportedKernels()) {
+					ASSERT_TRUE(fit_kernel_use(name.c_str()));
+					const server_info *choice = scan(config, job);
+					if(expected == nullptr) expected = choice;
+					EXPECT_EQ(choice, expected) << name << " best fit " << (scan == best_fit_scan) << " cores " << cores;
+				}
+			}
+		}
+
+		fit_kernel_use(supportedKernels().front().c_str());
+		free_config(config);
+	}
+}
\ No newline at end of file
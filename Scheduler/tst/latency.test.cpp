@@ -0,0 +1,106 @@
+#include "../src/latency.h"
+#include "test_util.h"
+#include <gtest/gtest.h>
+#include <csignal>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+namespace {
+
+	TEST(Histogram, Empty) {
+		std::unique_ptr<latency_histogram> histogram(new latency_histogram());
+		EXPECT_EQ(histogram_percentile(histogram.get(), 50), 0);
+		EXPECT_EQ(histogram_percentile(histogram.get(), 100), 0);
+	}
+
+	TEST(Histogram, SmallValuesAreExact) {
+		std::unique_ptr<latency_histogram> histogram(new latency_histogram());
+		for(uint64_t ns = 1; ns <= 10; ++ns) histogram_record(histogram.get(), ns);
+		EXPECT_EQ(histogram->total, 10);
+		EXPECT_EQ(histogram_percentile(histogram.get(), 50), 5);
+		EXPECT_EQ(histogram_percentile(histogram.get(), 90), 9);
+		EXPECT_EQ(histogram_percentile(histogram.get(), 100), 10);
+	}
+
+	TEST(Histogram, PercentilesWithinPrecision) {
+		std::unique_ptr<latency_histogram> histogram(new latency_histogram());
+		for(uint64_t ns = 1; ns <= 1000000; ++ns) histogram_record(histogram.get(), ns * 7);
+
+		for(double percentile : { 1.0, 50.0, 90.0, 99.0, 99.9 }) {
+			double exact = percentile / 100 * 7000000;
+			double reported = static_cast<double>(histogram_percentile(histogram.get(), percentile));
+			EXPECT_GE(reported, exact) << percentile;
+			EXPECT_LE(reported, exact * 33 / 32) << percentile;
+		}
+
+		EXPECT_EQ(histogram->max, 7000000);
+		EXPECT_EQ(histogram_percentile(histogram.get(), 100), 7000000);
+	}
+
+	TEST(Histogram, HugeValuesKeepTheirMax) {
+		std::unique_ptr<latency_histogram> histogram(new latency_histogram());
+		histogram_record(histogram.get(), 1);
+		histogram_record(histogram.get(), UINT64_MAX);
+		EXPECT_EQ(histogram->counts[LATENCY_BUCKETS - 1], 1);
+		EXPECT_EQ(histogram_percentile(histogram.get(), 50), 1);
+		EXPECT_EQ(histogram_percentile(histogram.get(), 100), UINT64_MAX);
+	}
+
+	// the largest values below the overflow keep the bound of their own bucket
+	TEST(Histogram, OverflowHasItsOwnBucket) {
+		std::unique_ptr<latency_histogram> histogram(new latency_histogram());
+		uint64_t largest = (uint64_t(1) << LATENCY_MAX_BITS) - 1;
+		for(int i = 0; i < 99; ++i) histogram_record(histogram.get(), largest);
+		histogram_record(histogram.get(), uint64_t(1) << LATENCY_MAX_BITS);
+		EXPECT_EQ(histogram->counts[LATENCY_BUCKETS - 2], 99);
+		EXPECT_EQ(histogram->counts[LATENCY_BUCKETS - 1], 1);
+		EXPECT_EQ(histogram_percentile(histogram.get(), 99), largest);
+		EXPECT_EQ(histogram_percentile(histogram.get(), 100), uint64_t(1) << LATENCY_MAX_BITS);
+	}
+
+	TEST(Latency, RecordAndPrint) {
+		latency_reset();
+		uint64_t start = latency_now();
+		uint64_t end = latency_record(LAT_PARSE, start);
+		EXPECT_GE(end, start);
+		EXPECT_EQ(latency_of(LAT_PARSE)->total, 1);
+		EXPECT_EQ(latency_of(LAT_SCHD)->total, 0);
+
+		FILE *out = tmpfile();
+		ASSERT_NE(out, nullptr);
+		latency_print(out);
+		std::string report = contents(out);
+		fclose(out);
+
+		// only phases with samples are listed
+		EXPECT_NE(report.find("parse"), std::string::npos);
+		EXPECT_EQ(report.find("SCHD"), std::string::npos);
+		latency_reset();
+		EXPECT_EQ(latency_of(LAT_PARSE)->total, 0);
+	}
+
+	TEST(Latency, ReportOnSignal) {
+		latency_reset();
+		latency_record(LAT_DECISION, latency_now());
+		latency_report_on(SIGUSR1);
+
+		FILE *out = tmpfile();
+		ASSERT_NE(out, nullptr);
+		latency_poll(out);
+		EXPECT_EQ(contents(out), "");
+
+		raise(SIGUSR1);
+		latency_poll(out);
+		EXPECT_NE(contents(out).find("decision"), std::string::npos);
+
+		// one report per signal
+		long written = ftell(out);
+		latency_poll(out);
+		EXPECT_EQ(ftell(out), written);
+		fclose(out);
+
+		signal(SIGUSR1, SIG_DFL);
+		latency_reset();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,181 @@
+#define EXTERN_C
+extern "C" {
+#include "../src/preboot.h"
+}
+#undef EXTERN_C
+#include "test_util.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <string>
+
+namespace {
+	char smallName[] = "small", mediumName[] = "medium";
+	const server_type types[]{
+		{ smallName, 4, 60, 0.2f, resource_info{ 2, 2000, 8000 } },
+		{ mediumName, 4, 60, 0.4f, resource_info{ 4, 16000, 64000 } }
+	};
+
+	// a medium server up with nothing on it
+	server_info &idle(system_config *config, size_t id) {
+		server_info &server = start_of_type(config, &config->types[1])[id];
+		server.state = SS_IDLE;
+		sync_server(&server);
+		return server;
+	}
+
+	// job `n` of a stream of single core jobs needing more memory than small servers have, `gap` seconds apart
+	job_info arrival(uintmax_t n, uintmax_t gap) {
+		return job_info{ n * gap, n, 100, resource_info{ 1, 3000, 1000 } };
+	}
+
+	TEST(Preboot, SlowArrivalsKeepChoice) {
+		system_config *config = create_config(types, 2);
+		boot_forecast *forecast = boot_forecast_create(config, 1, nullptr);
+		ASSERT_NE(forecast, nullptr);
+		server_info &server = idle(config, 0);
+
+		for(uintmax_t n = 0; n < 5; ++n) {
+			job_info job = arrival(n, 1000);
+			EXPECT_EQ(preboot(forecast, config, job, &server), &server);
+			server.advance(static_cast<intmax_t>(job.submit_time));
+		}
+
+		boot_forecast_free(forecast);
+		free_config(config);
+	}
+
+	// a core every 10 seconds is 6 over a boot, and once enough servers are booting to cover that it stops
+	TEST(Preboot, BurstStartsServers) {
+		system_config *config = create_config(types, 2);
+		FILE *log = tmpfile();
+		ASSERT_NE(log, nullptr);
+		boot_forecast *forecast = boot_forecast_create(config, 1, log);
+		ASSERT_NE(forecast, nullptr);
+		server_info *servers = start_of_type(config, &config->types[1]);
+		idle(config, 0);
+
+		job_info first = arrival(0, 10);
+		EXPECT_EQ(preboot(forecast, config, first, &servers[0]), &servers[0]) << "one job is no rate to go on";
+		assign_job(&servers[0], first);
+
+		size_t started = 0;
+		for(uintmax_t n = 1; n < 8; ++n) {
+			job_info job = arrival(n, 10);
+			server_info *choice = preboot(forecast, config, job, &servers[0]);
+			if(choice != &servers[0]) {
+				EXPECT_EQ(choice->state, SS_INACTIVE);
+				++started;
+			}
+			assign_job(choice, job);
+		}
+
+		EXPECT_DOUBLE_EQ(boot_forecast_demand(forecast, config, &config->types[1], 70), 6);
+		EXPECT_EQ(started, 2);
+		EXPECT_EQ(servers[2].state, SS_BOOTING);
+		EXPECT_EQ(servers[3].state, SS_INACTIVE);
+		EXPECT_NE(contents(log).find("job 1 at 10 starts medium 1"), std::string::npos);
+
+		fclose(log);
+		boot_forecast_free(forecast);
+		free_config(config);
+	}
+
+	// looking a quarter of a boot ahead, the same burst doesn't need another server yet
+	TEST(Preboot, HorizonTradesCost) {
+		system_config *config = create_config(types, 2);
+		boot_forecast *forecast = boot_forecast_create(config, 0.25, nullptr);
+		ASSERT_NE(forecast, nullptr);
+		server_info &server = idle(config, 0);
+
+		job_info first = arrival(0, 10);
+		preboot(forecast, config, first, &server);
+		assign_job(&server, first);
+		EXPECT_EQ(preboot(forecast, config, arrival(1, 10), &server), &server);
+		EXPECT_DOUBLE_EQ(boot_forecast_demand(forecast, config, &config->types[1], 10), 1);
+
+		boot_forecast_free(forecast);
+		free_config(config);
+	}
+
+	// a stream that's gone quiet is forecast from how long it's been quiet
+	TEST(Preboot, QuietStreamSlows) {
+		system_config *config = create_config(types, 2);
+		boot_forecast *forecast = boot_forecast_create(config, 1, nullptr);
+		ASSERT_NE(forecast, nullptr);
+
+		boot_forecast_observe(forecast, config, arrival(0, 10));
+		boot_forecast_observe(forecast, config, arrival(1, 10));
+		EXPECT_DOUBLE_EQ(boot_forecast_demand(forecast, config, &config->types[1], 10), 6);
+		EXPECT_DOUBLE_EQ(boot_forecast_demand(forecast, config, &config->types[1], 610), 0);
+		EXPECT_EQ(boot_forecast_demand(forecast, config, &config->types[0], 10), 0) << "the jobs don't fit small servers";
+
+		boot_forecast_free(forecast);
+		free_config(config);
+	}
+
+	// a job asked about again after a refresh doesn't count twice
+	TEST(Preboot, SameJobOnce) {
+		system_config *config = create_config(types, 2);
+		FILE *out = tmpfile();
+		ASSERT_NE(out, nullptr);
+		boot_forecast *forecast = boot_forecast_create(config, 1, nullptr);
+		ASSERT_NE(forecast, nullptr);
+
+		boot_forecast_observe(forecast, config, arrival(0, 10));
+		boot_forecast_observe(forecast, config, arrival(0, 10));
+		EXPECT_EQ(boot_forecast_demand(forecast, config, &config->types[1], 0), 0);
+
+		boot_forecast_print(forecast, out);
+		EXPECT_EQ(contents(out), "# preboot: 0 servers started ahead of demand over 1 jobs\n");
+
+		fclose(out);
+		boot_forecast_free(forecast);
+		free_config(config);
+	}
+
+	// a refresh can ask about the job that started a server again, and it's given the same server without being counted twice
+	TEST(Preboot, RepeatKeepsServer) {
+		system_config *config = create_config(types, 2);
+		FILE *log = tmpfile(), *out = tmpfile();
+		ASSERT_NE(log, nullptr);
+		ASSERT_NE(out, nullptr);
+		boot_forecast *forecast = boot_forecast_create(config, 1, log);
+		ASSERT_NE(forecast, nullptr);
+		server_info *servers = start_of_type(config, &config->types[1]);
+		idle(config, 0);
+
+		job_info first = arrival(0, 10);
+		preboot(forecast, config, first, &servers[0]);
+		assign_job(&servers[0], first);
+
+		job_info job = arrival(1, 10);
+		server_info *started = preboot(forecast, config, job, &servers[0]);
+		ASSERT_NE(started, &servers[0]);
+		EXPECT_EQ(preboot(forecast, config, job, &servers[0]), started);
+
+		boot_forecast_print(forecast, out);
+		EXPECT_EQ(contents(out), "# preboot: 1 servers started ahead of demand over 2 jobs\n");
+		std::string text = contents(log);
+		EXPECT_EQ(text.find("preboot:"), text.rfind("preboot:"));
+
+		fclose(out);
+		fclose(log);
+		boot_forecast_free(forecast);
+		free_config(config);
+	}
+
+	// a job that's going to wait for its server anyway is left where it was going
+	TEST(Preboot, WaitingJobsLeftAlone) {
+		system_config *config = create_config(types, 2);
+		boot_forecast *forecast = boot_forecast_create(config, 1, nullptr);
+		ASSERT_NE(forecast, nullptr);
+		server_info *servers = start_of_type(config, &config->types[1]);
+
+		preboot(forecast, config, arrival(0, 10), &servers[0]);
+		EXPECT_EQ(preboot(forecast, config, arrival(1, 10), &servers[0]), &servers[0]);
+		EXPECT_EQ(preboot(forecast, config, arrival(2, 10), nullptr), nullptr);
+
+		boot_forecast_free(forecast);
+		free_config(config);
+	}
+}
\ No newline at end of file
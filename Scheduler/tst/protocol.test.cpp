@@ -0,0 +1,152 @@
+#include "../src/protocol.h"
+#include <gtest/gtest.h>
+#include <string>
+
+namespace {
+
+	void expectJob(const char *msg, const job_info &expected) {
+		job_info job;
+		parse_error error;
+		ASSERT_TRUE(parse_job(msg, &job, &error)) << error.reason << " at column " << error.column;
+		EXPECT_EQ(job.submit_time, expected.submit_time);
+		EXPECT_EQ(job.id, expected.id);
+		EXPECT_EQ(job.est_runtime, expected.est_runtime);
+		EXPECT_EQ(job.req_resc, expected.req_resc);
+	}
+
+	void expectJobError(const char *msg, size_t column) {
+		job_info job;
+		parse_error error;
+		ASSERT_FALSE(parse_job(msg, &job, &error));
+		EXPECT_EQ(error.column, column) << error.reason;
+	}
+
+	TEST(MessageTypeOf, Responses) {
+		EXPECT_EQ(message_type_of("OK"), MSG_OK);
+		EXPECT_EQ(message_type_of("ERR"), MSG_ERR);
+		EXPECT_EQ(message_type_of("ERR: invalid command (OK)"), MSG_ERR);
+		EXPECT_EQ(message_type_of("NONE"), MSG_NONE);
+		EXPECT_EQ(message_type_of("."), MSG_END);
+		EXPECT_EQ(message_type_of("DATA"), MSG_DATA);
+		EXPECT_EQ(message_type_of("JOBN 83 0 1566 1 200 300"), MSG_JOBN);
+	}
+
+	TEST(MessageTypeOf, Others) {
+		EXPECT_EQ(message_type_of("small 0 0 143 2 4000 16000"), MSG_OTHER);
+		EXPECT_EQ(message_type_of("2 2 396 154 2 2100 2800"), MSG_OTHER);
+		EXPECT_EQ(message_type_of("OKAY"), MSG_OTHER);
+		EXPECT_EQ(message_type_of(".."), MSG_OTHER);
+		EXPECT_EQ(message_type_of("JOBNX"), MSG_OTHER);
+		EXPECT_EQ(message_type_of(""), MSG_OTHER);
+	}
+
+	TEST(ParseJob, AllZeroes) {
+		expectJob("JOBN 0 0 0 0 0 0", job_info{ 0, 0, 0, resource_info{0, 0, 0} });
+	}
+
+	TEST(ParseJob, StandardExamples) {
+		expectJob("JOBN 83 0 1566 1 200 300", job_info{ 83, 0, 1566, resource_info{1, 200, 300} });
+		expectJob("JOBN 290 1 7 1 400 1200", job_info{ 290, 1, 7, resource_info{1, 400, 1200} });
+		expectJob("JOBN 728 4 1431 8 8000 15400", job_info{ 728, 4, 1431, resource_info{8, 8000, 15400} });
+		expectJob("JOBN 1064 9 47267 8 6300 4100", job_info{ 1064, 9, 47267, resource_info{8, 6300, 4100} });
+	}
+
+	TEST(ParseJob, LargestValue) {
+		expectJob("JOBN 18446744073709551615 0 0 0 0 0", job_info{ UINTMAX_MAX, 0, 0, resource_info{0, 0, 0} });
+	}
+
+	TEST(ParseJob, InvalidJobPrefix) {
+		expectJobError("this should break", 0);
+	}
+
+	TEST(ParseJob, ServerErrorResponse) {
+		expectJobError("ERR", 0);
+	}
+
+	TEST(ParseJob, MissingField) {
+		expectJobError("JOBN 83 0 1566 1 200", 20);
+	}
+
+	TEST(ParseJob, ExtraField) {
+		expectJobError("JOBN 83 0 1566 1 200 300 7", 25);
+	}
+
+	TEST(ParseJob, NotANumber) {
+		expectJobError("JOBN 83 0 15x6 1 200 300", 12);
+	}
+
+	TEST(ParseJob, Negative) {
+		expectJobError("JOBN 83 -1 1566 1 200 300", 8);
+	}
+
+	TEST(ParseJob, Overflow) {
+		expectJobError("JOBN 18446744073709551616 0 0 0 0 0", 24);
+	}
+
+	TEST(ParseRescRow, Inactive) {
+		resc_row row;
+		parse_error error;
+		const char *msg = "medium 1 0 396 4 16000 64000";
+		ASSERT_TRUE(parse_resc_row(msg, &row, &error)) << error.reason;
+		EXPECT_EQ(std::string(row.type_name.str, row.type_name.len), "medium");
+		EXPECT_EQ(row.type_name.str, msg);
+		EXPECT_EQ(row.id, 1);
+		EXPECT_EQ(row.state, 0);
+		EXPECT_EQ(row.avail_time, 396);
+		EXPECT_EQ(row.avail_resc, (resource_info{4, 16000, 64000}));
+	}
+
+	TEST(ParseRescRow, Active) {
+		resc_row row;
+		parse_error error;
+		ASSERT_TRUE(parse_resc_row("small 0 3 -1 0 3500 15400", &row, &error)) << error.reason;
+		EXPECT_EQ(row.state, 3);
+		EXPECT_EQ(row.avail_time, -1);
+		EXPECT_EQ(row.avail_resc, (resource_info{0, 3500, 15400}));
+	}
+
+	TEST(ParseRescRow, Malformed) {
+		resc_row row;
+		parse_error error;
+		EXPECT_FALSE(parse_resc_row("", &row, &error));
+		EXPECT_EQ(error.column, 0);
+		EXPECT_FALSE(parse_resc_row("small 0 3 - 0 3500 15400", &row, &error));
+		EXPECT_EQ(error.column, 11);
+		EXPECT_FALSE(parse_resc_row("small 0 3 -1 0 3500", &row, &error));
+		EXPECT_EQ(error.column, 19);
+	}
+
+	TEST(ParseLstjRow, Running) {
+		lstj_row row;
+		parse_error error;
+		ASSERT_TRUE(parse_lstj_row("2 2 396 154 2 2100 2800", &row, &error)) << error.reason;
+		EXPECT_EQ(row.schd.job_id, 2);
+		EXPECT_EQ(row.job_state, 2);
+		EXPECT_EQ(row.schd.start_time, 396);
+		EXPECT_EQ(row.schd.est_runtime, 154);
+		EXPECT_EQ(row.schd.req_resc, (resource_info{2, 2100, 2800}));
+	}
+
+	TEST(ParseLstjRow, Waiting) {
+		lstj_row row;
+		parse_error error;
+		ASSERT_TRUE(parse_lstj_row("5 1 -1 80 1 500 600", &row, &error)) << error.reason;
+		EXPECT_EQ(row.job_state, 1);
+		EXPECT_EQ(row.schd.start_time, -1);
+	}
+
+	TEST(ParseLstjRow, TrailingSpaces) {
+		lstj_row row;
+		parse_error error;
+		EXPECT_TRUE(parse_lstj_row("5 1 -1 80 1 500 600 ", &row, &error)) << error.reason;
+	}
+
+	TEST(ParseLstjRow, Malformed) {
+		lstj_row row;
+		parse_error error;
+		EXPECT_FALSE(parse_lstj_row(".", &row, &error));
+		EXPECT_EQ(error.column, 0);
+		EXPECT_FALSE(parse_lstj_row("5  1 -1 80 1 500", &row, &error));
+		EXPECT_EQ(error.column, 16);
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+#ifndef random_fleet_h_
+#define random_fleet_h_
+
+#include "../src/system_config.h"
+#include "../src/job_info.h"
+#include <cstdint>
+#include <cstdlib>
+
+// random servers and jobs for the tests that check a fast path against a slow one, and the benchmarks
+namespace {
+
+	// a fixed sequence from its seed, so a failure happens the same way every run
+	struct Lcg {
+		uint64_t state;
+		uintmax_t next(uintmax_t bound) {
+			state = state * 6364136223846793005ull + 1442695040888963407ull;
+			return (state >> 33) % bound;
+		}
+	};
+
+	// how many servers randomFleet makes, and what it leaves free on them
+	struct fleet_spread {
+		uintmax_t limits[3]; // servers of the small, medium and large types
+		bool mostly_full; // a quarter left empty and the rest at most half free, rather than anything from none to all of it free
+	};
+
+	// a fleet of three types with every server in a random state, with few enough distinct values that ties are common
+	system_config *randomFleet(Lcg &lcg, const fleet_spread &spread) {
+		char names[3][8] = { "small", "medium", "large" };
+		server_type types[3] = {
+			server_type{ names[0], spread.limits[0], 30, 0.1f, resource_info{ 2, 2000, 8000 } },
+			server_type{ names[1], spread.limits[1], 60, 0.2f, resource_info{ 4, 8000, 16000 } },
+			server_type{ names[2], spread.limits[2], 60, 0.4f, resource_info{ 8, 16000, 64000 } }
+		};
+		system_config *config = create_config(types, 3);
+		for(size_t s = 0; s < config->num_servers; ++s) {
+			server_info &server = config->servers[s];
+			const resource_info &max = server.type->max_resc;
+			server.state = static_cast<server_state>(lcg.next(5));
+			server.avail_time = static_cast<intmax_t>(lcg.next(4)) * 50 - 1;
+			if(!spread.mostly_full) server.avail_resc = resource_info{ lcg.next(max.cores + 1), 1000 * lcg.next(max.memory / 1000 + 1), 4000 * lcg.next(max.disk / 4000 + 1) };
+			else server.avail_resc = lcg.next(4) == 0 ? max : resource_info{ lcg.next(max.cores / 2 + 1), 1000 * lcg.next(max.memory / 2000 + 1), 4000 * lcg.next(max.disk / 8000 + 1) };
+			sync_server(&server);
+		}
+		return config;
+	}
+
+	// the ranges randomJob draws from
+	struct job_spread {
+		uintmax_t submits; // submitted up to this many 50 second steps after `now`, 0 to submit every job at `now`
+		uintmax_t runtime; // estimated to take from 1 up to this many seconds
+		uintmax_t cores; // from 1 up to this many
+		uintmax_t memory; // from 0 up to this many steps of 1000
+		uintmax_t disk; // from 0 up to this many steps of 4000
+	};
+
+	job_info randomJob(Lcg &lcg, uintmax_t id, const job_spread &spread, intmax_t now = 0) {
+		uintmax_t submit = static_cast<uintmax_t>(now) + (spread.submits > 0 ? 50 * lcg.next(spread.submits) : 0);
+		return job_info{ submit, id, 1 + lcg.next(spread.runtime), resource_info{ 1 + lcg.next(spread.cores), 1000 * lcg.next(spread.memory), 4000 * lcg.next(spread.disk) } };
+	}
+
+	/*
+	a server of `type` with `depth` jobs queued on it, as LSTJ or the local model leaves one: jobs started in order while they fit,
+	the rest waiting. few distinct sizes and runtimes, so jobs often finish together. a `varied` server is booting a quarter of the time,
+	and leaves a quarter of the jobs that would fit waiting, as it would be had some of them been queued behind a bigger job.
+	the caller frees its jobs and releases its skyline
+	*/
+	server_info busyServer(Lcg &lcg, const server_type &type, size_t depth, intmax_t now, bool varied) {
+		server_info server{ &type, 0, varied && lcg.next(4) == 0 ? SS_BOOTING : SS_ACTIVE, now + 30, type.max_resc, nullptr, 0, 0, nullptr, nullptr };
+		server.jobs = static_cast<schd_info*>(malloc(sizeof(schd_info) * depth));
+		server.num_jobs = depth;
+
+		resource_info used{ 0, 0, 0 };
+		for(size_t j = 0; j < depth; ++j) {
+			resource_info req{ 1 + lcg.next(8), 1000 * (1 + lcg.next(8)), 4000 * (1 + lcg.next(8)) };
+			bool starts = server.state == SS_ACTIVE && used + req <= type.max_resc && (!varied || lcg.next(4) != 0);
+			server.jobs[j] = schd_info{ j, starts ? now - static_cast<intmax_t>(lcg.next(4) * 100) : -1, 100 * (1 + lcg.next(6)), req };
+			if(starts) used = used + req;
+			else ++server.num_waiting;
+		}
+		server.avail_resc = type.max_resc - used;
+		if(server.state == SS_ACTIVE) server.avail_time = -1;
+		return server;
+	}
+}
+
+#endif
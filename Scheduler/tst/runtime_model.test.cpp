@@ -0,0 +1,222 @@
+#define EXTERN_C
+extern "C" {
+#include "../src/runtime_model.h"
+#include "../src/stage_three.h"
+}
+#undef EXTERN_C
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <string>
+
+namespace {
+	char typeName[] = "medium";
+	const server_type type{ typeName, 2, 60, 0.4f, resource_info{ 4, 16000, 64000 } };
+	const resource_info small{ 1, 1000, 1000 };
+	const resource_info large{ 4, 8000, 8000 };
+
+	void learn(runtime_model *model, const resource_info &req, uintmax_t est_runtime, uintmax_t runtime, size_t times) {
+		for(size_t i = 0; i < times; ++i) runtime_model_observe(model, req, est_runtime, runtime);
+	}
+
+	TEST(RuntimeModel, TrustsEstimateUntilEnoughJobs) {
+		runtime_model *model = runtime_model_create();
+		ASSERT_NE(model, nullptr);
+
+		learn(model, small, 1000, 2000, 2);
+		EXPECT_EQ(runtime_model_correct(model, small, 1000), 1000);
+
+		learn(model, small, 1000, 2000, 1);
+		EXPECT_EQ(runtime_model_correct(model, small, 1000), 2000);
+		EXPECT_EQ(runtime_model_correct(model, small, 0), 0);
+		EXPECT_EQ(runtime_model_observed(model), 3);
+
+		runtime_model_free(model);
+	}
+
+	// a shape nothing's been learned about takes the correction of its estimated runtime, then of every job
+	TEST(RuntimeModel, FallsBackToWiderGroups) {
+		runtime_model *model = runtime_model_create();
+		ASSERT_NE(model, nullptr);
+
+		learn(model, small, 1000, 2000, 3);
+		learn(model, small, 100, 100, 3);
+
+		EXPECT_EQ(runtime_model_correct(model, large, 1000), 2000);
+		EXPECT_EQ(runtime_model_correct(model, large, 100), 100);
+		EXPECT_EQ(runtime_model_correct(model, large, 100000), 141421); // the geometric mean of 2 and 1
+
+		runtime_model_free(model);
+	}
+
+	// the mean moves towards new jobs, faster once a group has a full window of them
+	TEST(RuntimeModel, FollowsRecentJobs) {
+		runtime_model *model = runtime_model_create();
+		ASSERT_NE(model, nullptr);
+
+		learn(model, small, 1000, 4000, 100);
+		learn(model, small, 1000, 1000, 100);
+		EXPECT_LT(runtime_model_correct(model, small, 1000), 1100);
+
+		runtime_model_free(model);
+	}
+
+	TEST(RuntimeModel, SaveAndLoad) {
+		std::string path = ::testing::TempDir() + "runtime_model.test.txt";
+		runtime_model *model = runtime_model_create();
+		ASSERT_NE(model, nullptr);
+		learn(model, small, 1000, 3000, 3);
+		learn(model, large, 100, 50, 5);
+		ASSERT_TRUE(runtime_model_save(model, path.c_str()));
+
+		runtime_model *loaded = runtime_model_load(path.c_str());
+		ASSERT_NE(loaded, nullptr);
+		EXPECT_EQ(runtime_model_correct(loaded, small, 1000), 3000);
+		EXPECT_EQ(runtime_model_correct(loaded, large, 100), 50);
+		EXPECT_EQ(runtime_model_correct(loaded, large, 1000), runtime_model_correct(model, large, 1000));
+
+		runtime_model_free(loaded);
+		runtime_model_free(model);
+		remove(path.c_str());
+	}
+
+	TEST(RuntimeModel, LoadMissingFile) {
+		std::string path = ::testing::TempDir() + "runtime_model.missing.txt";
+		remove(path.c_str());
+
+		runtime_model *model = runtime_model_load(path.c_str());
+		ASSERT_NE(model, nullptr);
+		EXPECT_EQ(runtime_model_correct(model, small, 1000), 1000);
+		runtime_model_free(model);
+	}
+
+	TEST(RuntimeModel, LoadMalformedFile) {
+		std::string path = ::testing::TempDir() + "runtime_model.malformed.txt";
+		FILE *file = fopen(path.c_str(), "w");
+		ASSERT_NE(file, nullptr);
+		fputs("# runtime corrections: key samples mean_log_ratio\n0a8421 3 not-a-number\n", file);
+		fclose(file);
+
+		EXPECT_EQ(runtime_model_load(path.c_str()), nullptr);
+		remove(path.c_str());
+	}
+
+	// a job listed as running at one refresh and gone at the next, not long after, finished halfway between them
+	TEST(RuntimeModel, LearnsFromRefreshes) {
+		system_config *config = create_config(&type, 1);
+		runtime_model *model = runtime_model_create();
+		ASSERT_NE(model, nullptr);
+		server_info &server = config->servers[0];
+
+		for(uintmax_t j = 0; j < 3; ++j) {
+			intmax_t start = static_cast<intmax_t>(j) * 1000;
+			server.state = SS_IDLE;
+			sync_server(&server);
+			server.assign(job_info{ static_cast<uintmax_t>(start), j, 100, small });
+
+			runtime_model_refresh(model, config, start + 195);
+			EXPECT_EQ(runtime_model_observed(model), j);
+
+			server.advance(start + 205);
+			runtime_model_refresh(model, config, start + 205);
+			EXPECT_EQ(runtime_model_observed(model), j + 1);
+		}
+
+		EXPECT_EQ(runtime_model_correct(model, small, 100), 200);
+
+		runtime_model_free(model);
+		free_config(config);
+	}
+
+	// a job that was gone by a refresh long after it was last seen could have finished any time in between, so it isn't learned from
+	TEST(RuntimeModel, IgnoresLongGaps) {
+		system_config *config = create_config(&type, 1);
+		runtime_model *model = runtime_model_create();
+		ASSERT_NE(model, nullptr);
+		server_info &server = config->servers[0];
+
+		server.state = SS_IDLE;
+		sync_server(&server);
+		server.assign(job_info{ 0, 0, 100, small });
+		runtime_model_refresh(model, config, 50);
+
+		server.advance(250);
+		runtime_model_refresh(model, config, 250);
+		EXPECT_EQ(runtime_model_observed(model), 0);
+		EXPECT_EQ(runtime_model_correct(model, small, 100), 100);
+
+		runtime_model_free(model);
+		free_config(config);
+	}
+
+	// jobs lost when their server fails aren't taken to have finished
+	TEST(RuntimeModel, IgnoresFailedServers) {
+		system_config *config = create_config(&type, 1);
+		runtime_model *model = runtime_model_create();
+		ASSERT_NE(model, nullptr);
+		server_info &server = config->servers[0];
+
+		server.state = SS_IDLE;
+		sync_server(&server);
+		server.assign(job_info{ 0, 0, 100, small });
+		runtime_model_refresh(model, config, 50);
+
+		ASSERT_TRUE(server.update(SS_UNAVAILABLE, -1, type.max_resc));
+		runtime_model_refresh(model, config, 250);
+		EXPECT_EQ(runtime_model_observed(model), 0);
+
+		runtime_model_free(model);
+		free_config(config);
+	}
+
+	// with a model on the config, a server's jobs are simulated on their corrected runtimes
+	TEST(RuntimeModel, CorrectsSimulation) {
+		system_config *config = create_config(&type, 1);
+		runtime_model *model = runtime_model_create();
+		ASSERT_NE(model, nullptr);
+		learn(model, large, 100, 200, 3);
+
+		server_info &server = config->servers[0];
+		server.state = SS_IDLE;
+		sync_server(&server);
+		server.assign(job_info{ 0, 0, 100, large });
+		server.assign(job_info{ 0, 1, 100, large });
+		job_info job{ 10, 2, 100, large };
+
+		EXPECT_EQ(predict_availability(&server, &job, 10).avail, 200);
+
+		config->context.runtimes = model;
+		sync_server(&server);
+		EXPECT_EQ(predict_availability(&server, &job, 10).avail, 400);
+		EXPECT_EQ(predict_availability_scan(&server, &job, 10).avail, 400);
+		config->context.runtimes = nullptr;
+
+		runtime_model_free(model);
+		free_config(config);
+	}
+
+	// learning invalidates every simulation run on the old corrections, even a server's with nothing waiting that nothing's happened to
+	TEST(RuntimeModel, LearningInvalidatesSimulation) {
+		system_config *config = create_config(&type, 1);
+		runtime_model *model = runtime_model_create();
+		ASSERT_NE(model, nullptr);
+		config->context.runtimes = model;
+
+		server_info &server = config->servers[0];
+		server.state = SS_IDLE;
+		sync_server(&server);
+		server.assign(job_info{ 0, 0, 100, large });
+		job_info job{ 10, 1, 100, large };
+		size_t generation = runtime_model_generation(model);
+
+		EXPECT_EQ(predict_availability(&server, &job, 10).avail, 100);
+
+		learn(model, large, 100, 300, 3);
+		EXPECT_NE(runtime_model_generation(model), generation);
+		EXPECT_EQ(predict_availability(&server, &job, 10).avail, 300);
+		EXPECT_EQ(predict_availability_scan(&server, &job, 10).avail, 300);
+
+		config->context.runtimes = nullptr;
+		runtime_model_free(model);
+		free_config(config);
+	}
+}
\ No newline at end of file
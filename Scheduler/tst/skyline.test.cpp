@@ -0,0 +1,103 @@
+#define EXTERN_C
+extern "C" {
+#include "../src/stage_three.h"
+}
+#undef EXTERN_C
+#include "random_fleet.h"
+#include "test_util.h"
+#include <gtest/gtest.h>
+#include <string>
+
+namespace {
+	char typeName[] = "large";
+	const server_type type{ typeName, 1, 60, 0.4f, resource_info{ 16, 16000, 64000 } };
+	constexpr job_spread jobSpread{ 0, 600, 16, 17, 17 };
+
+	// asking from later and later times, between and on completions, before and after the first waiting job starts
+	TEST(Skyline, LaterTimesSameAsScan) {
+		Lcg lcg{ 1 };
+		for(int s = 0; s < 50; ++s) {
+			intmax_t now = 1000;
+			server_info server = busyServer(lcg, type, 1 + lcg.next(40), now, false);
+			for(intmax_t from = now; from < now + 1500; from += 25) {
+				for(uintmax_t j = 0; j < 5; ++j) expectSameAsScan(server, randomJob(lcg, j, jobSpread, from), from);
+			}
+			free(server.jobs);
+			skyline_release(&server);
+		}
+	}
+
+	// a server that's never been asked about has no skyline to go on, even at the time a skyline built there would begin from
+	TEST(Skyline, FreshServerAtTimeZero) {
+		schd_info jobs[]{
+			schd_info{ 0, 0, 100, resource_info{ 8, 8000, 32000 } },
+			schd_info{ 1, 0, 300, resource_info{ 8, 8000, 32000 } },
+			schd_info{ 2, -1, 200, type.max_resc }
+		};
+		server_info server{ &type, 0, SS_ACTIVE, -1, resource_info{ 0, 0, 0 }, jobs, 3, 1, nullptr, nullptr };
+		job_info job{ 0, 3, 100, type.max_resc };
+
+		EXPECT_EQ(predict_availability(&server, &job, 0).avail, 500);
+		expectSameAsScan(server, job, 0);
+		skyline_release(&server);
+	}
+
+	// a skyline is kept until the server's jobs change, so a change it isn't told about goes unseen
+	TEST(Skyline, KeptUntilJobsChange) {
+		Lcg lcg{ 2 };
+		server_info server = busyServer(lcg, type, 8, 1000, false);
+		job_info job{ 1000, 0, 100, type.max_resc };
+		availability_prediction before = predict_availability(&server, &job, 1000);
+
+		for(size_t j = 0; j < server.num_jobs; ++j) server.jobs[j].est_runtime += 1000;
+		EXPECT_EQ(predict_availability(&server, &job, 1000).avail, before.avail);
+
+		skyline_invalidate(&server);
+		EXPECT_GT(predict_availability(&server, &job, 1000).avail, before.avail);
+		expectSameAsScan(server, job, 1000);
+		free(server.jobs);
+		skyline_release(&server);
+	}
+
+	// every way the client changes a server's jobs has to reach its skyline
+	TEST(Skyline, FollowsEveryChange) {
+		char names[2][8] = { "small", "large" };
+		server_type types[2] = {
+			server_type{ names[0], 4, 30, 0.1f, resource_info{ 4, 4000, 16000 } },
+			server_type{ names[1], 4, 60, 0.4f, resource_info{ 16, 16000, 64000 } }
+		};
+		system_config *config = create_config(types, 2);
+		Lcg lcg{ 3 };
+		intmax_t now = 0;
+
+		for(uintmax_t j = 0; j < 2000; ++j) {
+			now += static_cast<intmax_t>(lcg.next(40));
+			server_info &server = config->servers[lcg.next(config->num_servers)];
+			const resource_info &max = server.type->max_resc;
+			job_info job{ static_cast<uintmax_t>(now), j, 1 + lcg.next(600), resource_info{ 1 + lcg.next(max.cores), 1000 * lcg.next(max.memory / 1000), 4000 * lcg.next(max.disk / 4000) } };
+
+			switch(lcg.next(4)) {
+				case 0:
+				case 1:
+					server.assign(job);
+					break;
+				case 2:
+					config->advance(now);
+					break;
+				default:
+					// as LSTJ would, a job finishing early
+					if(server.num_jobs > 0 && ~server.jobs[0].start_time) {
+						server.jobs[0].est_runtime = static_cast<uintmax_t>(std::max<intmax_t>(0, now - server.jobs[0].start_time));
+						sync_server(&server);
+					}
+			}
+
+			for(size_t s = 0; s < config->num_servers; ++s) {
+				server_info &other = config->servers[s];
+				if(other.num_jobs == 0 || !job_can_run(&job, other.type->max_resc)) continue;
+				expectSameAsScan(other, job, other.state == SS_ACTIVE ? now : other.avail_time);
+			}
+		}
+		free_config(config);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+#define EXTERN_C
+extern "C" {
+#include "../src/socket_client.h"
+}
+#undef EXTERN_C
+#include "test_util.h"
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <cstring>
+#include <string>
+
+namespace {
+
+	TEST(ClientReceive, SingleMessage) {
+		ClientPair pair(false);
+		pair.serverWrite("OK");
+		EXPECT_STREQ(client_receive(pair.client), "OK");
+	}
+
+	TEST(ClientReceive, ConsecutiveMessages) {
+		ClientPair pair(false);
+		pair.serverWrite("DATA");
+		EXPECT_STREQ(client_receive(pair.client), "DATA");
+		pair.serverWrite(".");
+		EXPECT_STREQ(client_receive(pair.client), ".");
+	}
+
+	TEST(ClientReceive, NewlineSingleMessage) {
+		ClientPair pair(true);
+		pair.serverWrite("JOBN 83 0 1566 1 200 300\n");
+		EXPECT_STREQ(client_receive(pair.client), "JOBN 83 0 1566 1 200 300");
+	}
+
+	TEST(ClientReceive, NewlineCoalescedMessages) {
+		ClientPair pair(true);
+		pair.serverWrite("DATA\nsmall 0 0 143 2 4000 16000\n.\n");
+		EXPECT_STREQ(client_receive(pair.client), "DATA");
+		EXPECT_STREQ(client_receive(pair.client), "small 0 0 143 2 4000 16000");
+		EXPECT_STREQ(client_receive(pair.client), ".");
+	}
+
+	TEST(ClientReceive, NewlineSplitMessage) {
+		ClientPair pair(true);
+		pair.serverWrite("JOBN 83 0 ");
+		pair.serverWrite("1566 1 200");
+		pair.serverWrite(" 300\nNO");
+		EXPECT_STREQ(client_receive(pair.client), "JOBN 83 0 1566 1 200 300");
+		pair.serverWrite("NE\n");
+		EXPECT_STREQ(client_receive(pair.client), "NONE");
+	}
+
+	TEST(ClientReceive, NewlineMessageLargerThanBuffer) {
+		ClientPair pair(true);
+		std::string large(10000, 'x');
+		pair.serverWrite((large + "\nOK\n").c_str());
+		EXPECT_EQ(std::string(client_receive(pair.client)), large);
+		EXPECT_STREQ(client_receive(pair.client), "OK");
+	}
+
+	TEST(ClientSend, NoTerminator) {
+		ClientPair pair(false);
+		client_send(pair.client, "REDY");
+		EXPECT_EQ(pair.serverRead(), "REDY");
+	}
+
+	TEST(ClientSend, NewlineTerminator) {
+		ClientPair pair(true);
+		client_send(pair.client, "REDY");
+		EXPECT_EQ(pair.serverRead(), "REDY\n");
+	}
+
+	// a trace of a short newline-framed session, made by playing the server over a socketpair
+	std::string recordSession() {
+		char path[] = "/tmp/socket_client-trace-XXXXXX";
+		close(mkstemp(path));
+		ClientPair pair(true);
+		EXPECT_TRUE(client_record(pair.client, path));
+		pair.serverWrite("OK\nOK\nJOBN 83 0 1566 1 200 300\nDATA\nsmall 0 0 143 2 4000 16000\n.\n");
+		EXPECT_TRUE(client_msg_resp(pair.client, "HELO", "OK"));
+		EXPECT_TRUE(client_msg_resp(pair.client, "AUTH comp335", "OK"));
+		client_send(pair.client, "REDY");
+		EXPECT_STREQ(client_receive(pair.client), "JOBN 83 0 1566 1 200 300");
+		EXPECT_TRUE(client_msg_resp(pair.client, "RESC All", "DATA"));
+		client_send(pair.client, "OK");
+		EXPECT_STREQ(client_receive(pair.client), "small 0 0 143 2 4000 16000");
+		client_send(pair.client, "OK");
+		EXPECT_STREQ(client_receive(pair.client), ".");
+		return path;
+	}
+
+	TEST(ClientReplay, SameSession) {
+		std::string path = recordSession();
+		socket_client *client = client_replay(path.c_str());
+		ASSERT_NE(client, nullptr);
+		EXPECT_TRUE(client->newline);
+		client_send(client, "REDY");
+		EXPECT_STREQ(client_receive(client), "JOBN 83 0 1566 1 200 300");
+		EXPECT_TRUE(client_msg_resp(client, "RESC All", "DATA"));
+		client_send(client, "OK");
+		EXPECT_STREQ(client_receive(client), "small 0 0 143 2 4000 16000");
+		client_send(client, "OK");
+		EXPECT_STREQ(client_receive(client), ".");
+		EXPECT_EQ(client_try_receive(client), nullptr);
+		client_free(client);
+		unlink(path.c_str());
+	}
+
+	TEST(ClientReplay, DivergedSession) {
+		std::string path = recordSession();
+		socket_client *client = client_replay(path.c_str());
+		ASSERT_NE(client, nullptr);
+		EXPECT_EXIT(client_send(client, "RESC All"), ::testing::ExitedWithCode(1), "replay diverged");
+		client_free(client);
+		unlink(path.c_str());
+	}
+
+	TEST(ClientReplay, NotATrace) {
+		EXPECT_EQ(client_replay("test-data/system.xml"), nullptr);
+	}
+
+	TEST(ClientMsgResp, ExactResponse) {
+		ClientPair pair(false);
+		pair.serverWrite("OK");
+		EXPECT_TRUE(client_msg_resp(pair.client, "HELO", "OK"));
+	}
+
+	TEST(ClientMsgResp, UnexpectedResponse) {
+		ClientPair pair(false);
+		pair.serverWrite("ERR");
+		EXPECT_FALSE(client_msg_resp(pair.client, "HELO", "OK"));
+	}
+
+	// the message goes out before the response is asked for, and the check is the same either way
+	TEST(ClientExpect, SentFirst) {
+		ClientPair pair(false);
+		client_send(pair.client, "SCHD 3 joon 1");
+		EXPECT_EQ(pair.serverRead(), "SCHD 3 joon 1");
+		pair.serverWrite("OK");
+		EXPECT_TRUE(client_expect(pair.client, "SCHD 3 joon 1", "OK"));
+		client_send(pair.client, "SCHD 4 joon 1");
+		pair.serverWrite("ERR: No such waiting job exists");
+		EXPECT_FALSE(client_expect(pair.client, "SCHD 4 joon 1", "OK"));
+	}
+}
\ No newline at end of file
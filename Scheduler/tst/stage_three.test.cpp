@@ -0,0 +1,109 @@
+#define EXTERN_C
+extern "C" {
+#include "../src/stage_three.h"
+}
+#undef EXTERN_C
+#include "../src/thread_pool.h"
+#include "random_fleet.h"
+#include "test_util.h"
+#include <gtest/gtest.h>
+#include <string>
+
+namespace {
+	char typeName[] = "large";
+	const server_type type{ typeName, 1, 60, 0.4f, resource_info{ 16, 16000, 64000 } };
+	constexpr job_spread jobSpread{ 0, 600, 16, 17, 17 };
+
+	TEST(PredictAvailability, SameAsScan) {
+		Lcg lcg{ 1 };
+		for(size_t depth : { 0, 1, 2, 4, 8, 32, 100 }) {
+			for(int s = 0; s < 50; ++s) {
+				intmax_t now = 1000 + static_cast<intmax_t>(lcg.next(500));
+				server_info server = busyServer(lcg, type, depth, now, true);
+				intmax_t from = server.state == SS_ACTIVE ? now : server.avail_time;
+				for(uintmax_t j = 0; j < 20; ++j) expectSameAsScan(server, randomJob(lcg, j, jobSpread, now), from);
+				free(server.jobs);
+				skyline_release(&server);
+			}
+		}
+	}
+
+	// the job only fits once the server has emptied, so every job has to finish in the simulation
+	TEST(PredictAvailability, WholeServer) {
+		Lcg lcg{ 2 };
+		server_info server = busyServer(lcg, type, 64, 500, true);
+		job_info job{ 500, 0, 100, type.max_resc };
+		expectSameAsScan(server, job, 500);
+
+		availability_prediction prediction = predict_availability(&server, &job, 500);
+		EXPECT_EQ(prediction.util, (resource_info{ 0, 0, 0 }));
+		EXPECT_EQ(prediction.delayed, 0u);
+		for(size_t j = 0; j < server.num_jobs; ++j) {
+			if(~server.jobs[j].start_time) EXPECT_GE(prediction.avail, server.jobs[j].start_time + static_cast<intmax_t>(server.jobs[j].est_runtime));
+		}
+		free(server.jobs);
+		skyline_release(&server);
+	}
+
+	// a server with nothing on it reports its own resources as in use, as predictive_fit has always seen it
+	TEST(PredictAvailability, NoJobs) {
+		server_info server{ &type, 0, SS_IDLE, 200, resource_info{ 4, 4000, 16000 }, nullptr, 0, 0, nullptr };
+		job_info job{ 100, 0, 100, resource_info{ 8, 1000, 1000 } };
+		availability_prediction prediction = predict_availability(&server, &job, 200);
+		EXPECT_EQ(prediction.avail, 200);
+		EXPECT_EQ(prediction.delayed, 0u);
+		EXPECT_EQ(prediction.util, (resource_info{ 12, 12000, 48000 }));
+		expectSameAsScan(server, job, 200);
+	}
+	/*
+	servers of every state taking a stream of jobs, so that choices are made between servers able to run it now,
+	servers that would have to start and busy ones only there once others' jobs finish, in every mix of those
+	*/
+	void expectSameOnThreads(size_t threads, size_t perType, uint64_t seed) {
+		char names[3][8] = { "small", "medium", "large" };
+		server_type types[3] = {
+			server_type{ names[0], perType, 30, 0.1f, resource_info{ 2, 2000, 8000 } },
+			server_type{ names[1], perType, 60, 0.2f, resource_info{ 4, 8000, 16000 } },
+			server_type{ names[2], perType, 60, 0.4f, resource_info{ 8, 16000, 64000 } }
+		};
+		system_config *config = create_config(types, 3);
+		thread_pool *pool = thread_pool_create(threads);
+		ASSERT_NE(pool, nullptr);
+		Lcg lcg{ seed };
+
+		for(size_t s = 0; s < config->num_servers; ++s) {
+			server_info &server = config->servers[s];
+			server.state = static_cast<server_state>(lcg.next(5));
+			if(server.state == SS_BOOTING) server.avail_time = static_cast<intmax_t>(lcg.next(60));
+			sync_server(&server);
+		}
+
+		intmax_t now = 0;
+		for(uintmax_t j = 0; j < 1000; ++j) {
+			now += static_cast<intmax_t>(lcg.next(20));
+			config->advance(now);
+			job_info job{ static_cast<uintmax_t>(now), j, 1 + lcg.next(600), resource_info{ 1 + lcg.next(8), 1000 * lcg.next(17), 4000 * lcg.next(17) } };
+
+			config->context.workers = nullptr;
+			server_info *expected = predictive_fit(config, job);
+			config->context.workers = pool;
+			server_info *actual = predictive_fit(config, job);
+			ASSERT_EQ(actual, expected) << threads << " threads, job " << j;
+
+			if(expected != nullptr) expected->assign(job);
+		}
+
+		config->context.workers = nullptr;
+		free_config(config);
+		thread_pool_free(pool);
+	}
+
+	TEST(PredictiveFit, SameOnEveryThreadCount) {
+		for(size_t threads : { 2, 3, 8 }) expectSameOnThreads(threads, 100, threads);
+	}
+
+	// chunks that don't divide the servers evenly, and some left with none to search
+	TEST(PredictiveFit, SameOnUnevenChunks) {
+		for(size_t perType : { 11, 17, 43 }) expectSameOnThreads(8, perType, perType);
+	}
+}
\ No newline at end of file
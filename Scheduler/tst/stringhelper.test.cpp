@@ -7,6 +7,14 @@ extern "C" {
 
 namespace {
 
+	TEST(CreateSchdStr, StandardExample) {
+		char name[] = "large";
+		char *schd = create_schd_str(3, name, 1);
+		EXPECT_STREQ(schd, "SCHD 3 large 1");
+		free(schd);
+	}
+
+#ifdef USE_PCRE2
 	void regexFreeHelper(regex_info *&regex) {
 		pcre2_code_free(regex->re);
 		pcre2_match_data_free(regex->match_data);
@@ -151,5 +159,5 @@ namespace {
 		EXPECT_EQ(job.req_resc, expected.req_resc);
 		regexFreeHelper(regex);
 	}
-
+#endif
 }
\ No newline at end of file
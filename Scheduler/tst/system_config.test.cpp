@@ -1,5 +1,7 @@
 #include "../src/system_config.h"
+#include "test_util.h"
 #include <gtest/gtest.h>
+#include <string>
 
 namespace {
 	constexpr const char* defaultConfigPath = "test-data/defaultconfig-system.xml";
@@ -96,12 +98,40 @@ namespace {
 		free_config(config);
 	}
 
+	TEST(CreateConfig, CopiesTypes) {
+		char name[] = "custom";
+		server_type types[2] = {
+			server_type{ name, 3, 60, 0.5, resource_info{2, 4000, 16000} },
+			server_type{ name, 0, 30, 1.0, resource_info{4, 8000, 32000} }
+		};
+		system_config *config = create_config(types, 2);
+		ASSERT_NE(config, nullptr);
+		ASSERT_EQ(config->num_types, 2);
+		EXPECT_STREQ(config->types[0].name, "custom");
+		EXPECT_NE(config->types[0].name, name);
+		ASSERT_EQ(config->num_servers, 3);
+		for(auto s = 0; s < config->num_servers; ++s) {
+			EXPECT_EQ(config->servers[s].type, &config->types[0]);
+			EXPECT_EQ(config->servers[s].id, s);
+			EXPECT_EQ(config->servers[s].state, SS_INACTIVE);
+			EXPECT_EQ(config->servers[s].avail_resc, types[0].max_resc);
+		}
+		EXPECT_EQ(config->start_of_type(&config->types[0]), config->servers);
+		EXPECT_THROW(config->start_of_type(&config->types[1]), std::invalid_argument);
+		free_config(config);
+	}
+
+	TEST(CreateConfig, RejectsResourcesWiderThan32Bits) {
+		char name[] = "huge";
+		server_type type{ name, 1, 60, 1.0, resource_info{2, 4000, uintmax_t(UINT32_MAX) + 1} };
+		EXPECT_EQ(create_config(&type, 1), nullptr);
+	}
+
 	TEST(TypeByName, ExistingTypes) {
 		system_config *config = parse_config(defaultConfigPath);
 		ASSERT_NE(config, nullptr);
-		auto *type = &config->types[0];
 		for(auto t = 0; t < config->num_types; ++t) {
-			auto *type = &config->types[0];
+			auto *type = &config->types[t];
 			EXPECT_EQ(config->type_by_name(type->name), type) << "With name=" << type->name << std::endl;
 		}
 		free_config(config);
@@ -113,4 +143,275 @@ namespace {
 		EXPECT_THROW(config->type_by_name("this should break"), std::invalid_argument);
 		free_config(config);
 	}
+
+	TEST(TypeByName, NameView) {
+		system_config *config = parse_config(exampleConfigPath);
+		ASSERT_NE(config, nullptr);
+		const char *row = "medium 1 0 396 4 16000 64000";
+		EXPECT_EQ(config->type_by_name(row, 6), &config->types[1]);
+		EXPECT_THROW(config->type_by_name(row, 5), std::invalid_argument);
+		EXPECT_THROW(config->type_by_name(row, 7), std::invalid_argument);
+		free_config(config);
+	}
+
+	TEST(StartOfType, EveryType) {
+		system_config *config = parse_config(defaultConfigPath);
+		ASSERT_NE(config, nullptr);
+		size_t offset = 0;
+		for(auto t = 0; t < config->num_types; ++t) {
+			auto *type = &config->types[t];
+			auto *start = config->start_of_type(type);
+			EXPECT_EQ(start, &config->servers[offset]) << "With: t=" << t << std::endl;
+			EXPECT_EQ(start->type, type) << "With: t=" << t << std::endl;
+			EXPECT_EQ(start->id, 0) << "With: t=" << t << std::endl;
+			offset += type->limit;
+		}
+		free_config(config);
+	}
+
+	TEST(StartOfType, ForeignType) {
+		system_config *config = parse_config(exampleConfigPath);
+		system_config *other = parse_config(exampleConfigPath);
+		ASSERT_NE(config, nullptr);
+		ASSERT_NE(other, nullptr);
+		EXPECT_THROW(config->start_of_type(&other->types[0]), std::invalid_argument);
+		free_config(other);
+		free_config(config);
+	}
+
+	TEST(UpdateServerFromString, ValidRow) {
+		system_config *config = parse_config(exampleConfigPath);
+		ASSERT_NE(config, nullptr);
+		server_info *server = config->update_server_from_string("large 2 3 -1 6 29900 253200");
+		ASSERT_EQ(server, &config->start_of_type(config->type_by_name("large"))[2]);
+		EXPECT_EQ(server->state, SS_ACTIVE);
+		EXPECT_EQ(server->avail_time, -1);
+		EXPECT_EQ(server->avail_resc, (resource_info{6, 29900, 253200}));
+		free_config(config);
+	}
+
+	TEST(UpdateServerFromString, InvalidRows) {
+		system_config *config = parse_config(exampleConfigPath);
+		ASSERT_NE(config, nullptr);
+		EXPECT_THROW(config->update_server_from_string("large 2 3 -1 6 29900"), std::runtime_error);
+		EXPECT_THROW(config->update_server_from_string("huge 0 3 -1 6 29900 253200"), std::invalid_argument);
+		EXPECT_THROW(config->update_server_from_string("large 5 3 -1 6 29900 253200"), std::out_of_range);
+		EXPECT_THROW(config->update_server_from_string("large 0 9 -1 6 29900 253200"), std::out_of_range);
+		free_config(config);
+	}
+
+	// a row is checked before the next is asked for, so a bad one is never acknowledged
+	TEST(UpdateConfig, BadRowNotAcknowledged) {
+		system_config *config = parse_config(exampleConfigPath);
+		ASSERT_NE(config, nullptr);
+		ClientPair pair(true);
+
+		const char *responses = "DATA\nlarge 2 3 -1 6 29900 253200\nhuge 0 3 -1 6 29900 253200\n";
+		pair.serverWrite(responses);
+		EXPECT_THROW(config->update(pair.client), std::invalid_argument);
+		EXPECT_EQ(config->start_of_type(config->type_by_name("large"))[2].state, SS_ACTIVE);
+
+		EXPECT_EQ(pair.serverRead(), "RESC All\nOK\nOK\n");
+
+		free_config(config);
+	}
+
+	TEST(UpdateJobs, BadRowNotAcknowledged) {
+		system_config *config = parse_config(exampleConfigPath);
+		ASSERT_NE(config, nullptr);
+		ClientPair pair(true);
+
+		server_info *small = config->start_of_type(config->type_by_name("small"));
+		small[0].state = SS_ACTIVE;
+
+		const char *responses = "DATA\n2 2 396 154 2 2100 2800\n5 1 -1 80\n";
+		pair.serverWrite(responses);
+		EXPECT_THROW(config->update_jobs(pair.client, { &small[0] }), std::runtime_error);
+
+		EXPECT_EQ(pair.serverRead(), "LSTJ small 0\nOK\nOK\n");
+
+		free_config(config);
+	}
+
+	TEST(UpdateJobs, BatchSkipsServersWithoutJobs) {
+		system_config *config = parse_config(exampleConfigPath);
+		ASSERT_NE(config, nullptr);
+		ClientPair pair(true);
+
+		server_info *small = config->start_of_type(config->type_by_name("small"));
+		small[0].state = SS_ACTIVE;
+		small[1].state = SS_IDLE;
+		small[1].jobs = static_cast<schd_info*>(calloc(1, sizeof(schd_info)));
+		small[1].num_jobs = 1;
+
+		// newline framing lets the whole conversation be queued up front
+		const char *responses = "DATA\n2 2 396 154 2 2100 2800\n5 1 -1 80 1 500 600\n.\n";
+		pair.serverWrite(responses);
+
+		config->update_jobs(pair.client, { &small[0], &small[1], &small[2] });
+
+		ASSERT_EQ(small[0].num_jobs, 2);
+		EXPECT_EQ(small[0].jobs[0].job_id, 2);
+		EXPECT_EQ(small[0].jobs[0].start_time, 396);
+		EXPECT_EQ(small[0].jobs[1].job_id, 5);
+		EXPECT_EQ(small[0].jobs[1].start_time, -1);
+		EXPECT_EQ(small[1].num_jobs, 0);
+		EXPECT_EQ(small[1].jobs, nullptr);
+		EXPECT_EQ(small[2].num_jobs, 0);
+
+		EXPECT_EQ(pair.serverRead(), "LSTJ small 0\nOK\nOK\nOK\n");
+
+		free_config(config);
+	}
+
+	TEST(LocalModel, AssignBootsInactiveServer) {
+		system_config *config = parse_config(exampleConfigPath);
+		ASSERT_NE(config, nullptr);
+		server_info *server = config->start_of_type(config->type_by_name("small"));
+		constexpr job_info job = job_info{ 100, 7, 50, resource_info{1, 1000, 2000} };
+
+		server->assign(job);
+		EXPECT_EQ(server->state, SS_BOOTING);
+		EXPECT_EQ(server->avail_time, 160);
+		EXPECT_EQ(server->avail_resc, (resource_info{1, 3000, 14000}));
+		ASSERT_EQ(server->num_jobs, 1);
+		EXPECT_EQ(server->jobs[0].job_id, 7);
+		EXPECT_EQ(server->jobs[0].start_time, 160);
+
+		server->advance(159);
+		EXPECT_EQ(server->state, SS_BOOTING);
+
+		server->advance(200);
+		EXPECT_EQ(server->state, SS_ACTIVE);
+		EXPECT_EQ(server->avail_time, -1);
+		EXPECT_EQ(server->avail_resc, (resource_info{1, 3000, 14000}));
+
+		server->advance(210);
+		EXPECT_EQ(server->state, SS_IDLE);
+		EXPECT_EQ(server->avail_time, 210);
+		EXPECT_EQ(server->avail_resc, server->type->max_resc);
+		EXPECT_EQ(server->num_jobs, 0);
+		free_config(config);
+	}
+
+	TEST(LocalModel, AdvanceStartsWaitingJobs) {
+		system_config *config = parse_config(exampleConfigPath);
+		ASSERT_NE(config, nullptr);
+		server_info *server = config->start_of_type(config->type_by_name("small"));
+		server->state = SS_IDLE;
+		server->avail_time = 0;
+
+		server->assign(job_info{ 0, 1, 100, resource_info{2, 1000, 1000} });
+		server->assign(job_info{ 10, 2, 100, resource_info{1, 1000, 1000} });
+		EXPECT_EQ(server->state, SS_ACTIVE);
+		ASSERT_EQ(server->num_jobs, 2);
+		EXPECT_EQ(server->jobs[0].start_time, 0);
+		EXPECT_EQ(server->jobs[1].start_time, -1);
+
+		// the first job finishes at 100, so the second runs from then until 200
+		server->advance(150);
+		ASSERT_EQ(server->num_jobs, 1);
+		EXPECT_EQ(server->jobs[0].job_id, 2);
+		EXPECT_EQ(server->jobs[0].start_time, 100);
+		EXPECT_EQ(server->avail_resc, (resource_info{1, 3000, 15000}));
+
+		server->advance(200);
+		EXPECT_EQ(server->state, SS_IDLE);
+		EXPECT_EQ(server->num_jobs, 0);
+		free_config(config);
+	}
+
+	// every column must hold the same as the server_info it mirrors
+	void expectColumnsMatch(const system_config *config) {
+		for(size_t s = 0; s < config->num_servers; ++s) {
+			const server_info &server = config->servers[s];
+			EXPECT_EQ(config->columns.state[s], server.state) << s;
+			EXPECT_EQ(config->columns.avail_time[s], server.avail_time) << s;
+			EXPECT_EQ(columns_avail_resc(&config->columns, s), server.avail_resc) << s;
+			EXPECT_EQ(&config->types[config->columns.type_index[s]], server.type) << s;
+		}
+	}
+
+	TEST(ServerColumns, MirrorEveryChange) {
+		system_config *config = parse_config(configSimple2Path);
+		ASSERT_NE(config, nullptr);
+		expectColumnsMatch(config);
+
+		server_info *server = &config->servers[config->num_servers / 2];
+		job_info job{ 10, 1, 100, resource_info{1, 100, 100} };
+		server->assign(job);
+		expectColumnsMatch(config);
+		EXPECT_TRUE(columns_can_run(&config->columns, server - config->servers, &job));
+
+		config->advance(10 + static_cast<intmax_t>(server->type->bootTime) + 50);
+		EXPECT_EQ(server->state, SS_ACTIVE);
+		expectColumnsMatch(config);
+
+		ASSERT_TRUE(server->update(SS_UNAVAILABLE, 5, resource_info{0, 0, 0}));
+		expectColumnsMatch(config);
+
+		server->reset();
+		expectColumnsMatch(config);
+
+		// fields written directly are only mirrored once synced
+		server->state = SS_IDLE;
+		sync_server(server);
+		expectColumnsMatch(config);
+		free_config(config);
+	}
+
+	// the counts kept as servers change must be what counting them all would give
+	void expectCountsMatch(const system_config *config) {
+		for(size_t t = 0; t < config->num_types; ++t) {
+			const server_type *type = &config->types[t];
+			const server_info *servers = start_of_type(config, type);
+			for(int state = SS_INACTIVE; state <= SS_UNAVAILABLE; ++state) {
+				size_t expected = 0;
+				for(size_t s = 0; s < type->limit; ++s) expected += servers[s].state == state;
+				EXPECT_EQ(servers_in_state(config, type, static_cast<server_state>(state)), expected) << type->name << " in state " << state;
+			}
+		}
+		for(size_t s = 0; s < config->num_servers; ++s) {
+			const server_info &server = config->servers[s];
+			size_t waiting = 0;
+			for(size_t j = 0; j < server.num_jobs; ++j) waiting += !~server.jobs[j].start_time;
+			EXPECT_EQ(server.num_waiting, waiting) << s;
+		}
+	}
+
+	TEST(StateCounts, FollowEveryChange) {
+		system_config *config = parse_config(configSimple2Path);
+		ASSERT_NE(config, nullptr);
+		expectCountsMatch(config);
+		EXPECT_EQ(servers_in_state(config, &config->types[0], SS_INACTIVE), config->types[0].limit);
+
+		// jobs queue up on one server, so some wait, then start as the ones ahead of them finish
+		server_info *server = &config->servers[config->num_servers / 2];
+		const resource_info &max = server->type->max_resc;
+		for(uintmax_t j = 0; j < 6; ++j) {
+			server->assign(job_info{ 10 * j, j, 100 + 10 * j, resource_info{ max.cores / 2, max.memory / 2, max.disk / 2 } });
+			expectCountsMatch(config);
+		}
+		EXPECT_GT(server->num_waiting, 0u);
+
+		for(intmax_t time = 0; server->num_jobs > 0; time += 50) {
+			config->advance(time);
+			expectCountsMatch(config);
+		}
+
+		ASSERT_TRUE(server->update(SS_UNAVAILABLE, 5, resource_info{0, 0, 0}));
+		expectCountsMatch(config);
+
+		server->state = SS_BOOTING;
+		server->jobs = static_cast<schd_info*>(calloc(2, sizeof(schd_info)));
+		server->jobs[1].start_time = -1;
+		server->num_jobs = 2;
+		sync_server(server);
+		expectCountsMatch(config);
+		EXPECT_EQ(server->num_waiting, 1u);
+
+		EXPECT_NE(config->update_server_from_string("large 0 3 -1 6 29900 253200"), nullptr);
+		expectCountsMatch(config);
+		free_config(config);
+	}
 }
\ No newline at end of file
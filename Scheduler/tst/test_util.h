@@ -0,0 +1,63 @@
+#pragma once
+#ifndef test_util_h_
+#define test_util_h_
+
+#include "../src/socket_client.h"
+#include "../src/stage_three.h"
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+// checks and fixtures shared between the test files
+namespace {
+
+	// the skyline's prediction for the job against the step-by-step simulation it has to match
+	void expectSameAsScan(server_info &server, const job_info &job, intmax_t from) {
+		availability_prediction expected = predict_availability_scan(&server, &job, from);
+		availability_prediction actual = predict_availability(&server, &job, from);
+		EXPECT_EQ(actual.avail, expected.avail) << "job " << job.id << " from " << from;
+		EXPECT_EQ(actual.delayed, expected.delayed) << "job " << job.id << " from " << from;
+		EXPECT_EQ(actual.util, expected.util) << "job " << job.id << " from " << from;
+	}
+
+	// everything written to a temporary file
+	std::string contents(FILE *file) {
+		std::string text;
+		rewind(file);
+		for(int c = fgetc(file); c != EOF; c = fgetc(file)) text.push_back(static_cast<char>(c));
+		return text;
+	}
+
+	// a client reading from one end of a socketpair, with the other end available to play the server
+	struct ClientPair {
+		socket_client *client;
+		int server_fd;
+
+		ClientPair(bool newline) {
+			int fds[2];
+			socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+			client = client_from_fd(fds[0], newline);
+			server_fd = fds[1];
+		}
+
+		~ClientPair() {
+			client_free(client);
+			close(server_fd);
+		}
+
+		void serverWrite(const char *data) {
+			write(server_fd, data, strlen(data));
+		}
+
+		std::string serverRead() {
+			char buffer[256];
+			ssize_t length = read(server_fd, buffer, sizeof buffer);
+			return std::string(buffer, length > 0 ? length : 0);
+		}
+	};
+}
+
+#endif
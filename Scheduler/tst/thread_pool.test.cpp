@@ -0,0 +1,60 @@
+#include "../src/thread_pool.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <vector>
+
+namespace {
+	struct Counts {
+		std::vector<std::atomic<int>> runs;
+		explicit Counts(size_t tasks) : runs(tasks) {
+			for(auto &r : runs) r = 0;
+		}
+	};
+
+	void count(void *context, size_t i) {
+		++static_cast<Counts*>(context)->runs[i];
+	}
+
+	TEST(ThreadPool, RunsEveryTaskOnce) {
+		for(size_t threads : { 1, 2, 3, 8 }) {
+			thread_pool *pool = thread_pool_create(threads);
+			ASSERT_NE(pool, nullptr);
+			EXPECT_EQ(thread_pool_threads(pool), threads);
+
+			for(size_t tasks : { 0, 1, 2, 7, 100, 1000 }) {
+				Counts counts(tasks);
+				thread_pool_run(pool, tasks, count, &counts);
+				for(size_t i = 0; i < tasks; ++i) EXPECT_EQ(counts.runs[i], 1) << threads << " threads, task " << i << " of " << tasks;
+			}
+			thread_pool_free(pool);
+		}
+	}
+
+	// the same workers take batch after batch, and each batch is done before the next one is handed out
+	TEST(ThreadPool, ReusedAcrossBatches) {
+		thread_pool *pool = thread_pool_create(4);
+		ASSERT_NE(pool, nullptr);
+
+		std::vector<size_t> written(64);
+		for(size_t batch = 1; batch <= 2000; ++batch) {
+			struct Batch {
+				std::vector<size_t> *written;
+				size_t value;
+			} context{ &written, batch };
+
+			thread_pool_run(pool, written.size(), [](void *context, size_t i) {
+				auto &b = *static_cast<Batch*>(context);
+				(*b.written)[i] = b.value;
+			}, &context);
+
+			for(size_t i = 0; i < written.size(); ++i) ASSERT_EQ(written[i], batch) << "task " << i;
+		}
+		thread_pool_free(pool);
+	}
+
+	TEST(ThreadPool, FreedWithoutRunning) {
+		thread_pool *pool = thread_pool_create(3);
+		ASSERT_NE(pool, nullptr);
+		thread_pool_free(pool);
+	}
+}
\ No newline at end of file